@@ -4,6 +4,8 @@
 #include "Memory.h"
 #include "File.h"
 
+#include <SphereMapping.h>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -49,7 +51,7 @@ void SphereCoordToTexturePos(float phi, float theta, int width, int height, int&
 
 void GenerateEquirectangularCheckerboard(const int resolutionX, const int resolutionY)
 {
-	MemoryArena arena{};
+	MemoryArena arena{ "GenerateEquirectangularCheckerboard" };
 	uint8_t* pixels = NewArray(arena, uint8_t, resolutionX * resolutionY * 3);
 
 	for (int px = 0; px < resolutionX; px++)
@@ -254,18 +256,25 @@ void AverageRect(float minX, float minY, float maxX, float maxY, int sourceWidth
 }
 
 // for a pixel on the texture, calculate how much area on the sphere it represents
-float calcSphereArea(int x, int y, int sourceWidth, int sourceHeight)
+// only depends on the row, so compute it once per row for the whole level
+float* calcSphereAreaRows(MemoryArena& arena, int sourceWidth, int sourceHeight)
 {
-	float theta;
-	float phi;
-	TexturePosToSphereCoord(x, y, sourceWidth, sourceHeight, theta, phi);
-
-	float circumferenceRatio = std::abs(std::cos(phi * 2.f)); // *2 why?
-
-	float verticalPixels = 1.f;
-	float horizontalPixels = std::min(1.f / circumferenceRatio, static_cast<float>(sourceWidth));
+	float* angles = NewArray(arena, float, sourceHeight);
+	for (int y = 0; y < sourceHeight; y++)
+	{
+		float theta;
+		float phi;
+		TexturePosToSphereCoord(0, y, sourceWidth, sourceHeight, theta, phi);
+		angles[y] = phi * 2.f; // *2 why?
+	}
 
-	return verticalPixels * circumferenceRatio;
+	float* areas = NewArray(arena, float, sourceHeight);
+	SinCosArray(angles, sourceHeight, nullptr, areas);
+	for (int y = 0; y < sourceHeight; y++)
+	{
+		areas[y] = std::abs(areas[y]);
+	}
+	return areas;
 }
 
 uint8_t* GenerateEquirectMipLevel(MemoryArena& arena, uint8_t* source, int sourceWidth, int sourceHeight, int channelCount, MipGenerationType type)
@@ -318,6 +327,7 @@ uint8_t* GenerateEquirectMipLevel(MemoryArena& arena, uint8_t* source, int sourc
 
 	if (type == MipGenerationType::Box)
 	{
+		const float* rowAreas = calcSphereAreaRows(arena, sourceWidth, sourceHeight);
 		for (int y = 0; y < sourceHeight; y += 2)
 		{
 			for (int x = 0; x < sourceWidth; x += 2)
@@ -327,10 +337,10 @@ uint8_t* GenerateEquirectMipLevel(MemoryArena& arena, uint8_t* source, int sourc
 				int sourceIndex2 = (y * sourceWidth + x + 1) * channelCount;
 				int sourceIndex3 = ((y + 1) * sourceWidth + x + 1) * channelCount;
 
-				float sourceArea0 = calcSphereArea(x, y, sourceWidth, sourceHeight);
-				float sourceArea1 = calcSphereArea(x, y + 1, sourceWidth, sourceHeight);
-				float sourceArea2 = calcSphereArea(x + 1, y, sourceWidth, sourceHeight);
-				float sourceArea3 = calcSphereArea(x + 1, y + 1, sourceWidth, sourceHeight);
+				float sourceArea0 = rowAreas[y];
+				float sourceArea1 = rowAreas[y + 1];
+				float sourceArea2 = rowAreas[y];
+				float sourceArea3 = rowAreas[y + 1];
 				float totalArea = sourceArea0 + sourceArea1 + sourceArea2 + sourceArea3;
 
 				int targetIndex = ((y / 2) * targetWidth + (x / 2)) * channelCount;
@@ -362,7 +372,7 @@ void WriteImage(std::string& pathPrefix, std::string& shapePrefix, std::string&
 
 void GenerateMipMap(const char* sourcePath, const char* targetPathPrefix, MipGenerationType type, ImageShape shape)
 {
-	MemoryArena mipMemory{};
+	MemoryArena mipMemory{ "GenerateMipMap" };
 
 	int width;
 	int height;
@@ -445,7 +455,7 @@ void CopyImageTo(const std::string& sourcePath, size_t sourceWidth, int required
 void AssembleCubeMap(const std::string pathBase, int sourceWidth, int sourceHeight)
 {
 	int requiredChannelCount = 4;
-	MemoryArena workingMemory{};
+	MemoryArena workingMemory{ "AssembleCubeMap" };
 	uint8_t* outputImage = NewArray(workingMemory, uint8_t, (sourceWidth * 4) * (sourceHeight * 3) * requiredChannelCount);
 
 	auto measureStart = std::chrono::high_resolution_clock::now();
@@ -470,6 +480,8 @@ void AssembleCubeMap(const std::string pathBase, int sourceWidth, int sourceHeig
 
 int main(int argc, char* argv[])
 {
+	ArenaRegistry::PrintReportAtExit();
+
 	//GenerateEquirectangularCheckerboard(1024, 512);
 	//GenerateMipMap("textures/Wolfstein.jpg", "textures/eq-box/out-eq-box-", MipGenerationType::Box, ImageShape::Equirect);
 	//GenerateMipMap("textures/Wolfstein.jpg", "textures/box/out-box-", MipGenerationType::Box, ImageShape::Regular);
@@ -1,17 +1,91 @@
 #include "Memory.h"
 #include <assert.h>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include "Windows.h"
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
-MemoryArena::MemoryArena(size_t capacity) :
-	capacity(capacity),
-	base(static_cast<uint8_t*>(VirtualAlloc(NULL, capacity, MEM_RESERVE, PAGE_READWRITE)))
+// Thin wrappers around the OS virtual memory functions, so the arena also works in the Linux tools.
+static uint8_t* ReservePages(size_t size)
+{
+#ifdef _WIN32
+	return static_cast<uint8_t*>(VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE));
+#else
+	void* result = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return result == MAP_FAILED ? nullptr : static_cast<uint8_t*>(result);
+#endif
+}
+
+static bool CommitPages(uint8_t* address, size_t size)
+{
+#ifdef _WIN32
+	return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static bool DecommitPages(uint8_t* address, size_t size)
+{
+#ifdef _WIN32
+	return VirtualFree(address, size, MEM_DECOMMIT);
+#else
+	return madvise(address, size, MADV_DONTNEED) == 0 && mprotect(address, size, PROT_NONE) == 0;
+#endif
+}
+
+static bool ReleasePages(uint8_t* address, size_t size)
 {
+#ifdef _WIN32
+	return VirtualFree(address, 0, MEM_RELEASE);
+#else
+	return munmap(address, size) == 0;
+#endif
+}
+
+static size_t GetAllocationGranularity()
+{
+#ifdef _WIN32
 	SYSTEM_INFO info;
 	GetSystemInfo(&info);
-	allocationGranularity = info.dwAllocationGranularity;
+	return info.dwAllocationGranularity;
+#else
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+static void ReportArenaError(const char* message)
+{
+#ifdef _WIN32
+	OutputDebugStringA(message);
+#else
+	std::cerr << message << std::endl;
+#endif
+}
+
+MemoryArena::MemoryArena(size_t capacity) :
+	capacity(capacity),
+	base(ReservePages(capacity))
+{
+	assert(base != nullptr);
+	allocationGranularity = GetAllocationGranularity();
+	stats.instanceCount = 1;
+}
+
+MemoryArena::MemoryArena(const char* name, size_t capacity) : MemoryArena(capacity)
+{
+	this->name = name;
+	ArenaRegistry::Register(this);
 }
 
 inline size_t Align(size_t value, size_t alignment)
@@ -19,10 +93,17 @@ inline size_t Align(size_t value, size_t alignment)
 	return (value + alignment - 1) & ~(alignment - 1);
 }
 
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
 void* MemoryArena::Allocate(size_t size)
 {
 	assert(size >= 0);
 	const size_t newUsed = used + size;
+	const size_t previousCommitted = committed;
 	assert(newUsed <= capacity);
 
 	if (newUsed > committed)
@@ -30,12 +111,29 @@ void* MemoryArena::Allocate(size_t size)
 		const size_t required = newUsed - committed;
 		const size_t allocationSize = Align(required, allocationGranularity);
 
-		VirtualAlloc(base + committed, allocationSize, MEM_COMMIT, PAGE_READWRITE);
+		auto commitStart = std::chrono::high_resolution_clock::now();
+		if (!CommitPages(base + committed, allocationSize))
+		{
+			// Out of memory, callers have no way to handle a null allocation
+			ReportArenaError("Failed to commit Memory Arena pages!!");
+			std::abort();
+		}
 		committed += allocationSize;
+
+		stats.commitMilliseconds += MillisecondsSince(commitStart);
+		stats.commitCount++;
+		stats.peakCommitted = std::max(stats.peakCommitted, committed);
 	}
 
 	uint8_t* result = base + used;
 	used = newUsed;
+	stats.peakUsed = std::max(stats.peakUsed, used);
+
+	// Publish on the slow path only, committing already costs a syscall
+	if (committed != previousCommitted && name != nullptr)
+	{
+		ArenaRegistry::Publish(this);
+	}
 	return result;
 }
 
@@ -43,19 +141,159 @@ void MemoryArena::Reset(bool freePages)
 {
 	if (freePages)
 	{
-		if (!VirtualFree(base, committed, MEM_DECOMMIT))
+		auto decommitStart = std::chrono::high_resolution_clock::now();
+		if (!DecommitPages(base, committed))
 		{
-			OutputDebugString(L"Failed to reset Memory Arena!!");
+			ReportArenaError("Failed to reset Memory Arena!!");
 		}
 		committed = 0;
+
+		stats.decommitMilliseconds += MillisecondsSince(decommitStart);
+		stats.decommitCount++;
 	}
 	used = 0;
+
+	if (name != nullptr)
+	{
+		ArenaRegistry::Publish(this);
+	}
 }
 
 MemoryArena::~MemoryArena()
 {
-	if (!VirtualFree(base, 0, MEM_RELEASE))
+	auto releaseStart = std::chrono::high_resolution_clock::now();
+	if (!ReleasePages(base, capacity))
+	{
+		ReportArenaError("Failed to free Memory Arena!!");
+	}
+	if (committed > 0)
+	{
+		stats.decommitMilliseconds += MillisecondsSince(releaseStart);
+		stats.decommitCount++;
+	}
+
+	if (name != nullptr)
 	{
-		OutputDebugString(L"Failed to free Memory Arena!!");
+		ArenaRegistry::Unregister(this);
+	}
+}
+
+namespace ArenaRegistry
+{
+	struct RegistryData
+	{
+		std::mutex mutex;
+		std::map<std::string, MemoryArenaStats> finished;
+		// Live arenas with the stats they last published, the arena fields themselves belong to the owning thread.
+		std::vector<std::pair<MemoryArena*, MemoryArenaStats>> live;
+	};
+
+	// Function-local so arenas in static storage can register before main runs.
+	static RegistryData& GetData()
+	{
+		static RegistryData data{};
+		return data;
+	}
+
+	static void Merge(MemoryArenaStats& target, const MemoryArenaStats& source)
+	{
+		target.instanceCount += source.instanceCount;
+		target.peakUsed = std::max(target.peakUsed, source.peakUsed);
+		target.peakCommitted = std::max(target.peakCommitted, source.peakCommitted);
+		target.commitCount += source.commitCount;
+		target.decommitCount += source.decommitCount;
+		target.commitMilliseconds += source.commitMilliseconds;
+		target.decommitMilliseconds += source.decommitMilliseconds;
+	}
+
+	// Copies the arena fields, so it must run on the thread that owns the arena.
+	static MemoryArenaStats PublishedStats(const MemoryArena* arena)
+	{
+		MemoryArenaStats result = arena->stats;
+		result.currentUsed = arena->used;
+		result.currentCommitted = arena->committed;
+		return result;
+	}
+
+	void Register(MemoryArena* arena)
+	{
+		const MemoryArenaStats published = PublishedStats(arena);
+
+		RegistryData& data = GetData();
+		std::lock_guard lock{ data.mutex };
+		data.live.emplace_back(arena, published);
+	}
+
+	void Publish(MemoryArena* arena)
+	{
+		const MemoryArenaStats published = PublishedStats(arena);
+
+		RegistryData& data = GetData();
+		std::lock_guard lock{ data.mutex };
+		for (auto& [liveArena, liveStats] : data.live)
+		{
+			if (liveArena == arena)
+			{
+				liveStats = published;
+				break;
+			}
+		}
+	}
+
+	void Unregister(MemoryArena* arena)
+	{
+		RegistryData& data = GetData();
+		std::lock_guard lock{ data.mutex };
+		Merge(data.finished[arena->name], arena->stats);
+		data.live.erase(std::remove_if(data.live.begin(), data.live.end(),
+			[arena](const auto& entry) { return entry.first == arena; }), data.live.end());
+	}
+
+	// Only reads values published under the lock, never the fields of arenas that may be allocating on other threads.
+	std::vector<std::pair<std::string, MemoryArenaStats>> Snapshot()
+	{
+		RegistryData& data = GetData();
+		std::lock_guard lock{ data.mutex };
+
+		std::map<std::string, MemoryArenaStats> combined = data.finished;
+		for (const auto& [arena, published] : data.live)
+		{
+			MemoryArenaStats& target = combined[arena->name];
+			Merge(target, published);
+			target.currentUsed += published.currentUsed;
+			target.currentCommitted += published.currentCommitted;
+		}
+		return { combined.begin(), combined.end() };
+	}
+
+	void PrintReport(std::ostream& out)
+	{
+		auto toMiB = [](size_t bytes) { return static_cast<double>(bytes) / (1024. * 1024.); };
+
+		out << "Memory arenas (MiB, peaks per instance):" << std::endl;
+		out << std::fixed << std::setprecision(2);
+		for (const auto& [name, stats] : Snapshot())
+		{
+			out << "  " << name
+				<< ": instances " << stats.instanceCount
+				<< ", used " << toMiB(stats.currentUsed) << " (peak " << toMiB(stats.peakUsed) << ")"
+				<< ", committed " << toMiB(stats.currentCommitted) << " (peak " << toMiB(stats.peakCommitted) << ")"
+				<< ", commits " << stats.commitCount << " in " << stats.commitMilliseconds << "ms"
+				<< ", decommits " << stats.decommitCount << " in " << stats.decommitMilliseconds << "ms"
+				<< std::endl;
+		}
+		out << std::defaultfloat;
+	}
+
+	void PrintReportAtExit()
+	{
+		static bool registered = false;
+		if (registered) return;
+		registered = true;
+
+		// Construct the registry before registering the handler, so it is destroyed after the report ran. Runs that
+		// exit before any arena was created print nothing.
+		GetData();
+		std::atexit([] { if (!Snapshot().empty()) PrintReport(std::cout); });
 	}
 }
@@ -4,9 +4,26 @@
 #include <iterator>
 #include <cstddef>
 #include <assert.h>
+#include <iostream>
+#include <string>
+#include <vector>
 
 inline size_t Align(size_t value, size_t alignment);
 
+// Memory usage of a single arena, or of all arenas sharing a name when reported by the ArenaRegistry.
+struct MemoryArenaStats
+{
+    size_t instanceCount = 0;
+    size_t currentUsed = 0;
+    size_t currentCommitted = 0;
+    size_t peakUsed = 0;
+    size_t peakCommitted = 0;
+    size_t commitCount = 0;
+    size_t decommitCount = 0;
+    double commitMilliseconds = 0.;
+    double decommitMilliseconds = 0.;
+};
+
 // Custom allocation, still figuring out how to use this best.
 // WARNING: Anything allocated inside a memory arena won't get it's desctructor called (intentionally).
 // Don't store std::string or similar in here!
@@ -20,7 +37,12 @@ public:
     size_t used = 0;
     size_t committed = 0;
 
+    // Arenas with a name show up in the ArenaRegistry report, arenas with the same name are grouped together.
+    const char* name = nullptr;
+    MemoryArenaStats stats{};
+
     MemoryArena(size_t capacity = 1024 * 1024 * 1024);
+    MemoryArena(const char* name, size_t capacity = 1024 * 1024 * 1024);
     void* Allocate(size_t size);
     void Reset(bool freePages = false);
 
@@ -61,6 +83,21 @@ public:
     Iterator end() { return Iterator(reinterpret_cast<T*>(base + used)); }
 };
 
+// Keeps track of named arenas so we can compare how much memory each part of the tools needs.
+// Peak values are per arena instance, current values are summed over all live instances with that name.
+// Live arenas are reported as of their last commit or reset, finished ones exactly.
+namespace ArenaRegistry
+{
+    void Register(MemoryArena* arena);
+    // Called by the owning thread, the registry never reads the fields of a live arena itself.
+    void Publish(MemoryArena* arena);
+    void Unregister(MemoryArena* arena);
+
+    std::vector<std::pair<std::string, MemoryArenaStats>> Snapshot();
+    void PrintReport(std::ostream& out = std::cout);
+    void PrintReportAtExit();
+}
+
 #define NewObject(arena, type, ...) new((arena).Allocate(sizeof(type))) type(__VA_ARGS__)
 #define NewArray(arena, type, count, ...) new((arena).Allocate(sizeof(type) * (count))) type[count](__VA_ARGS__)
 
@@ -0,0 +1,365 @@
+#include "../src/ImageMetrics.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Replaces comparison/compare_multi.py: compares images against a reference and prints the same LaTeX table, or a CSV
+// row per comparison. With a list of pairs it compares thousands of images, one pair per thread.
+
+enum class OutputFormat
+{
+    Latex,
+    Csv,
+};
+
+struct NamedImage
+{
+    std::string name;
+    std::string path;
+};
+
+struct CompareOptions
+{
+    std::string referencePath;
+    std::vector<NamedImage> images;
+    std::string pairsPath;
+    OutputFormat format = OutputFormat::Latex;
+    MetricSettings settings{};
+    bool showTiming = false;
+
+    // Per-pixel maps and region statistics, written next to this prefix if set
+    std::string mapsPrefix;
+    MetricMaps maps{};
+};
+
+void ShowHelp()
+{
+    std::cout << "CompareImages --reference|-r <png> (--image|-i <name> <png>)... [--format|-f latex|csv]" << std::endl;
+    std::cout << "CompareImages --pairs|-p <file with one \"<reference png> <png>\" per line> (always csv)" << std::endl;
+    std::cout << "              [--color luma|rgb] [--sigma <gaussian sigma>] [--no-ms-ssim] [--threads|-j <count, 0 = all>] [--time]" << std::endl;
+    std::cout << "              [--maps <output prefix> [--bands <latitude band count>] [--tile-size <pixels, 0 = no tiles>]]" << std::endl;
+    std::cout << "--maps writes <prefix><name>_ssim.pfm, <prefix><name>_error.pfm and <prefix><name>_regions.csv per image, not with --pairs." << std::endl;
+    std::cout << "Luma compares the 8 bit grayscale of the images like compare_multi.py, rgb averages SSIM over the channels." << std::endl;
+}
+
+bool ParseCommandLine(CompareOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--reference" || arg == "-r")
+        {
+            options.referencePath = getNextArg();
+        }
+        else if (arg == "--image" || arg == "-i")
+        {
+            NamedImage image;
+            image.name = getNextArg();
+            image.path = getNextArg();
+            options.images.push_back(image);
+        }
+        else if (arg == "--pairs" || arg == "-p")
+        {
+            options.pairsPath = getNextArg();
+        }
+        else if (arg == "--format" || arg == "-f")
+        {
+            const std::string format = getNextArg();
+            if (format == "latex") options.format = OutputFormat::Latex;
+            else if (format == "csv") options.format = OutputFormat::Csv;
+            else throw std::invalid_argument("Unknown format: " + format);
+        }
+        else if (arg == "--color")
+        {
+            const std::string color = getNextArg();
+            if (color == "luma") options.settings.color = MetricColor::Luma;
+            else if (color == "rgb") options.settings.color = MetricColor::Channels;
+            else throw std::invalid_argument("Unknown color mode: " + color);
+        }
+        else if (arg == "--sigma")
+        {
+            options.settings.sigma = std::stof(getNextArg());
+        }
+        else if (arg == "--no-ms-ssim")
+        {
+            options.settings.multiScale = false;
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.settings.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--maps")
+        {
+            options.mapsPrefix = getNextArg();
+        }
+        else if (arg == "--bands")
+        {
+            options.maps.latitudeBandCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--tile-size")
+        {
+            options.maps.tileSize = std::stoi(getNextArg());
+        }
+        else if (arg == "--time")
+        {
+            options.showTiming = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    const bool tableMode = !options.referencePath.empty() && !options.images.empty();
+    if (tableMode == !options.pairsPath.empty())
+    {
+        std::cout << "Either a reference with images or a pairs file is required" << std::endl;
+        ShowHelp();
+        return false;
+    }
+    if (!options.mapsPrefix.empty() && !tableMode)
+    {
+        std::cout << "Maps can only be written for a reference with images" << std::endl;
+        return false;
+    }
+    if (!options.mapsPrefix.empty())
+    {
+        options.settings.maps = &options.maps;
+    }
+    return true;
+}
+
+// Same text as str(round(value, 4)) in Python: at most 4 decimals, trailing zeros dropped but one kept.
+std::string FormatRounded(double value)
+{
+    if (std::isinf(value)) return value > 0. ? "inf" : "-inf";
+    if (std::isnan(value)) return "nan";
+
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.4f", value);
+    std::string result = text;
+    while (result.size() > 2 && result.back() == '0' && result[result.size() - 2] != '.') result.pop_back();
+    if (result == "-0.0") result = "0.0";
+    return result;
+}
+
+std::string FormatCsv(double value)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+}
+
+// Loads an image with 3 channels, throws with stb's reason on failure.
+struct LoadedImage
+{
+    MetricImage image{};
+
+    explicit LoadedImage(const std::string& path)
+    {
+        image.channelCount = 3;
+        image.pixels = stbi_load(path.c_str(), &image.width, &image.height, nullptr, 3);
+        if (image.pixels == nullptr)
+        {
+            throw std::runtime_error("Failed to load " + path + ": " + stbi_failure_reason());
+        }
+    }
+
+    ~LoadedImage() { stbi_image_free(const_cast<uint8_t*>(image.pixels)); }
+
+    LoadedImage(const LoadedImage&) = delete;
+    LoadedImage& operator=(const LoadedImage&) = delete;
+};
+
+std::vector<NamedImage> ReadPairs(const std::string& path, std::vector<std::string>& outReferencePaths)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    std::vector<NamedImage> pairs;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+
+        std::istringstream values(line);
+        std::string referencePath;
+        NamedImage image;
+        if (!(values >> referencePath)) continue;
+        if (!(values >> image.path))
+        {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected a reference and an image path");
+        }
+        image.name = image.path;
+        outReferencePaths.push_back(referencePath);
+        pairs.push_back(image);
+    }
+    return pairs;
+}
+
+void WriteMaps(const std::string& pathBase, const MetricMaps& maps)
+{
+    bool written = WriteRegionCsv(pathBase + "_regions.csv", maps);
+    if (maps.ssimValues != nullptr) written &= WriteFloatImage(pathBase + "_ssim.pfm", maps.width, maps.height, maps.ssimValues);
+    if (maps.errorValues != nullptr) written &= WriteFloatImage(pathBase + "_error.pfm", maps.width, maps.height, maps.errorValues);
+    if (!written)
+    {
+        throw std::runtime_error("Failed to write the maps of " + pathBase);
+    }
+}
+
+void PrintLatexTable(const std::vector<NamedImage>& images, const std::vector<ImageMetrics>& results, bool multiScale)
+{
+    std::cout << " &";
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        std::cout << " " << images[i].name << (i + 1 < images.size() ? " &" : "");
+    }
+    std::cout << " \\\\" << std::endl;
+    std::cout << "\\midrule" << std::endl;
+
+    auto printRow = [&](const char* name, double ImageMetrics::*value) {
+        std::cout << name;
+        for (const ImageMetrics& metrics : results) std::cout << " & " << FormatRounded(metrics.*value);
+        std::cout << " \\\\" << std::endl;
+    };
+    printRow("SSIM", &ImageMetrics::ssim);
+    if (multiScale) printRow("MS-SSIM", &ImageMetrics::msSsim);
+    printRow("MSE", &ImageMetrics::mse);
+    printRow("PSNR", &ImageMetrics::psnr);
+}
+
+int main(int argc, char* argv[])
+{
+    CompareOptions options{};
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    auto measureStart = std::chrono::high_resolution_clock::now();
+    bool failed = false;
+    try
+    {
+        if (options.pairsPath.empty())
+        {
+            // A few large images, every comparison uses all threads
+            MemoryArena arena{ "CompareImages" };
+            const LoadedImage reference(options.referencePath);
+            std::vector<ImageMetrics> results;
+            for (const NamedImage& named : options.images)
+            {
+                const LoadedImage image(named.path);
+                results.push_back(CompareImages(arena, reference.image, image.image, options.settings));
+                if (!options.mapsPrefix.empty())
+                {
+                    WriteMaps(options.mapsPrefix + named.name, options.maps);
+                }
+                arena.Reset();
+            }
+
+            if (options.format == OutputFormat::Latex)
+            {
+                PrintLatexTable(options.images, results, options.settings.multiScale);
+            }
+            else
+            {
+                std::cout << "image,ssim,ms_ssim,mse,psnr" << std::endl;
+                for (size_t i = 0; i < results.size(); i++)
+                {
+                    std::cout << options.images[i].name << "," << FormatCsv(results[i].ssim) << "," << FormatCsv(results[i].msSsim) << ","
+                              << FormatCsv(results[i].mse) << "," << FormatCsv(results[i].psnr) << std::endl;
+                }
+            }
+        }
+        else
+        {
+            // Many pairs, every thread compares whole pairs on its own
+            std::vector<std::string> referencePaths;
+            const std::vector<NamedImage> pairs = ReadPairs(options.pairsPath, referencePaths);
+            std::vector<ImageMetrics> results(pairs.size());
+            std::vector<std::string> errors(pairs.size());
+
+            MetricSettings pairSettings = options.settings;
+            pairSettings.threadCount = 1;
+            pairSettings.statistics = nullptr;
+            RunTiles(pairs.size(), options.settings.threadCount, [&](size_t pair, int) {
+                thread_local MemoryArena arena{ "CompareImages" };
+                try
+                {
+                    const LoadedImage reference(referencePaths[pair]);
+                    const LoadedImage image(pairs[pair].path);
+                    results[pair] = CompareImages(arena, reference.image, image.image, pairSettings);
+                }
+                catch (const std::exception& ex)
+                {
+                    errors[pair] = ex.what();
+                }
+                arena.Reset();
+            });
+
+            std::cout << "reference,image,ssim,ms_ssim,mse,psnr" << std::endl;
+            for (size_t pair = 0; pair < pairs.size(); pair++)
+            {
+                if (!errors[pair].empty())
+                {
+                    std::cerr << errors[pair] << std::endl;
+                    failed = true;
+                    continue;
+                }
+                std::cout << referencePaths[pair] << "," << pairs[pair].path << "," << FormatCsv(results[pair].ssim) << "," << FormatCsv(results[pair].msSsim) << ","
+                          << FormatCsv(results[pair].mse) << "," << FormatCsv(results[pair].psnr) << std::endl;
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (options.showTiming)
+    {
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        auto measureDuration = std::chrono::duration_cast<std::chrono::milliseconds>(measureEnd - measureStart);
+        std::cerr << "Comparison finished in: " << measureDuration.count() << "ms" << std::endl;
+    }
+    return failed ? 1 : 0;
+}
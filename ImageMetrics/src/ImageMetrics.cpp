@@ -0,0 +1,539 @@
+#include "ImageMetrics.h"
+
+#include <SimdMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Output rows per tile of a pass, the unit of work stealing.
+constexpr int MetricTileRows = 32;
+
+// Standard SSIM constants (Wang et al. 2004), relative to the data range.
+constexpr float SsimK1 = 0.01f;
+constexpr float SsimK2 = 0.03f;
+
+// Weights of the MS-SSIM scales from full resolution down (Wang et al. 2003).
+constexpr int MaxScaleCount = 5;
+constexpr double ScaleWeights[MaxScaleCount] = { 0.0448, 0.2856, 0.3001, 0.2363, 0.1333 };
+
+// One channel as floats, centered around 0 (value - dataRange / 2). The shift doesn't change variances and covariances
+// but keeps the squares small, so subtracting the squared mean loses fewer bits in float.
+// Rows are followed by padding, so full vectors can be read past the end of the last row.
+struct Plane
+{
+    int width = 0;
+    int height = 0;
+    float* values = nullptr;
+};
+
+// Normalized 1D Gaussian, radius = int(3.5 sigma + 0.5) like scipy.ndimage with the truncate scikit-image uses for SSIM.
+constexpr int MaxWindowTaps = 63;
+struct SsimWindow
+{
+    int radius = 0;
+    float weights[MaxWindowTaps] = {};
+};
+
+struct PassSums
+{
+    double ssim = 0.;
+    double contrastStructure = 0.;
+    double squaredError = 0.;
+    size_t windowCount = 0;
+};
+
+// Per-row sums of one region column, reduced into latitude bands and tiles after the passes. Every row belongs to one
+// tile of a pass, so threads never write the same entry.
+struct RegionSums
+{
+    double ssim = 0.;
+    double squaredError = 0.;
+    double absoluteError = 0.;
+    float maxAbsoluteError = 0.f;
+    size_t windowCount = 0;
+};
+
+// Per-pixel outputs of the full resolution passes, each plane adds its values times weight to the maps.
+struct PassOutputs
+{
+    MetricMaps* maps = nullptr;
+    float weight = 1.f;
+    int regionWidth = 0;
+    int regionColumnCount = 1;
+    RegionSums* rowSums = nullptr; // height rows of regionColumnCount entries
+};
+
+static Plane AllocatePlane(MemoryArena& arena, int width, int height)
+{
+    Plane plane{ width, height };
+    const size_t count = static_cast<size_t>(width) * height + SimdMath::Width + MaxWindowTaps;
+    plane.values = NewArray(arena, float, count);
+    std::fill(plane.values, plane.values + count, 0.f);
+    return plane;
+}
+
+static Plane ExtractPlane(MemoryArena& arena, const MetricImage& image, MetricColor color, int channel, float center)
+{
+    Plane plane = AllocatePlane(arena, image.width, image.height);
+    const size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        const uint8_t* pixel = &image.pixels[i * image.channelCount];
+        uint32_t value = pixel[channel];
+        if (color == MetricColor::Luma && image.channelCount >= 3)
+        {
+            // Fixed point weights and rounding of PIL's RGB to L conversion
+            value = (pixel[0] * 19595u + pixel[1] * 38470u + pixel[2] * 7471u + 0x8000u) >> 16;
+        }
+        plane.values[i] = static_cast<float>(value) - center;
+    }
+    return plane;
+}
+
+// 2x2 box average, odd last rows and columns are dropped.
+static Plane Downsample(MemoryArena& arena, const Plane& source)
+{
+    Plane plane = AllocatePlane(arena, source.width / 2, source.height / 2);
+    for (int y = 0; y < plane.height; y++)
+    {
+        const float* top = &source.values[static_cast<size_t>(y) * 2 * source.width];
+        const float* bottom = top + source.width;
+        float* row = &plane.values[static_cast<size_t>(y) * plane.width];
+        for (int x = 0; x < plane.width; x++)
+        {
+            row[x] = (top[x * 2] + top[x * 2 + 1] + bottom[x * 2] + bottom[x * 2 + 1]) * 0.25f;
+        }
+    }
+    return plane;
+}
+
+static SsimWindow MakeWindow(float sigma)
+{
+    SsimWindow window{};
+    window.radius = static_cast<int>(3.5 * sigma + 0.5);
+    if (window.radius * 2 + 1 > MaxWindowTaps)
+    {
+        throw std::invalid_argument("SSIM sigma too large");
+    }
+
+    double sum = 0.;
+    double weights[MaxWindowTaps];
+    for (int k = -window.radius; k <= window.radius; k++)
+    {
+        weights[k + window.radius] = std::exp(-0.5 * k * k / (static_cast<double>(sigma) * sigma));
+        sum += weights[k + window.radius];
+    }
+    for (int k = 0; k <= window.radius * 2; k++)
+    {
+        window.weights[k] = static_cast<float>(weights[k] / sum);
+    }
+    return window;
+}
+
+static double SumLanes(SimdMath::FloatV value)
+{
+    float lanes[SimdMath::Width];
+    SimdMath::Store(lanes, value);
+    double sum = 0.;
+    for (float lane : lanes) sum += lane;
+    return sum;
+}
+
+static int ResolveThreadCount(int threadCount)
+{
+    if (threadCount > 0) return threadCount;
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// Adds a row of absolute errors to the error map and the region sums of the row.
+static void AccumulateErrorRow(const PassOutputs& outputs, int y, const float* errors)
+{
+    const MetricMaps& maps = *outputs.maps;
+    float* mapRow = maps.errorValues != nullptr ? &maps.errorValues[static_cast<size_t>(y) * maps.width] : nullptr;
+    RegionSums* sums = &outputs.rowSums[static_cast<size_t>(y) * outputs.regionColumnCount];
+    for (int column = 0; column < outputs.regionColumnCount; column++)
+    {
+        const int start = column * outputs.regionWidth;
+        const int end = std::min(maps.width, start + outputs.regionWidth);
+        float squaredError = 0.f, absoluteError = 0.f, maxAbsoluteError = sums[column].maxAbsoluteError;
+        for (int x = start; x < end; x++)
+        {
+            const float error = errors[x];
+            squaredError += error * error;
+            absoluteError += error;
+            maxAbsoluteError = std::max(maxAbsoluteError, error);
+            if (mapRow != nullptr) mapRow[x] += error * outputs.weight;
+        }
+        sums[column].squaredError += squaredError;
+        sums[column].absoluteError += absoluteError;
+        sums[column].maxAbsoluteError = maxAbsoluteError;
+    }
+}
+
+// Adds the SSIM values of a row, valid from firstX to endX, to the SSIM map and the region sums of the row.
+static void AccumulateSsimRow(const PassOutputs& outputs, int y, const float* values, int firstX, int endX)
+{
+    const MetricMaps& maps = *outputs.maps;
+    float* mapRow = maps.ssimValues != nullptr ? &maps.ssimValues[static_cast<size_t>(y) * maps.width] : nullptr;
+    RegionSums* sums = &outputs.rowSums[static_cast<size_t>(y) * outputs.regionColumnCount];
+    for (int column = 0; column < outputs.regionColumnCount; column++)
+    {
+        const int start = std::max(firstX, column * outputs.regionWidth);
+        const int end = std::min(endX, (column + 1) * outputs.regionWidth);
+        float ssim = 0.f;
+        for (int x = start; x < end; x++)
+        {
+            ssim += values[x];
+            if (mapRow != nullptr) mapRow[x] += values[x] * outputs.weight;
+        }
+        sums[column].ssim += ssim;
+        sums[column].windowCount += std::max(0, end - start);
+    }
+}
+
+// One traversal of a plane pair: SSIM and its contrast-structure term summed over every pixel whose window lies inside
+// the image, squared errors summed over all pixels. Each tile filters its rows horizontally into scratch rows
+// (the window radius above and below included) and then vertically, 5 filtered values per pixel.
+// With outputs the errors and SSIM values of each row also go into the maps and region sums, while the row is in cache.
+static PassSums RunSsimPass(MemoryArena& arena, const Plane& a, const Plane& b, const SsimWindow& window, float center, float c1, float c2, int threadCount, SchedulerStatistics* statistics,
+                            const PassOutputs* outputs = nullptr)
+{
+    using namespace SimdMath;
+
+    const int width = a.width;
+    const int height = a.height;
+    const int radius = window.radius;
+    const int taps = radius * 2 + 1;
+    const size_t tileCount = (height + MetricTileRows - 1) / MetricTileRows;
+    threadCount = std::min(ResolveThreadCount(threadCount), static_cast<int>(tileCount));
+
+    // Horizontal sums of x, y, x², y² and xy for the rows of one tile, per thread
+    constexpr int FilteredCount = 5;
+    const size_t scratchRows = MetricTileRows + radius * 2;
+    const size_t scratchSize = scratchRows * width + Width;
+    float* scratch = NewArray(arena, float, scratchSize * FilteredCount * threadCount);
+
+    // Error and SSIM values of one row for the outputs, per thread. Map rows can't take full vectors, the stores past
+    // the end would race with the thread writing the next row.
+    const size_t outputRowSize = static_cast<size_t>(width) + Width;
+    float* outputRows = outputs != nullptr ? NewArray(arena, float, outputRowSize * 2 * threadCount) : nullptr;
+
+    std::vector<PassSums> tileSums(tileCount);
+    RunTiles(tileCount, threadCount, [&](size_t tile, int thread) {
+        PassSums& sums = tileSums[tile];
+        const int tileStart = static_cast<int>(tile) * MetricTileRows;
+        const int tileEnd = std::min(height, tileStart + MetricTileRows);
+        float* errorRow = outputs != nullptr ? &outputRows[static_cast<size_t>(thread) * 2 * outputRowSize] : nullptr;
+        float* ssimRow = outputs != nullptr ? errorRow + outputRowSize : nullptr;
+
+        for (int y = tileStart; y < tileEnd; y++)
+        {
+            const float* rowA = &a.values[static_cast<size_t>(y) * width];
+            const float* rowB = &b.values[static_cast<size_t>(y) * width];
+            FloatV squaredError = Set(0.f);
+            for (int x = 0; x < width; x += static_cast<int>(Width))
+            {
+                const MaskV inside = Set(static_cast<float>(x)) + LaneIndex() < Set(static_cast<float>(width));
+                const FloatV difference = Select(inside, Load(&rowA[x]) - Load(&rowB[x]), Set(0.f));
+                squaredError = MulAdd(difference, difference, squaredError);
+                if (errorRow != nullptr) Store(&errorRow[x], Abs(difference));
+            }
+            sums.squaredError += SumLanes(squaredError);
+            if (outputs != nullptr) AccumulateErrorRow(*outputs, y, errorRow);
+        }
+
+        // Rows with the whole window inside the image
+        const int windowStart = std::max(tileStart, radius);
+        const int windowEnd = std::min(tileEnd, height - radius);
+        if (windowStart >= windowEnd) return;
+
+        float* filtered[FilteredCount];
+        for (int i = 0; i < FilteredCount; i++)
+        {
+            filtered[i] = &scratch[(static_cast<size_t>(thread) * FilteredCount + i) * scratchSize];
+        }
+
+        const int xEnd = width - radius;
+        for (int inputY = windowStart - radius; inputY < windowEnd + radius; inputY++)
+        {
+            const size_t scratchOffset = static_cast<size_t>(inputY - (windowStart - radius)) * width;
+            const float* rowA = &a.values[static_cast<size_t>(inputY) * width];
+            const float* rowB = &b.values[static_cast<size_t>(inputY) * width];
+            for (int x = radius; x < xEnd; x += static_cast<int>(Width))
+            {
+                FloatV sumA = Set(0.f), sumB = Set(0.f), sumAA = Set(0.f), sumBB = Set(0.f), sumAB = Set(0.f);
+                for (int k = 0; k < taps; k++)
+                {
+                    const FloatV weight = Set(window.weights[k]);
+                    const FloatV valueA = Load(&rowA[x - radius + k]);
+                    const FloatV valueB = Load(&rowB[x - radius + k]);
+                    const FloatV weightedA = weight * valueA;
+                    const FloatV weightedB = weight * valueB;
+                    sumA = sumA + weightedA;
+                    sumB = sumB + weightedB;
+                    sumAA = MulAdd(weightedA, valueA, sumAA);
+                    sumBB = MulAdd(weightedB, valueB, sumBB);
+                    sumAB = MulAdd(weightedA, valueB, sumAB);
+                }
+                Store(&filtered[0][scratchOffset + x], sumA);
+                Store(&filtered[1][scratchOffset + x], sumB);
+                Store(&filtered[2][scratchOffset + x], sumAA);
+                Store(&filtered[3][scratchOffset + x], sumBB);
+                Store(&filtered[4][scratchOffset + x], sumAB);
+            }
+        }
+
+        const FloatV centerV = Set(center);
+        const FloatV c1V = Set(c1);
+        const FloatV c2V = Set(c2);
+        const FloatV two = Set(2.f);
+        for (int y = windowStart; y < windowEnd; y++)
+        {
+            const size_t firstRow = static_cast<size_t>(y - windowStart) * width;
+            FloatV rowSsim = Set(0.f);
+            FloatV rowContrastStructure = Set(0.f);
+            for (int x = radius; x < xEnd; x += static_cast<int>(Width))
+            {
+                FloatV values[FilteredCount];
+                for (int i = 0; i < FilteredCount; i++)
+                {
+                    FloatV sum = Set(0.f);
+                    for (int k = 0; k < taps; k++)
+                    {
+                        sum = MulAdd(Set(window.weights[k]), Load(&filtered[i][firstRow + static_cast<size_t>(k) * width + x]), sum);
+                    }
+                    values[i] = sum;
+                }
+
+                const FloatV meanA = values[0] + centerV;
+                const FloatV meanB = values[1] + centerV;
+                const FloatV varianceA = values[2] - values[0] * values[0];
+                const FloatV varianceB = values[3] - values[1] * values[1];
+                const FloatV covariance = values[4] - values[0] * values[1];
+
+                const FloatV luminance = (two * meanA * meanB + c1V) / (meanA * meanA + meanB * meanB + c1V);
+                const FloatV contrastStructure = (two * covariance + c2V) / (varianceA + varianceB + c2V);
+                const MaskV inside = Set(static_cast<float>(x)) + LaneIndex() < Set(static_cast<float>(xEnd));
+                const FloatV ssim = Select(inside, luminance * contrastStructure, Set(0.f));
+                rowSsim = rowSsim + ssim;
+                rowContrastStructure = rowContrastStructure + Select(inside, contrastStructure, Set(0.f));
+                if (ssimRow != nullptr) Store(&ssimRow[x], ssim);
+            }
+            if (outputs != nullptr) AccumulateSsimRow(*outputs, y, ssimRow, radius, xEnd);
+            sums.ssim += SumLanes(rowSsim);
+            sums.contrastStructure += SumLanes(rowContrastStructure);
+            sums.windowCount += xEnd - radius;
+        }
+    }, statistics);
+
+    PassSums total{};
+    for (const PassSums& sums : tileSums)
+    {
+        total.ssim += sums.ssim;
+        total.contrastStructure += sums.contrastStructure;
+        total.squaredError += sums.squaredError;
+        total.windowCount += sums.windowCount;
+    }
+    return total;
+}
+
+// Allocates the maps and the row sums the full resolution passes accumulate into.
+static PassOutputs PrepareOutputs(MemoryArena& arena, MetricMaps& maps, int width, int height, int planeCount)
+{
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    maps.width = width;
+    maps.height = height;
+    maps.ssimValues = nullptr;
+    maps.errorValues = nullptr;
+    if (maps.ssimMap)
+    {
+        maps.ssimValues = NewArray(arena, float, pixelCount);
+        std::fill(maps.ssimValues, maps.ssimValues + pixelCount, 0.f);
+    }
+    if (maps.errorMap)
+    {
+        maps.errorValues = NewArray(arena, float, pixelCount);
+        std::fill(maps.errorValues, maps.errorValues + pixelCount, 0.f);
+    }
+
+    PassOutputs outputs{};
+    outputs.maps = &maps;
+    outputs.weight = 1.f / planeCount;
+    outputs.regionWidth = maps.tileSize > 0 ? std::min(maps.tileSize, width) : width;
+    outputs.regionColumnCount = (width + outputs.regionWidth - 1) / outputs.regionWidth;
+    const size_t sumCount = static_cast<size_t>(height) * outputs.regionColumnCount;
+    outputs.rowSums = NewArray(arena, RegionSums, sumCount);
+    return outputs;
+}
+
+// Reduces the row sums of a rectangle of region columns into its statistics.
+static RegionMetrics ReduceRegion(const PassOutputs& outputs, int firstColumn, int endColumn, int y, int endY, int planeCount)
+{
+    const MetricMaps& maps = *outputs.maps;
+    RegionMetrics region{};
+    region.x = firstColumn * outputs.regionWidth;
+    region.y = y;
+    region.width = std::min(maps.width, endColumn * outputs.regionWidth) - region.x;
+    region.height = endY - y;
+
+    RegionSums total{};
+    for (int row = y; row < endY; row++)
+    {
+        for (int column = firstColumn; column < endColumn; column++)
+        {
+            const RegionSums& sums = outputs.rowSums[static_cast<size_t>(row) * outputs.regionColumnCount + column];
+            total.ssim += sums.ssim;
+            total.squaredError += sums.squaredError;
+            total.absoluteError += sums.absoluteError;
+            total.maxAbsoluteError = std::max(total.maxAbsoluteError, sums.maxAbsoluteError);
+            total.windowCount += sums.windowCount;
+        }
+    }
+
+    // Window counts add up over the planes, so the mean SSIM needs no plane count
+    const double valueCount = static_cast<double>(region.width) * region.height * planeCount;
+    region.ssim = total.windowCount > 0 ? total.ssim / total.windowCount : std::numeric_limits<double>::quiet_NaN();
+    region.mse = total.squaredError / valueCount;
+    region.meanAbsoluteError = total.absoluteError / valueCount;
+    region.maxAbsoluteError = total.maxAbsoluteError;
+    region.windowCount = total.windowCount / planeCount;
+    return region;
+}
+
+static void FinishOutputs(const PassOutputs& outputs, int radius, int planeCount)
+{
+    MetricMaps& maps = *outputs.maps;
+
+    // Border pixels have no SSIM value, like in the mean
+    if (maps.ssimValues != nullptr)
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        for (int y = 0; y < maps.height; y++)
+        {
+            float* row = &maps.ssimValues[static_cast<size_t>(y) * maps.width];
+            if (y < radius || y >= maps.height - radius)
+            {
+                std::fill(row, row + maps.width, nan);
+                continue;
+            }
+            std::fill(row, row + radius, nan);
+            std::fill(row + maps.width - radius, row + maps.width, nan);
+        }
+    }
+
+    const int bandCount = std::clamp(maps.latitudeBandCount, 1, maps.height);
+    maps.latitudeBands.clear();
+    for (int band = 0; band < bandCount; band++)
+    {
+        const int y = static_cast<int>(static_cast<int64_t>(maps.height) * band / bandCount);
+        const int endY = static_cast<int>(static_cast<int64_t>(maps.height) * (band + 1) / bandCount);
+        maps.latitudeBands.push_back(ReduceRegion(outputs, 0, outputs.regionColumnCount, y, endY, planeCount));
+    }
+
+    maps.tiles.clear();
+    maps.tileCountX = maps.tileSize > 0 ? outputs.regionColumnCount : 0;
+    maps.tileCountY = maps.tileSize > 0 ? (maps.height + maps.tileSize - 1) / maps.tileSize : 0;
+    for (int tileY = 0; tileY < maps.tileCountY; tileY++)
+    {
+        const int y = tileY * maps.tileSize;
+        const int endY = std::min(maps.height, y + maps.tileSize);
+        for (int tileX = 0; tileX < maps.tileCountX; tileX++)
+        {
+            maps.tiles.push_back(ReduceRegion(outputs, tileX, tileX + 1, y, endY, planeCount));
+        }
+    }
+}
+
+double PsnrFromMse(double mse, double dataRange)
+{
+    if (mse == 0.) return std::numeric_limits<double>::infinity();
+    return 10. * std::log10(dataRange * dataRange / mse);
+}
+
+ImageMetrics CompareImages(MemoryArena& arena, const MetricImage& reference, const MetricImage& image, const MetricSettings& settings)
+{
+    if (reference.width != image.width || reference.height != image.height || reference.channelCount != image.channelCount)
+    {
+        throw std::invalid_argument("Images differ in size or channel count");
+    }
+
+    const SsimWindow window = MakeWindow(settings.sigma);
+    const int windowSize = window.radius * 2 + 1;
+    if (image.width < windowSize || image.height < windowSize)
+    {
+        throw std::invalid_argument("Images are smaller than the SSIM window");
+    }
+
+    const float center = settings.dataRange * 0.5f;
+    const float c1 = (SsimK1 * settings.dataRange) * (SsimK1 * settings.dataRange);
+    const float c2 = (SsimK2 * settings.dataRange) * (SsimK2 * settings.dataRange);
+
+    // Scales whose image still covers a whole window
+    int scaleCount = 1;
+    if (settings.multiScale)
+    {
+        while (scaleCount < MaxScaleCount && std::min(image.width >> scaleCount, image.height >> scaleCount) >= windowSize)
+        {
+            scaleCount++;
+        }
+    }
+    double weightSum = 0.;
+    for (int scale = 0; scale < scaleCount; scale++) weightSum += ScaleWeights[scale];
+
+    ImageMetrics metrics{};
+    metrics.scaleCount = settings.multiScale ? scaleCount : 0;
+    const int planeCount = settings.color == MetricColor::Luma ? 1 : image.channelCount;
+    double squaredError = 0.;
+    PassOutputs outputs{};
+    if (settings.maps != nullptr)
+    {
+        outputs = PrepareOutputs(arena, *settings.maps, image.width, image.height, planeCount);
+    }
+
+    for (int channel = 0; channel < planeCount; channel++)
+    {
+        Plane planeA = ExtractPlane(arena, reference, settings.color, channel, center);
+        Plane planeB = ExtractPlane(arena, image, settings.color, channel, center);
+
+        double msSsim = 1.;
+        for (int scale = 0; scale < scaleCount; scale++)
+        {
+            if (scale > 0)
+            {
+                planeA = Downsample(arena, planeA);
+                planeB = Downsample(arena, planeB);
+            }
+
+            SchedulerStatistics* statistics = scale == 0 && channel == 0 ? settings.statistics : nullptr;
+            const PassOutputs* passOutputs = scale == 0 && settings.maps != nullptr ? &outputs : nullptr;
+            const PassSums sums = RunSsimPass(arena, planeA, planeB, window, center, c1, c2, settings.threadCount, statistics, passOutputs);
+            const double count = static_cast<double>(sums.windowCount);
+            if (scale == 0)
+            {
+                metrics.ssim += sums.ssim / count;
+                squaredError += sums.squaredError;
+            }
+
+            // Negative similarities are clamped like tf.image.ssim_multiscale does, a fractional power of them is undefined
+            const double term = scale + 1 == scaleCount ? sums.ssim / count : sums.contrastStructure / count;
+            msSsim *= std::pow(std::max(term, 0.), ScaleWeights[scale] / weightSum);
+        }
+        if (settings.multiScale) metrics.msSsim += msSsim;
+    }
+
+    if (settings.maps != nullptr)
+    {
+        FinishOutputs(outputs, window.radius, planeCount);
+    }
+
+    metrics.ssim /= planeCount;
+    metrics.msSsim /= planeCount;
+    metrics.mse = squaredError / (static_cast<double>(image.width) * image.height * planeCount);
+    metrics.psnr = PsnrFromMse(metrics.mse, settings.dataRange);
+    return metrics;
+}
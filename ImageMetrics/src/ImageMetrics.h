@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../ReferenceRenderer/src/TileScheduler.h"
+#include "../../EquirectConverter/src/Memory.h"
+#include "MetricMaps.h"
+
+#include <cstdint>
+#include <cstddef>
+
+// Full reference image quality metrics, the numbers the comparison scripts computed with scikit-image:
+// SSIM with an 11x11 Gaussian window (sigma 1.5, population covariance, mean over the pixels at least 5 pixels from the
+// edge), MS-SSIM over 5 scales, MSE and PSNR for 8 bit data.
+
+// 8 bit image with interleaved channels, as stb_image returns it.
+struct MetricImage
+{
+    int width = 0;
+    int height = 0;
+    int channelCount = 3;
+    const uint8_t* pixels = nullptr;
+};
+
+// Which values of the image are compared.
+enum class MetricColor
+{
+    Luma,     // ITU-R 601 luma rounded to 8 bit like PIL's convert('L'), what compare_multi.py compares
+    Channels, // every channel on its own, SSIM and MS-SSIM are averaged over the channels, MSE and PSNR use all values
+};
+
+struct MetricSettings
+{
+    MetricColor color = MetricColor::Luma;
+    float sigma = 1.5f;
+    float dataRange = 255.f;
+    bool multiScale = true;
+
+    // Worker threads, 0 uses one per hardware thread.
+    int threadCount = 0;
+
+    // Optional, receives the per-thread utilization of the full resolution pass (of the first channel).
+    SchedulerStatistics* statistics = nullptr;
+
+    // Optional, receives per-pixel maps and region statistics of the full resolution pass.
+    MetricMaps* maps = nullptr;
+};
+
+struct ImageMetrics
+{
+    double ssim = 0.;
+    double msSsim = 0.; // 0 if disabled in the settings
+    double mse = 0.;
+    double psnr = 0.;   // infinity for identical images
+
+    // Scales MS-SSIM used, fewer than 5 for images too small to downsample that often (weights are renormalized).
+    int scaleCount = 0;
+};
+
+// Compares image against the reference, both need the same size and channel count. Every pass is split into bands of
+// rows that run in parallel, scratch memory is allocated in the arena.
+// Throws std::invalid_argument for mismatched images or images smaller than the SSIM window.
+ImageMetrics CompareImages(MemoryArena& arena, const MetricImage& reference, const MetricImage& image, const MetricSettings& settings = {});
+
+// PSNR of an MSE for the given data range, infinity for an MSE of 0.
+double PsnrFromMse(double mse, double dataRange = 255.);
@@ -0,0 +1,43 @@
+#include "MetricMaps.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+bool WriteFloatImage(const std::string& path, int width, int height, const float* values)
+{
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    // A negative scale marks little endian data, rows are stored from the bottom up
+    uint16_t endianTest = 1;
+    uint8_t firstByte = 0;
+    std::memcpy(&firstByte, &endianTest, 1);
+    bool written = std::fprintf(file, "Pf\n%d %d\n%s\n", width, height, firstByte == 1 ? "-1.0" : "1.0") > 0;
+    for (int y = height - 1; y >= 0 && written; y--)
+    {
+        written = std::fwrite(&values[static_cast<size_t>(y) * width], sizeof(float), width, file) == static_cast<size_t>(width);
+    }
+    return std::fclose(file) == 0 && written;
+}
+
+bool WriteRegionCsv(const std::string& path, const MetricMaps& maps)
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    bool written = std::fprintf(file, "region,index,x,y,width,height,latitude_top,latitude_bottom,ssim,mse,mean_abs_error,max_abs_error,ssim_pixels\n") > 0;
+    auto writeRegions = [&](const char* name, const std::vector<RegionMetrics>& regions) {
+        for (size_t i = 0; i < regions.size() && written; i++)
+        {
+            const RegionMetrics& region = regions[i];
+            const double latitudeTop = 90. - 180. * region.y / maps.height;
+            const double latitudeBottom = 90. - 180. * (region.y + region.height) / maps.height;
+            written = std::fprintf(file, "%s,%zu,%d,%d,%d,%d,%.4f,%.4f,%.9g,%.9g,%.9g,%.9g,%zu\n", name, i, region.x, region.y, region.width, region.height,
+                                   latitudeTop, latitudeBottom, region.ssim, region.mse, region.meanAbsoluteError, region.maxAbsoluteError, region.windowCount) > 0;
+        }
+    };
+    writeRegions("band", maps.latitudeBands);
+    writeRegions("tile", maps.tiles);
+    return std::fclose(file) == 0 && written;
+}
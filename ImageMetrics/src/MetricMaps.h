@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Where two images differ: per-pixel maps and statistics of latitude bands and square tiles, filled by the full
+// resolution pass of CompareImages while it computes the scalar metrics. Rows are latitudes of an equirect image, so
+// the bands show the difference between the poles and the equator.
+
+// Statistics of one rectangle of the full resolution image.
+struct RegionMetrics
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    double ssim = 0.;             // mean over the pixels whose SSIM window lies inside the image, NaN if there are none
+    double mse = 0.;
+    double meanAbsoluteError = 0.;
+    float maxAbsoluteError = 0.f;
+    size_t windowCount = 0;       // pixels the SSIM mean is taken over
+};
+
+struct MetricMaps
+{
+    // Settings, read by CompareImages
+    int latitudeBandCount = 18; // equal bands of rows, 10 degrees each on an equirect image
+    int tileSize = 64;          // square tiles, 0 disables the tile statistics
+    bool ssimMap = true;
+    bool errorMap = true;
+
+    // Results, the maps are allocated in the arena passed to CompareImages. With more than one channel compared, the
+    // maps hold the mean over the channels and the max absolute error is the largest of any channel.
+    int width = 0;
+    int height = 0;
+    float* ssimValues = nullptr;  // NaN for pixels within the window radius of the edge, which the SSIM mean excludes
+    float* errorValues = nullptr; // absolute difference in the units of the data range
+    std::vector<RegionMetrics> latitudeBands;
+    std::vector<RegionMetrics> tiles; // row by row, tileCountX per row
+    int tileCountX = 0;
+    int tileCountY = 0;
+};
+
+// Writes a single channel float image as PFM, 4 bytes per pixel and readable by most HDR tools and numpy.
+// Returns false if the file can't be written.
+bool WriteFloatImage(const std::string& path, int width, int height, const float* values);
+
+// Writes the band and tile statistics as one CSV, a row per region with its latitude range in degrees.
+// Returns false if the file can't be written.
+bool WriteRegionCsv(const std::string& path, const MetricMaps& maps);
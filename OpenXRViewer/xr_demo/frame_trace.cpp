@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "common.h"
+#include "frame_trace.h"
+
+#include <chrono>
+
+namespace {
+// How long the writer sleeps when the ring is empty, a few frames at most
+constexpr std::chrono::milliseconds WriterIdleTime{5};
+}  // namespace
+
+FrameTraceRecorder::FrameTraceRecorder(const std::string& path)
+    : m_path(path), m_file(path, std::ios::binary), m_ring(std::make_unique<FrameTraceRecord[]>(RingCapacity)) {
+    CHECK_MSG(m_file.good(), Fmt("Failed to create frame trace %s", path.c_str()));
+
+    const FrameTraceHeader header{FrameTraceMagic, FrameTraceVersion, sizeof(FrameTraceRecord), FrameTraceViewCount};
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_writer = std::thread(&FrameTraceRecorder::WriteRecords, this);
+}
+
+FrameTraceRecorder::~FrameTraceRecorder() {
+    m_stop.store(true, std::memory_order_release);
+    m_writer.join();
+
+    Log::Write(m_file.good() ? Log::Level::Info : Log::Level::Error,
+               Fmt("Frame trace %s: %llu frames recorded, %llu dropped%s", m_path.c_str(),
+                   static_cast<unsigned long long>(m_pushedRecords - m_droppedRecords),
+                   static_cast<unsigned long long>(m_droppedRecords), m_file.good() ? "" : ", failed to write"));
+}
+
+void FrameTraceRecorder::Push(const FrameTraceRecord& record) {
+    m_pushedRecords++;
+    const uint64_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    if (writeIndex - m_readIndex.load(std::memory_order_acquire) == RingCapacity) {
+        m_droppedRecords++;
+        return;
+    }
+
+    m_ring[writeIndex % RingCapacity] = record;
+    m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void FrameTraceRecorder::WriteRecords() {
+    uint64_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+    while (true) {
+        // Read the stop flag first: every record pushed before it was set is visible below
+        const bool stop = m_stop.load(std::memory_order_acquire);
+        const uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+        if (readIndex == writeIndex) {
+            if (stop) {
+                break;
+            }
+            m_file.flush();
+            std::this_thread::sleep_for(WriterIdleTime);
+            continue;
+        }
+
+        // Everything up to the end of the ring in one write, the wrapped part in the next iteration
+        const uint64_t slot = readIndex % RingCapacity;
+        const uint64_t count = std::min(writeIndex - readIndex, RingCapacity - slot);
+        m_file.write(reinterpret_cast<const char*>(&m_ring[slot]), static_cast<std::streamsize>(count * sizeof(FrameTraceRecord)));
+        readIndex += count;
+        m_readIndex.store(readIndex, std::memory_order_release);
+    }
+    m_file.flush();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Binary trace of the frame loop, recorded with "--record <file>". The file is a FrameTraceHeader followed by one
+// FrameTraceRecord per frame, both stored as they are laid out in memory (little endian, 64 bit alignment). The replay
+// runtime plays the views of such a trace back.
+
+constexpr uint32_t FrameTraceMagic = 0x54465258;  // "XRFT"
+constexpr uint32_t FrameTraceVersion = 1;
+constexpr uint32_t FrameTraceViewCount = 2;
+constexpr uint32_t FrameTraceHandCount = 2;
+
+struct FrameTraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;  // sizeof(FrameTraceRecord)
+    uint32_t viewCount;   // FrameTraceViewCount
+};
+
+struct FrameTraceView {
+    XrPosef pose;  // in the app space
+    XrFovf fov;
+};
+
+struct FrameTraceHand {
+    XrSpaceLocationFlags locationFlags;  // 0 when the hand was not located (frames that are not rendered)
+    XrPosef pose;                        // in the app space
+    float grabValue;
+    XrBool32 grabActive;
+    XrBool32 poseActive;
+};
+
+struct FrameTraceRecord {
+    uint64_t frameIndex;
+    XrTime predictedDisplayTime;
+    XrDuration predictedDisplayPeriod;
+    XrBool32 shouldRender;
+    uint32_t viewCount;  // views located for this frame, 0 when it was not rendered or not tracked
+    XrViewStateFlags viewStateFlags;
+    FrameTraceView views[FrameTraceViewCount];
+    FrameTraceHand hands[FrameTraceHandCount];
+    XrBool32 quitPressed;
+
+    // CPU time of the frame loop in microseconds, render covers locating, acquiring, drawing and releasing all views
+    float waitMicroseconds;
+    float beginMicroseconds;
+    float renderMicroseconds;
+    float endMicroseconds;
+};
+
+static_assert(std::is_trivially_copyable_v<FrameTraceRecord>);
+static_assert(sizeof(FrameTraceRecord) == 248, "the trace format changed, bump FrameTraceVersion");
+
+// Hands the records of the render thread to a writer thread through a single producer, single consumer ring buffer,
+// so recording never waits on the disk. Records that find the ring full are dropped and counted.
+class FrameTraceRecorder {
+   public:
+    // Creates the file and starts the writer thread, throws if the file cannot be created.
+    explicit FrameTraceRecorder(const std::string& path);
+
+    // Writes what is left in the ring and closes the file.
+    ~FrameTraceRecorder();
+
+    // Render thread only.
+    void Push(const FrameTraceRecord& record);
+
+   private:
+    void WriteRecords();
+
+    // About 11s of frames at 90Hz, a power of two so the indices can wrap freely
+    static constexpr uint64_t RingCapacity = 1024;
+
+    std::string m_path;
+    std::ofstream m_file;
+    std::unique_ptr<FrameTraceRecord[]> m_ring;
+
+    // Indices count up forever, the slot is index % RingCapacity. Each sits on its own cache line.
+    alignas(64) std::atomic<uint64_t> m_writeIndex{0};  // next slot the render thread fills
+    alignas(64) std::atomic<uint64_t> m_readIndex{0};   // next slot the writer thread drains
+    std::atomic<bool> m_stop{false};
+
+    uint64_t m_pushedRecords{0};   // render thread
+    uint64_t m_droppedRecords{0};  // render thread
+    std::thread m_writer;
+};
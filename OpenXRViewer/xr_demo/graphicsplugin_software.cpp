@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "common.h"
+#include "graphicsplugin.h"
+#include "options.h"
+#include "software_swapchain.h"
+
+#ifdef USE_SOFTWARE_GRAPHICS_PLUGIN
+
+#include "../import/stb_image.h"
+#include "../import/tiny_gltf.h"
+#include "../../ReferenceRenderer/src/PoseTrace.h"
+#include "../../TextureFiltering/src/SoftwareRasterizer.h"
+
+// Renders the environment like graphicsplugin_custom.cpp, but on the CPU with the software rasterizer of the
+// TextureFiltering library. Needs no GPU and no graphics API: frames go to swapchain images in plain memory, see
+// software_swapchain.h.
+
+namespace {
+    // Same assets and model transform as the D3D12 plugin
+    constexpr const char* EnvironmentModelPath = "models/sphere_subdiv2.glb";
+    constexpr const char* EnvironmentTexturePath = "textures/Wolfstein.jpg";
+    constexpr float EnvironmentScale = .1f;
+
+    struct SoftwareGraphicsPlugin : public IGraphicsPlugin {
+        SoftwareGraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin>)
+        {
+            UpdateOptions(options);
+
+            // MainPS of photoviewer.hlsl samples with tex.Sample, switch to Adjusted together with the shader
+            m_rasterSettings.sampling = ShaderSampling::Default;
+            m_rasterSettings.sampler = ViewerSampler;
+        }
+
+        ~SoftwareGraphicsPlugin() override {
+            if (m_textureData != nullptr) stbi_image_free(m_textureData);
+        }
+
+        std::vector<std::string> GetInstanceExtensions() const override { return { XR_MND_HEADLESS_EXTENSION_NAME }; }
+
+        void LoadShaders() override {}
+
+        void InitializeDevice(XrInstance /*instance*/, XrSystemId /*systemId*/) override {
+            LoadEnvironmentMesh();
+
+            // The D3D12 plugin uploads the stb texture without mips, so only level 0 is ever sampled
+            int channelCount;
+            m_textureData = stbi_load(EnvironmentTexturePath, &m_textureWidth, &m_textureHeight, &channelCount, STBI_rgb);
+            CHECK_MSG(m_textureData != nullptr, Fmt("Failed to load %s", EnvironmentTexturePath));
+            m_mipChain.levelCount = 1;
+            m_mipChain.levels[0] = { m_textureWidth, m_textureHeight, m_textureData };
+            m_mipChain.byteCount = static_cast<size_t>(m_textureWidth) * m_textureHeight * 3;
+        }
+
+        int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
+            constexpr int64_t SupportedColorSwapchainFormats[] = {
+                SoftwareSwapchainFormatRGBA8,
+                SoftwareSwapchainFormatBGRA8,
+            };
+
+            auto swapchainFormatIt =
+                std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), std::begin(SupportedColorSwapchainFormats),
+                    std::end(SupportedColorSwapchainFormats));
+            if (swapchainFormatIt == runtimeFormats.end()) {
+                THROW("No runtime swapchain format supported for color swapchain");
+            }
+
+            return *swapchainFormatIt;
+        }
+
+        // Headless session, there is no graphics binding
+        const XrBaseInStructure* GetGraphicsBinding() const override { return nullptr; }
+
+        std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
+            uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
+            // The runtime fills in the pixel pointers, the structs must be sequential in memory for xrEnumerateSwapchainImages.
+            m_swapchainImageBuffers.emplace_back(capacity, XrSwapchainImageSoftwareViewer{ XR_TYPE_SWAPCHAIN_IMAGE_SOFTWARE_VIEWER });
+
+            std::vector<XrSwapchainImageBaseHeader*> bases(capacity);
+            for (uint32_t i = 0; i < capacity; ++i) {
+                bases[i] = reinterpret_cast<XrSwapchainImageBaseHeader*>(&m_swapchainImageBuffers.back()[i]);
+            }
+            return bases;
+        }
+
+        void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
+            int64_t swapchainFormat, const std::vector<Cube>& /*cubes*/) override {
+            CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
+
+            const auto& image = *reinterpret_cast<const XrSwapchainImageSoftwareViewer*>(swapchainImage);
+            CHECK(image.type == XR_TYPE_SWAPCHAIN_IMAGE_SOFTWARE_VIEWER && image.pixels != nullptr);
+            const XrRect2Di& imageRect = layerView.subImage.imageRect;
+
+            // The view is built like the D3D12 plugin builds it, near and far plane included
+            PoseSample pose{};
+            pose.position = { layerView.pose.position.x, layerView.pose.position.y, layerView.pose.position.z };
+            pose.orientation = { layerView.pose.orientation.x, layerView.pose.orientation.y, layerView.pose.orientation.z, layerView.pose.orientation.w };
+            pose.angleLeft = layerView.fov.angleLeft;
+            pose.angleRight = layerView.fov.angleRight;
+            pose.angleUp = layerView.fov.angleUp;
+            pose.angleDown = layerView.fov.angleDown;
+            const ReferenceView view = ViewFromPoseSample(pose, imageRect.extent.width, imageRect.extent.height);
+            const Matrix4 model = { { { EnvironmentScale, 0.f, 0.f, 0.f }, { 0.f, EnvironmentScale, 0.f, 0.f }, { 0.f, 0.f, EnvironmentScale, 0.f }, { 0.f, 0.f, 0.f, 1.f } } };
+
+            RasterTarget target{};
+            target.pixels = image.pixels + static_cast<size_t>(imageRect.offset.y) * image.rowPitch + static_cast<size_t>(imageRect.offset.x) * 4;
+            target.width = imageRect.extent.width;
+            target.height = imageRect.extent.height;
+            target.rowPitch = image.rowPitch;
+            target.layout = swapchainFormat == SoftwareSwapchainFormatBGRA8 ? PixelLayout::BGRA : PixelLayout::RGBA;
+
+            // Every view only needs its temporaries until it is drawn
+            m_frameArena.Reset();
+            const RasterMesh mesh{ m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size() };
+            RasterizeMesh(m_frameArena, mesh, Multiply(Multiply(model, view.spaceToView), view.projection), m_mipChain, target, m_rasterSettings);
+        }
+
+        void UpdateOptions(const std::shared_ptr<Options>& options) override {
+            const std::array<float, 4> clearColor = options->GetBackgroundClearColor();
+            for (size_t i = 0; i < clearColor.size(); i++) {
+                m_rasterSettings.clearColor[i] = static_cast<uint8_t>(std::lround(std::clamp(clearColor[i], 0.f, 1.f) * 255.f));
+            }
+        }
+
+    private:
+        // The first primitive of the first mesh, like LoadGltf in models.cpp
+        void LoadEnvironmentMesh() {
+            tinygltf::Model model;
+            tinygltf::TinyGLTF loader;
+            std::string error;
+            std::string warning;
+            if (!loader.LoadBinaryFromFile(&model, &error, &warning, EnvironmentModelPath) || model.meshes.empty()) {
+                THROW(Fmt("Failed to parse %s: %s", EnvironmentModelPath, error.c_str()));
+            }
+
+            auto readBuffer = [&](const tinygltf::Accessor& accessor) {
+                const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+                return &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+            };
+
+            tinygltf::Primitive& primitive = model.meshes[0].primitives[0];
+            const tinygltf::Accessor& indices = model.accessors[primitive.indices];
+            const tinygltf::Accessor& positions = model.accessors[primitive.attributes["POSITION"]];
+            const tinygltf::Accessor& texCoords = model.accessors[primitive.attributes["TEXCOORD_0"]];
+            CHECK(indices.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT);
+
+            const uint16_t* indexData = reinterpret_cast<const uint16_t*>(readBuffer(indices));
+            m_indices.assign(indexData, indexData + indices.count);
+            const float* positionData = reinterpret_cast<const float*>(readBuffer(positions));
+            const float* texCoordData = reinterpret_cast<const float*>(readBuffer(texCoords));
+            m_vertices.resize(positions.count);
+            for (size_t i = 0; i < positions.count; i++) {
+                m_vertices[i].position = { positionData[i * 3], positionData[i * 3 + 1], positionData[i * 3 + 2] };
+                m_vertices[i].texCoord = { texCoordData[i * 2], texCoordData[i * 2 + 1] };
+            }
+        }
+
+        std::list<std::vector<XrSwapchainImageSoftwareViewer>> m_swapchainImageBuffers;
+        std::vector<RasterVertex> m_vertices;
+        std::vector<uint16_t> m_indices;
+        uint8_t* m_textureData = nullptr;
+        int m_textureWidth = 0;
+        int m_textureHeight = 0;
+        MipChain m_mipChain{};
+        MemoryArena m_frameArena{ "SoftwareFrame" };
+        RasterSettings m_rasterSettings{};
+    };
+}  // namespace
+
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_Software(const std::shared_ptr<Options>& options,
+    std::shared_ptr<IPlatformPlugin> platformPlugin) {
+    return std::make_shared<SoftwareGraphicsPlugin>(options, platformPlugin);
+}
+
+#endif
@@ -9,8 +9,10 @@
 #include "platformplugin.h"
 #include "graphicsplugin.h"
 #include "openxr_program.h"
+#include "frame_trace.h"
 #include "xr_linear.h"
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <set>
 
@@ -94,7 +96,11 @@ struct OpenXrProgram : IOpenXrProgram {
           m_platformPlugin(platformPlugin),
           m_graphicsPlugin(graphicsPlugin),
           m_acceptableBlendModes{XR_ENVIRONMENT_BLEND_MODE_OPAQUE, XR_ENVIRONMENT_BLEND_MODE_ADDITIVE,
-                                 XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND} {}
+                                 XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND} {
+        if (!m_options->FrameTracePath.empty()) {
+            m_frameTrace = std::make_unique<FrameTraceRecorder>(m_options->FrameTracePath);
+        }
+    }
 
     ~OpenXrProgram() override {
         if (m_input.actionSet != XR_NULL_HANDLE) {
@@ -335,6 +341,11 @@ struct OpenXrProgram : IOpenXrProgram {
         std::array<XrSpace, Side::COUNT> handSpace;
         std::array<float, Side::COUNT> handScale = {{1.0f, 1.0f}};
         std::array<XrBool32, Side::COUNT> handActive;
+
+        // Only kept for the frame trace
+        std::array<XrActionStateFloat, Side::COUNT> grabState{{{XR_TYPE_ACTION_STATE_FLOAT}, {XR_TYPE_ACTION_STATE_FLOAT}}};
+        std::array<XrSpaceLocation, Side::COUNT> handLocation{{{XR_TYPE_SPACE_LOCATION}, {XR_TYPE_SPACE_LOCATION}}};
+        XrBool32 quitPressed{XR_FALSE};
     };
 
     void InitializeActions() {
@@ -828,6 +839,7 @@ struct OpenXrProgram : IOpenXrProgram {
 
             XrActionStateFloat grabValue{XR_TYPE_ACTION_STATE_FLOAT};
             CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &grabValue));
+            m_input.grabState[hand] = grabValue;
             if (grabValue.isActive == XR_TRUE) {
                 // Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed).
                 m_input.handScale[hand] = 1.0f - 0.5f * grabValue.currentState;
@@ -854,6 +866,7 @@ struct OpenXrProgram : IOpenXrProgram {
         XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.quitAction, XR_NULL_PATH};
         XrActionStateBoolean quitValue{XR_TYPE_ACTION_STATE_BOOLEAN};
         CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &quitValue));
+        m_input.quitPressed = quitValue.isActive == XR_TRUE && quitValue.currentState == XR_TRUE;
         if ((quitValue.isActive == XR_TRUE) && (quitValue.changedSinceLastSync == XR_TRUE) && (quitValue.currentState == XR_TRUE)) {
             CHECK_XRCMD(xrRequestExitSession(m_session));
         }
@@ -862,12 +875,24 @@ struct OpenXrProgram : IOpenXrProgram {
     void RenderFrame() override {
         CHECK(m_session != XR_NULL_HANDLE);
 
+        // Phase boundaries for the frame trace: wait, begin, render, end
+        std::array<std::chrono::steady_clock::time_point, 5> phaseStart;
+        phaseStart[0] = std::chrono::steady_clock::now();
+
         XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
         XrFrameState frameState{XR_TYPE_FRAME_STATE};
         CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        phaseStart[1] = std::chrono::steady_clock::now();
 
         XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
         CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        phaseStart[2] = std::chrono::steady_clock::now();
+
+        // Nothing is located for frames that are not rendered
+        m_viewStateFlags = 0;
+        for (XrSpaceLocation& handLocation : m_input.handLocation) {
+            handLocation.locationFlags = 0;
+        }
 
         std::vector<XrCompositionLayerBaseHeader*> layers;
         XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
@@ -883,7 +908,47 @@ struct OpenXrProgram : IOpenXrProgram {
         frameEndInfo.environmentBlendMode = m_options->Parsed.EnvironmentBlendMode;
         frameEndInfo.layerCount = (uint32_t)layers.size();
         frameEndInfo.layers = layers.data();
+        phaseStart[3] = std::chrono::steady_clock::now();
         CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        phaseStart[4] = std::chrono::steady_clock::now();
+
+        if (m_frameTrace) {
+            RecordFrame(frameState, phaseStart);
+        }
+        m_frameIndex++;
+    }
+
+    void RecordFrame(const XrFrameState& frameState, const std::array<std::chrono::steady_clock::time_point, 5>& phaseStart) {
+        auto microseconds = [&](size_t phase) {
+            return std::chrono::duration<float, std::micro>(phaseStart[phase + 1] - phaseStart[phase]).count();
+        };
+
+        FrameTraceRecord record{};
+        record.frameIndex = m_frameIndex;
+        record.predictedDisplayTime = frameState.predictedDisplayTime;
+        record.predictedDisplayPeriod = frameState.predictedDisplayPeriod;
+        record.shouldRender = frameState.shouldRender;
+        record.viewStateFlags = m_viewStateFlags;
+        if (m_viewStateFlags != 0) {
+            record.viewCount = std::min((uint32_t)m_views.size(), FrameTraceViewCount);
+            for (uint32_t i = 0; i < record.viewCount; i++) {
+                record.views[i] = {m_views[i].pose, m_views[i].fov};
+            }
+        }
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            FrameTraceHand& traceHand = record.hands[hand];
+            traceHand.locationFlags = m_input.handLocation[hand].locationFlags;
+            traceHand.pose = m_input.handLocation[hand].pose;
+            traceHand.grabValue = m_input.grabState[hand].currentState;
+            traceHand.grabActive = m_input.grabState[hand].isActive;
+            traceHand.poseActive = m_input.handActive[hand];
+        }
+        record.quitPressed = m_input.quitPressed;
+        record.waitMicroseconds = microseconds(0);
+        record.beginMicroseconds = microseconds(1);
+        record.renderMicroseconds = microseconds(2);
+        record.endMicroseconds = microseconds(3);
+        m_frameTrace->Push(record);
     }
 
     bool RenderLayer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews,
@@ -901,6 +966,7 @@ struct OpenXrProgram : IOpenXrProgram {
 
         res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, m_views.data());
         CHECK_XRRESULT(res, "xrLocateViews");
+        m_viewStateFlags = viewState.viewStateFlags;
         if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 ||
             (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
             return false;  // There is no valid tracking poses for the views.
@@ -936,6 +1002,7 @@ struct OpenXrProgram : IOpenXrProgram {
             res = xrLocateSpace(m_input.handSpace[hand], m_appSpace, predictedDisplayTime, &spaceLocation);
             CHECK_XRRESULT(res, "xrLocateSpace");
             if (XR_UNQUALIFIED_SUCCESS(res)) {
+                m_input.handLocation[hand] = spaceLocation;
                 if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
                     (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
                     float scale = 0.1f * m_input.handScale[hand];
@@ -1003,6 +1070,7 @@ struct OpenXrProgram : IOpenXrProgram {
     std::vector<Swapchain> m_swapchains;
     std::map<XrSwapchain, std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;
     std::vector<XrView> m_views;
+    XrViewStateFlags m_viewStateFlags{0};  // of m_views, 0 when they were not located this frame
     int64_t m_colorSwapchainFormat{-1};
 
     std::vector<XrSpace> m_visualizedSpaces;
@@ -1015,6 +1083,10 @@ struct OpenXrProgram : IOpenXrProgram {
     InputState m_input;
 
     const std::set<XrEnvironmentBlendMode> m_acceptableBlendModes;
+
+    // Set with --record
+    std::unique_ptr<FrameTraceRecorder> m_frameTrace;
+    uint64_t m_frameIndex{0};
 };
 }  // namespace
 
@@ -64,6 +64,9 @@ struct Options {
 
     std::string AppSpace{"Local"};
 
+    // Binary trace of every frame (frame_trace.h), not recorded when empty
+    std::string FrameTracePath;
+
     struct {
         XrFormFactor FormFactor{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY};
 
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+
+// Swapchain images of the software graphics plugin: plain memory the CPU renders into. OpenXR has no graphics binding
+// for this, so the session is created headless (XR_MND_headless) and a runtime that knows these images has to hand
+// them out from xrEnumerateSwapchainImages.
+
+// Outside of the range the OpenXR registry assigns to extensions.
+constexpr XrStructureType XR_TYPE_SWAPCHAIN_IMAGE_SOFTWARE_VIEWER = static_cast<XrStructureType>(0x7FF00001);
+
+// Swapchain formats, same values as the DXGI formats the D3D12 plugins use.
+constexpr int64_t SoftwareSwapchainFormatRGBA8 = 28; // DXGI_FORMAT_R8G8B8A8_UNORM
+constexpr int64_t SoftwareSwapchainFormatBGRA8 = 87; // DXGI_FORMAT_B8G8R8A8_UNORM
+
+struct XrSwapchainImageSoftwareViewer
+{
+    XrStructureType type;
+    void* XR_MAY_ALIAS next;
+    uint8_t* pixels;   // owned by the runtime, valid until the swapchain is destroyed
+    uint32_t rowPitch; // bytes
+};
@@ -0,0 +1,334 @@
+#include "../src/ReferenceRenderer.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The per-pixel path as it was before the hot loop rewrite (heap-backed ray hits, qsort, 3D vectors).
+// Kept here as the "before" measurement, the renderer itself only has the current implementation.
+namespace Baseline
+{
+    void RaySphereIntersection(Vector3 rayStart, Vector3 rayDirection, float sphereRadius, std::vector<Vector3>& outIntersections)
+    {
+        outIntersections.clear();
+
+        float a = Dot(rayDirection, rayDirection);
+        float b = 2.f * Dot(rayDirection, rayStart);
+        float c = Dot(rayStart, rayStart) - sphereRadius * sphereRadius;
+        float discriminant = b * b - 4.f * a * c;
+        if (discriminant < 0.f) return;
+
+        float t1 = (-b + sqrtf(discriminant)) / (2.f * a);
+        if (t1 >= 0.f) outIntersections.push_back(rayStart + rayDirection * t1);
+        float t2 = (-b - sqrtf(discriminant)) / (2.f * a);
+        if (t2 >= 0.f && discriminant > 0.f) outIntersections.push_back(rayStart + rayDirection * t2);
+    }
+
+    float EdgeFunction(const Vector3& e1, const Vector3& e2, const Vector3& p)
+    {
+        return (p.x - e1.x) * (e2.y - e1.y) - (p.y - e1.y) * (e2.x - e1.x);
+    }
+
+    bool IsInsideTriangle(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& p)
+    {
+        float e1 = EdgeFunction(a, b, p);
+        float e2 = EdgeFunction(b, c, p);
+        float e3 = EdgeFunction(c, a, p);
+        return (e1 >= 0.f && e2 >= 0.f && e3 >= 0.f) || (e1 <= 0.f && e2 <= 0.f && e3 <= 0.f);
+    }
+
+    uint8_t* CreatePerfectFilteredImage(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view)
+    {
+        const size_t screenWidth = view.screenWidth;
+        const size_t screenHeight = view.screenHeight;
+        const size_t gridWidth = screenWidth + 1;
+        const size_t gridHeight = screenHeight + 1;
+        const Matrix4 inverseViewProjection = Inverse(Multiply(view.spaceToView, view.projection));
+
+        uint8_t* outputData = NewArray(arena, uint8_t, screenWidth * screenHeight * 3);
+        std::vector<Vector3>* grid = NewArray(arena, std::vector<Vector3>, gridWidth * gridHeight);
+
+        #pragma omp parallel for
+        for (int y = 0; y < static_cast<int>(gridHeight); y++)
+        {
+            for (int x = 0; x < static_cast<int>(gridWidth); x++)
+            {
+                float clipSpaceX = (static_cast<float>(x) / static_cast<float>(screenWidth)) * 2.f - 1.f;
+                float clipSpaceY = (static_cast<float>(y) / static_cast<float>(screenHeight)) * 2.f - 1.f;
+                Vector3 nearPos = TransformCoord({ clipSpaceX, clipSpaceY, 0.f }, inverseViewProjection);
+                Vector3 farPos = TransformCoord({ clipSpaceX, clipSpaceY, 1.f }, inverseViewProjection);
+
+                std::vector<Vector3>& intersections = *new (&grid[y * gridWidth + x]) std::vector<Vector3>();
+                RaySphereIntersection(nearPos, Normalize(farPos - nearPos), 500.f, intersections);
+                for (Vector3& intersection : intersections)
+                {
+                    Vector3 n = Normalize(intersection);
+                    intersection = { (atan2f(n.z, n.x) / RENDER_2PI + .5f) * texture.width, acosf(n.y) / RENDER_PI * texture.height, 0.f };
+                }
+            }
+        }
+
+        #pragma omp parallel for
+        for (int y = 0; y < static_cast<int>(screenHeight); y++)
+        {
+            for (int x = 0; x < static_cast<int>(screenWidth); x++)
+            {
+                size_t outputIndex = (y * screenWidth + x) * 3;
+                Vector3 quad[4] = {
+                    grid[y * gridWidth + x][0], grid[y * gridWidth + x + 1][0],
+                    grid[(y + 1) * gridWidth + x][0], grid[(y + 1) * gridWidth + x + 1][0]
+                };
+
+                std::qsort(quad, 4, sizeof(Vector3), [](const void* a, const void* b) -> int {
+                    float ay = reinterpret_cast<const Vector3*>(a)->y;
+                    float by = reinterpret_cast<const Vector3*>(b)->y;
+                    return ay < by ? -1 : (ay > by ? 1 : 0);
+                });
+
+                float minX = quad[0].x, minY = quad[0].y, maxX = minX, maxY = minY;
+                for (const Vector3& vertex : quad)
+                {
+                    minX = std::min(minX, vertex.x);
+                    minY = std::min(minY, vertex.y);
+                    maxX = std::max(maxX, vertex.x);
+                    maxY = std::max(maxY, vertex.y);
+                }
+                maxX = std::min(maxX, static_cast<float>(texture.width - 1));
+                maxY = std::min(maxY, static_cast<float>(texture.height - 1));
+                if (quad[1].x > quad[2].x) std::swap(quad[1], quad[2]);
+
+                size_t outR = 0, outG = 0, outB = 0, sumCount = 0;
+                const size_t subSampleCount = 8;
+                for (size_t subSampleY = minY * subSampleCount; subSampleY <= maxY * subSampleCount; subSampleY++)
+                {
+                    for (size_t subSampleX = minX * subSampleCount; subSampleX <= maxX * subSampleCount; subSampleX++)
+                    {
+                        const Vector3 pixel = { (subSampleX + .5f) / subSampleCount, (subSampleY + .5f) / subSampleCount, 0.f };
+                        if (IsInsideTriangle(quad[0], quad[2], quad[1], pixel) || IsInsideTriangle(quad[1], quad[2], quad[3], pixel))
+                        {
+                            size_t sampleTexIndex = ((subSampleY / subSampleCount) * texture.width + (subSampleX / subSampleCount)) * 3;
+                            outR += static_cast<uint8_t>(pow(texture.data[sampleTexIndex] / 255., 1. / 2.2) * 255.);
+                            outG += static_cast<uint8_t>(pow(texture.data[sampleTexIndex + 1] / 255., 1. / 2.2) * 255.);
+                            outB += static_cast<uint8_t>(pow(texture.data[sampleTexIndex + 2] / 255., 1. / 2.2) * 255.);
+                            sumCount += 1;
+                        }
+                    }
+                }
+                sumCount = std::max(sumCount, size_t{ 1 });
+                outputData[outputIndex] = static_cast<uint8_t>(outR / sumCount);
+                outputData[outputIndex + 1] = static_cast<uint8_t>(outG / sumCount);
+                outputData[outputIndex + 2] = static_cast<uint8_t>(outB / sumCount);
+            }
+        }
+
+        for (size_t i = 0; i < gridWidth * gridHeight; i++) grid[i].~vector();
+        return outputData;
+    }
+}
+
+struct BenchmarkOptions
+{
+    std::string texturePath;
+    size_t size = 512;
+    int iterations = 3;
+    RenderSettings settings{};
+    bool useSummedAreaTable = false;
+    bool legacyBaseline = true;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkReferenceRenderer [--texture|-t <equirect image>] [--size|-s <pixels>] [--iterations|-i <count>]" << std::endl;
+    std::cout << "                           [--coverage|-c subsamples|analytic|adaptive] [--tolerance <levels>] [--summed-area-table|-a <min footprint texels>]" << std::endl;
+    std::cout << "                           [--threads|-j <count, 0 = all>]" << std::endl;
+    std::cout << "                           [--baseline|-b legacy|subsamples]" << std::endl;
+    std::cout << "Without a texture a 2048x1024 one pixel checkerboard is used." << std::endl;
+    std::cout << "The baseline (\"before\") is either the pixel loop before the rewrite or the current 8x8 subsample mode." << std::endl;
+}
+
+bool ParseCommandLine(BenchmarkOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+    auto getNextFloat = [&] { return std::stof(getNextArg()); };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePath = getNextArg();
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.size = std::stoul(getNextArg());
+        }
+        else if (arg == "--iterations" || arg == "-i")
+        {
+            options.iterations = std::max(1, std::stoi(getNextArg()));
+        }
+        else if (arg == "--coverage" || arg == "-c")
+        {
+            const std::string mode = getNextArg();
+            if (mode == "subsamples") options.settings.coverage = CoverageMode::Subsamples;
+            else if (mode == "analytic") options.settings.coverage = CoverageMode::Analytic;
+            else if (mode == "adaptive") options.settings.coverage = CoverageMode::Adaptive;
+            else throw std::invalid_argument("Unknown coverage mode: " + mode);
+        }
+        else if (arg == "--baseline" || arg == "-b")
+        {
+            const std::string baseline = getNextArg();
+            if (baseline == "legacy") options.legacyBaseline = true;
+            else if (baseline == "subsamples") options.legacyBaseline = false;
+            else throw std::invalid_argument("Unknown baseline: " + baseline);
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.settings.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--tolerance")
+        {
+            options.settings.adaptiveTolerance = getNextFloat();
+        }
+        else if (arg == "--summed-area-table" || arg == "-a")
+        {
+            options.useSummedAreaTable = true;
+            options.settings.summedAreaTableMinTexels = getNextFloat();
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return true;
+}
+
+// Renders the view repeatedly and returns the best time in milliseconds, the image of the last run is kept in the arena.
+template <typename RenderFunction>
+double MeasureRender(MemoryArena& arena, int iterations, uint8_t*& outImage, RenderFunction render)
+{
+    double bestMilliseconds = 0.;
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        arena.Reset();
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        outImage = render();
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(measureEnd - measureStart).count();
+        bestMilliseconds = iteration == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+    }
+    return bestMilliseconds;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options{};
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    MemoryArena textureArena{ "BenchmarkTexture" };
+    SphereTexture texture{};
+    uint8_t* loadedData = nullptr;
+    if (!options.texturePath.empty())
+    {
+        int channelCount;
+        loadedData = stbi_load(options.texturePath.c_str(), &texture.width, &texture.height, &channelCount, 3);
+        if (loadedData == nullptr)
+        {
+            std::cout << stbi_failure_reason() << std::endl;
+            return 1;
+        }
+        texture.data = loadedData;
+    }
+    else
+    {
+        // Single pixel checkerboard, the worst case for the filter since every footprint covers many texels
+        texture.width = 2048;
+        texture.height = 1024;
+        uint8_t* pixels = NewArray(textureArena, uint8_t, texture.width * texture.height * 3);
+        for (int i = 0; i < texture.width * texture.height; i++)
+        {
+            const uint8_t value = ((i % texture.width) + (i / texture.width)) % 2 == 0 ? 0 : 255;
+            pixels[i * 3] = pixels[i * 3 + 1] = pixels[i * 3 + 2] = value;
+        }
+        texture.data = pixels;
+    }
+
+    ReferenceView view{};
+    view.spaceToView = RotationAxis({ 1.f, 0.f, 0.f }, RENDER_PI / 2.f);
+    view.projection = ProjectionFov(-RENDER_PI / 4.f, RENDER_PI / 4.f, RENDER_PI / 4.f, -RENDER_PI / 4.f, 0.05f, 100.f);
+    view.screenWidth = options.size;
+    view.screenHeight = options.size;
+    const double pixelCount = static_cast<double>(view.screenWidth * view.screenHeight);
+
+    MemoryArena baselineArena{ "BenchmarkBaseline" };
+    MemoryArena currentArena{ "BenchmarkCurrent" };
+    MemoryArena tableArena{ "BenchmarkSummedAreaTable", 4ull * 1024 * 1024 * 1024 };
+    SummedAreaTable summedAreaTable{};
+    if (options.useSummedAreaTable)
+    {
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        summedAreaTable = CreateSummedAreaTable(tableArena, texture, options.settings.threadCount);
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        std::cout << "Summed area table finished in: " << std::chrono::duration<double, std::milli>(measureEnd - measureStart).count() << "ms" << std::endl;
+        options.settings.summedAreaTable = &summedAreaTable;
+    }
+
+    SchedulerStatistics statistics{};
+    options.settings.statistics = &statistics;
+
+    uint8_t* baselineImage = nullptr;
+    uint8_t* currentImage = nullptr;
+
+    double baselineMilliseconds = MeasureRender(baselineArena, options.iterations, baselineImage, [&] {
+        RenderSettings baselineSettings{};
+        baselineSettings.threadCount = options.settings.threadCount;
+        return options.legacyBaseline ? Baseline::CreatePerfectFilteredImage(baselineArena, texture, view) : CreatePerfectFilteredImage(baselineArena, texture, view, baselineSettings);
+    });
+    double currentMilliseconds = MeasureRender(currentArena, options.iterations, currentImage, [&] { return CreatePerfectFilteredImage(currentArena, texture, view, options.settings); });
+
+    int maxDifference = 0;
+    for (size_t i = 0; i < view.screenWidth * view.screenHeight * 3; i++)
+    {
+        maxDifference = std::max(maxDifference, std::abs(static_cast<int>(baselineImage[i]) - static_cast<int>(currentImage[i])));
+    }
+
+    std::cout << "Rendering " << view.screenWidth << "x" << view.screenHeight << " from " << texture.width << "x" << texture.height
+              << ", best of " << options.iterations << ", baseline " << (options.legacyBaseline ? "legacy" : "subsamples") << std::endl;
+    std::cout << "  before: " << baselineMilliseconds << "ms, " << pixelCount / baselineMilliseconds * 1000. << " pixels/s" << std::endl;
+    std::cout << "  after:  " << currentMilliseconds << "ms, " << pixelCount / currentMilliseconds * 1000. << " pixels/s" << std::endl;
+    std::cout << "  speedup " << baselineMilliseconds / currentMilliseconds << "x, max channel difference " << maxDifference << std::endl;
+
+    // Load balance of the last render
+    PrintSchedulerStatistics(statistics);
+
+    if (loadedData != nullptr) stbi_image_free(loadedData);
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include "../src/ReferenceCache.h"
+#include "../src/ReferenceRenderer.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+struct RenderOptions
+{
+    std::string texturePath;
+    std::string outputPath = "comparison_perfect_raytraced.png";
+    size_t width = 2048;
+    size_t height = 2048;
+
+    // Defaults reproduce the comparison image of the viewer: looking straight down, symmetric 90° fov.
+    Matrix4 spaceToView = RotationAxis({ 1.f, 0.f, 0.f }, RENDER_PI / 2.f);
+    float fovDegrees[4] = { -45.f, 45.f, 45.f, -45.f };
+    bool hasProjection = false;
+    Matrix4 projection{};
+    RenderSettings settings{};
+    bool useSummedAreaTable = false;
+    bool progressive = false;
+    std::string cacheDirectory;
+    uint64_t cacheMegabytes = 4096;
+};
+
+void ShowHelp()
+{
+    std::cout << "RenderReference --texture|-t <equirect image> [--output|-o <png>] [--size|-s <width> <height>]" << std::endl;
+    std::cout << "                [--rotation|-r <axis x> <axis y> <axis z> <degrees>] [--view <16 floats, row-major>]" << std::endl;
+    std::cout << "                [--fov|-f <left> <right> <up> <down> (degrees)] [--projection <16 floats, row-major>]" << std::endl;
+    std::cout << "                [--coverage|-c subsamples|analytic|adaptive] [--tolerance <levels>] [--summed-area-table|-a <min footprint texels>]" << std::endl;
+    std::cout << "                [--threads|-j <count, 0 = all>] [--progressive|-p] [--cache <directory> [--cache-size <MiB>]]" << std::endl;
+    std::cout << "--progressive also writes the cheaper passes before the final one, as <output>_pass<N>.png." << std::endl;
+    std::cout << "Matrices use row vectors like DirectXMath, an XrMatrix4x4f can be passed in memory order." << std::endl;
+}
+
+bool ParseCommandLine(RenderOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+    auto getNextFloat = [&] { return std::stof(getNextArg()); };
+    auto getNextMatrix = [&] {
+        Matrix4 matrix;
+        for (int element = 0; element < 16; element++)
+        {
+            matrix.m[element / 4][element % 4] = getNextFloat();
+        }
+        return matrix;
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePath = getNextArg();
+        }
+        else if (arg == "--output" || arg == "-o")
+        {
+            options.outputPath = getNextArg();
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.width = std::stoul(getNextArg());
+            options.height = std::stoul(getNextArg());
+        }
+        else if (arg == "--rotation" || arg == "-r")
+        {
+            Vector3 axis;
+            axis.x = getNextFloat();
+            axis.y = getNextFloat();
+            axis.z = getNextFloat();
+            options.spaceToView = RotationAxis(axis, getNextFloat() * RENDER_PI / 180.f);
+        }
+        else if (arg == "--view")
+        {
+            options.spaceToView = getNextMatrix();
+        }
+        else if (arg == "--fov" || arg == "-f")
+        {
+            for (float& angle : options.fovDegrees) angle = getNextFloat();
+        }
+        else if (arg == "--projection")
+        {
+            options.projection = getNextMatrix();
+            options.hasProjection = true;
+        }
+        else if (arg == "--coverage" || arg == "-c")
+        {
+            const std::string mode = getNextArg();
+            if (mode == "subsamples") options.settings.coverage = CoverageMode::Subsamples;
+            else if (mode == "analytic") options.settings.coverage = CoverageMode::Analytic;
+            else if (mode == "adaptive") options.settings.coverage = CoverageMode::Adaptive;
+            else throw std::invalid_argument("Unknown coverage mode: " + mode);
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.settings.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--tolerance")
+        {
+            options.settings.adaptiveTolerance = getNextFloat();
+        }
+        else if (arg == "--summed-area-table" || arg == "-a")
+        {
+            options.useSummedAreaTable = true;
+            options.settings.summedAreaTableMinTexels = getNextFloat();
+        }
+        else if (arg == "--progressive" || arg == "-p")
+        {
+            options.progressive = true;
+        }
+        else if (arg == "--cache")
+        {
+            options.cacheDirectory = getNextArg();
+        }
+        else if (arg == "--cache-size")
+        {
+            options.cacheMegabytes = std::stoull(getNextArg());
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    if (options.texturePath.empty())
+    {
+        std::cout << "Texture parameter is required" << std::endl;
+        ShowHelp();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    RenderOptions options{};
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+    ArenaRegistry::PrintReportAtExit();
+
+    ReferenceView view{};
+    view.spaceToView = options.spaceToView;
+    view.screenWidth = options.width;
+    view.screenHeight = options.height;
+    if (options.hasProjection)
+    {
+        view.projection = options.projection;
+    }
+    else
+    {
+        const float toRadians = RENDER_PI / 180.f;
+        view.projection = ProjectionFov(options.fovDegrees[0] * toRadians, options.fovDegrees[1] * toRadians,
+            options.fovDegrees[2] * toRadians, options.fovDegrees[3] * toRadians, 0.05f, 100.f);
+    }
+
+    int channelCount;
+    SphereTexture texture{};
+    uint8_t* textureData = stbi_load(options.texturePath.c_str(), &texture.width, &texture.height, &channelCount, 3);
+    if (textureData == nullptr)
+    {
+        std::cout << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    texture.data = textureData;
+
+    MemoryArena arena{ "RenderReference" };
+
+    // Only the presence of the table is part of the cache key, it is filled in below on a miss
+    SummedAreaTable summedAreaTable{};
+    if (options.useSummedAreaTable)
+    {
+        options.settings.summedAreaTable = &summedAreaTable;
+    }
+
+    auto writeImage = [&](const std::string& path, const uint8_t* image) {
+        if (!stbi_write_png(path.c_str(), view.screenWidth, view.screenHeight, 3, image, view.screenWidth * 3))
+        {
+            std::cout << "Failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    std::unique_ptr<ReferenceCache> cache;
+    ReferenceCacheKey cacheKey{};
+    if (!options.cacheDirectory.empty())
+    {
+        cache = std::make_unique<ReferenceCache>(options.cacheDirectory, options.cacheMegabytes * 1024 * 1024);
+        cacheKey = MakeReferenceCacheKey(HashSphereTexture(texture), view, options.settings);
+        uint8_t* cached = NewArray(arena, uint8_t, view.screenWidth * view.screenHeight * 3);
+        if (cache->Load(cacheKey, view.screenWidth, view.screenHeight, cached))
+        {
+            std::cout << "Cache hit " << cacheKey.ToString() << std::endl;
+            stbi_image_free(textureData);
+            return writeImage(options.outputPath, cached) ? 0 : 1;
+        }
+    }
+
+    // Separate arena, an 8k texture needs about 400MB of sums
+    MemoryArena tableArena{ "SummedAreaTable", 4ull * 1024 * 1024 * 1024 };
+    if (options.useSummedAreaTable)
+    {
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        summedAreaTable = CreateSummedAreaTable(tableArena, texture, options.settings.threadCount);
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        auto measureDuration = std::chrono::duration_cast<std::chrono::milliseconds>(measureEnd - measureStart);
+        std::cout << "Summed area table finished in: " << measureDuration.count() << "ms" << std::endl;
+    }
+
+    SchedulerStatistics statistics{};
+    options.settings.statistics = &statistics;
+
+    auto measureStart = std::chrono::high_resolution_clock::now();
+    uint8_t* image;
+    if (options.progressive)
+    {
+        const size_t extension = options.outputPath.rfind('.');
+        const std::string stem = options.outputPath.substr(0, extension);
+        const std::string suffix = extension == std::string::npos ? ".png" : options.outputPath.substr(extension);
+
+        image = CreatePerfectFilteredImageProgressive(arena, texture, view, options.settings, [&](int pass, int passCount, const uint8_t* passImage) {
+            auto passEnd = std::chrono::high_resolution_clock::now();
+            auto passDuration = std::chrono::duration_cast<std::chrono::milliseconds>(passEnd - measureStart);
+            std::cout << "Pass " << pass + 1 << "/" << passCount << " finished after: " << passDuration.count() << "ms" << std::endl;
+            if (pass + 1 < passCount)
+            {
+                writeImage(stem + "_pass" + std::to_string(pass) + suffix, passImage);
+            }
+        });
+    }
+    else
+    {
+        image = CreatePerfectFilteredImage(arena, texture, view, options.settings);
+    }
+    auto measureEnd = std::chrono::high_resolution_clock::now();
+    auto measureDuration = std::chrono::duration_cast<std::chrono::milliseconds>(measureEnd - measureStart);
+    std::cout << "Render finished in: " << measureDuration.count() << "ms" << std::endl;
+    PrintSchedulerStatistics(statistics);
+
+    stbi_image_free(textureData);
+    if (image == nullptr) return 1;
+
+    if (cache != nullptr)
+    {
+        cache->Store(cacheKey, view.screenWidth, view.screenHeight, image);
+    }
+
+    return writeImage(options.outputPath, image) ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+#include "../src/BatchRenderer.h"
+#include "../src/PoseTrace.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+struct BatchOptions
+{
+    std::string texturePath;
+    std::string posesPath;
+    std::string outputDirectory = ".";
+    size_t width = 1024;
+    size_t height = 1024;
+    RenderSettings settings{};
+    bool useSummedAreaTable = false;
+    std::string cacheDirectory;
+    uint64_t cacheMegabytes = 4096;
+};
+
+void ShowHelp()
+{
+    std::cout << "RenderReferenceBatch --texture|-t <equirect image> --poses|-p <pose trace> [--output|-o <directory>] [--size|-s <width> <height>]" << std::endl;
+    std::cout << "                     [--coverage|-c subsamples|analytic|adaptive] [--tolerance <levels>] [--summed-area-table|-a <min footprint texels>]" << std::endl;
+    std::cout << "                     [--threads|-j <count, 0 = all>] [--cache <directory> [--cache-size <MiB>]]" << std::endl;
+    std::cout << "Renders one reference image per line of the pose trace, written as view_<line index>.png." << std::endl;
+    std::cout << "Pose trace lines: <time> <eye> <px> <py> <pz> <qx> <qy> <qz> <qw> <angle left> <angle right> <angle up> <angle down> (radians)" << std::endl;
+}
+
+bool ParseCommandLine(BatchOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePath = getNextArg();
+        }
+        else if (arg == "--poses" || arg == "-p")
+        {
+            options.posesPath = getNextArg();
+        }
+        else if (arg == "--output" || arg == "-o")
+        {
+            options.outputDirectory = getNextArg();
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.width = std::stoul(getNextArg());
+            options.height = std::stoul(getNextArg());
+        }
+        else if (arg == "--coverage" || arg == "-c")
+        {
+            const std::string mode = getNextArg();
+            if (mode == "subsamples") options.settings.coverage = CoverageMode::Subsamples;
+            else if (mode == "analytic") options.settings.coverage = CoverageMode::Analytic;
+            else if (mode == "adaptive") options.settings.coverage = CoverageMode::Adaptive;
+            else throw std::invalid_argument("Unknown coverage mode: " + mode);
+        }
+        else if (arg == "--tolerance")
+        {
+            options.settings.adaptiveTolerance = std::stof(getNextArg());
+        }
+        else if (arg == "--summed-area-table" || arg == "-a")
+        {
+            options.useSummedAreaTable = true;
+            options.settings.summedAreaTableMinTexels = std::stof(getNextArg());
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.settings.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--cache")
+        {
+            options.cacheDirectory = getNextArg();
+        }
+        else if (arg == "--cache-size")
+        {
+            options.cacheMegabytes = std::stoull(getNextArg());
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    if (options.texturePath.empty() || options.posesPath.empty())
+    {
+        std::cout << "Texture and poses parameters are required" << std::endl;
+        ShowHelp();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    BatchOptions options{};
+    std::vector<PoseSample> poses;
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+        poses = LoadPoseTrace(options.posesPath);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+    ArenaRegistry::PrintReportAtExit();
+
+    std::vector<ReferenceView> views;
+    for (const PoseSample& pose : poses)
+    {
+        views.push_back(ViewFromPoseSample(pose, options.width, options.height));
+    }
+
+    std::error_code directoryError;
+    std::filesystem::create_directories(options.outputDirectory, directoryError);
+
+    auto measureStart = std::chrono::high_resolution_clock::now();
+
+    // The texture is decoded and prepared once, every view only reads it
+    int channelCount;
+    SphereTexture texture{};
+    uint8_t* textureData = stbi_load(options.texturePath.c_str(), &texture.width, &texture.height, &channelCount, 3);
+    if (textureData == nullptr)
+    {
+        std::cout << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    texture.data = textureData;
+
+    MemoryArena textureArena{ "PreparedTexture", 4ull * 1024 * 1024 * 1024 };
+    const PreparedTexture prepared = PrepareTexture(textureArena, texture, options.useSummedAreaTable, options.settings.threadCount);
+    stbi_image_free(textureData);
+
+    auto prepareEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Texture prepared in: " << std::chrono::duration_cast<std::chrono::milliseconds>(prepareEnd - measureStart).count() << "ms" << std::endl;
+
+    SchedulerStatistics statistics{};
+    options.settings.statistics = &statistics;
+
+    // Views are written as soon as they finish, nothing but the views in flight is kept in memory
+    std::mutex outputMutex;
+    size_t finishedCount = 0;
+    size_t failedCount = 0;
+    std::unique_ptr<ReferenceCache> cache;
+    if (!options.cacheDirectory.empty())
+    {
+        cache = std::make_unique<ReferenceCache>(options.cacheDirectory, options.cacheMegabytes * 1024 * 1024);
+    }
+
+    const size_t cacheHitCount = RenderReferenceBatch(prepared, views, options.settings, [&](size_t viewIndex, const uint8_t* image) {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "view_%05zu.png", viewIndex);
+        const std::string path = (std::filesystem::path(options.outputDirectory) / fileName).string();
+        const bool written = stbi_write_png(path.c_str(), options.width, options.height, 3, image, options.width * 3);
+
+        std::lock_guard lock{ outputMutex };
+        finishedCount++;
+        if (!written)
+        {
+            failedCount++;
+            std::cout << "Failed to write " << path << std::endl;
+        }
+        else
+        {
+            std::cout << "\r" << finishedCount << "/" << views.size() << " views" << std::flush;
+        }
+    }, cache.get());
+    std::cout << std::endl;
+
+    auto measureEnd = std::chrono::high_resolution_clock::now();
+    auto renderDuration = std::chrono::duration<double, std::milli>(measureEnd - prepareEnd).count();
+    std::cout << "Rendered " << views.size() << " views in: " << static_cast<long long>(renderDuration) << "ms ("
+        << (renderDuration > 0. ? views.size() * 1000. / renderDuration : 0.) << " views/s)" << std::endl;
+    if (cache != nullptr)
+    {
+        std::cout << "Cache hits: " << cacheHitCount << "/" << views.size() << ", cache size " << cache->GetSizeBytes() / (1024 * 1024) << "MiB" << std::endl;
+    }
+    PrintSchedulerStatistics(statistics);
+
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include "BatchRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+PreparedTexture PrepareTexture(MemoryArena& arena, const SphereTexture& texture, bool buildSummedAreaTable, int threadCount)
+{
+    PreparedTexture prepared{};
+    prepared.textureHash = HashSphereTexture(texture);
+    prepared.texture = LinearizeSphereTexture(arena, texture, threadCount);
+    if (buildSummedAreaTable)
+    {
+        prepared.summedAreaTable = std::make_shared<PreparedSummedAreaTable>();
+        prepared.summedAreaTable->arena = &arena;
+        prepared.summedAreaTable->threadCount = threadCount;
+    }
+    return prepared;
+}
+
+const SummedAreaTable& GetSummedAreaTable(const PreparedTexture& prepared)
+{
+    PreparedSummedAreaTable& lazyTable = *prepared.summedAreaTable;
+    std::call_once(lazyTable.built, [&] {
+        lazyTable.table = CreateSummedAreaTable(*lazyTable.arena, prepared.texture, lazyTable.threadCount);
+    });
+    return lazyTable.table;
+}
+
+size_t RenderReferenceBatch(const PreparedTexture& texture, const std::vector<ReferenceView>& views, const RenderSettings& settings, const BatchViewCallback& onView, ReferenceCache* cache)
+{
+    if (views.empty()) return 0;
+
+    int threadCount = settings.threadCount;
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    const int viewThreadCount = static_cast<int>(std::min<size_t>(views.size(), threadCount));
+
+    RenderSettings viewSettings = settings;
+    viewSettings.threadCount = std::max(1, threadCount / viewThreadCount);
+    // Only the presence of the table is part of the cache key, it is filled in on the first miss
+    viewSettings.summedAreaTable = texture.summedAreaTable ? &texture.summedAreaTable->table : settings.summedAreaTable;
+    viewSettings.statistics = nullptr;
+
+    std::vector<std::unique_ptr<MemoryArena>> arenas;
+    for (int thread = 0; thread < viewThreadCount; thread++)
+    {
+        arenas.push_back(std::make_unique<MemoryArena>("BatchView"));
+    }
+
+    std::atomic<size_t> cacheHitCount = 0;
+    RunTiles(views.size(), viewThreadCount, [&](size_t viewIndex, int thread) {
+        MemoryArena& arena = *arenas[thread];
+        const ReferenceView& view = views[viewIndex];
+
+        ReferenceCacheKey key{};
+        if (cache != nullptr)
+        {
+            key = MakeReferenceCacheKey(texture.textureHash, view, viewSettings);
+            uint8_t* cached = NewArray(arena, uint8_t, view.screenWidth * view.screenHeight * 3);
+            if (cache->Load(key, view.screenWidth, view.screenHeight, cached))
+            {
+                cacheHitCount++;
+                onView(viewIndex, cached);
+                arena.Reset();
+                return;
+            }
+        }
+
+        if (texture.summedAreaTable) GetSummedAreaTable(texture);
+        const uint8_t* image = CreatePerfectFilteredImage(arena, texture.texture, view, viewSettings);
+        if (image != nullptr)
+        {
+            if (cache != nullptr) cache->Store(key, view.screenWidth, view.screenHeight, image);
+            onView(viewIndex, image);
+        }
+        arena.Reset();
+    }, settings.statistics);
+    return cacheHitCount;
+}
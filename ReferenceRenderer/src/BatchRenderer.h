@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ReferenceCache.h"
+#include "ReferenceRenderer.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Summed area table of a prepared texture, built on first use, so a batch served entirely from the cache never pays
+// for it.
+struct PreparedSummedAreaTable
+{
+    std::once_flag built;
+    MemoryArena* arena = nullptr;
+    int threadCount = 0;
+    SummedAreaTable table{};
+};
+
+// Everything that only depends on the texture, prepared once and shared read-only by every view of a batch.
+struct PreparedTexture
+{
+    SphereTexture texture{};
+
+    // Only set when a table was asked for, use GetSummedAreaTable to get it filled in.
+    std::shared_ptr<PreparedSummedAreaTable> summedAreaTable;
+
+    // HashSphereTexture of the texture as it was passed in, for cache keys.
+    uint64_t textureHash = 0;
+};
+
+// Hashes and linearizes the texture, allocated in the arena. With buildSummedAreaTable the table is built in the same
+// arena by the first GetSummedAreaTable call, so the arena must outlive the prepared texture.
+PreparedTexture PrepareTexture(MemoryArena& arena, const SphereTexture& texture, bool buildSummedAreaTable, int threadCount = 0);
+
+// Builds the summed area table on the first call, concurrent calls wait for it. Only for textures prepared with one.
+const SummedAreaTable& GetSummedAreaTable(const PreparedTexture& prepared);
+
+// Receives every finished view as soon as it is done, concurrently from several worker threads and in no particular order.
+// The image is only valid during the call.
+using BatchViewCallback = std::function<void(size_t viewIndex, const uint8_t* image)>;
+
+// Renders all views of one texture. With more views than threads every thread renders whole views on its own,
+// otherwise the threads are split between the views. Every worker reuses one arena, so memory stays bounded
+// by the largest view no matter how many views there are.
+// settings.summedAreaTable is replaced by the one of the prepared texture, which is built on the first view that is not
+// in the cache. settings.statistics receives the view-level run.
+// With a cache, views found in it are loaded instead of rendered and rendered views are added to it.
+// Returns the number of views served from the cache.
+size_t RenderReferenceBatch(const PreparedTexture& texture, const std::vector<ReferenceView>& views, const RenderSettings& settings, const BatchViewCallback& onView, ReferenceCache* cache = nullptr);
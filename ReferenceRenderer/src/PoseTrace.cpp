@@ -0,0 +1,63 @@
+#include "PoseTrace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<PoseSample> ReadPoseTrace(std::istream& in)
+{
+    std::vector<PoseSample> samples;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        PoseSample sample{};
+        std::istringstream fields{ line };
+        fields >> sample.time >> sample.eye
+            >> sample.position.x >> sample.position.y >> sample.position.z
+            >> sample.orientation.x >> sample.orientation.y >> sample.orientation.z >> sample.orientation.w
+            >> sample.angleLeft >> sample.angleRight >> sample.angleUp >> sample.angleDown;
+        std::string rest;
+        if (fields.fail() || (fields >> rest))
+        {
+            throw std::runtime_error("Malformed pose on line " + std::to_string(lineNumber) + ", expected 13 values");
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+std::vector<PoseSample> LoadPoseTrace(const std::string& path)
+{
+    std::ifstream file{ path };
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open pose trace " + path);
+    }
+    return ReadPoseTrace(file);
+}
+
+void WritePoseSample(std::ostream& out, const PoseSample& sample)
+{
+    // 9 significant digits round-trip every float
+    out << std::setprecision(9) << sample.time << ' ' << sample.eye << ' '
+        << sample.position.x << ' ' << sample.position.y << ' ' << sample.position.z << ' '
+        << sample.orientation.x << ' ' << sample.orientation.y << ' ' << sample.orientation.z << ' ' << sample.orientation.w << ' '
+        << sample.angleLeft << ' ' << sample.angleRight << ' ' << sample.angleUp << ' ' << sample.angleDown << '\n';
+}
+
+ReferenceView ViewFromPoseSample(const PoseSample& sample, size_t screenWidth, size_t screenHeight, float nearZ, float farZ)
+{
+    ReferenceView view{};
+    view.spaceToView = Inverse(Multiply(RotationQuaternion(sample.orientation), Translation(sample.position)));
+    view.projection = ProjectionFov(sample.angleLeft, sample.angleRight, sample.angleUp, sample.angleDown, nearZ, farZ);
+    view.screenWidth = screenWidth;
+    view.screenHeight = screenHeight;
+    return view;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ReferenceRenderer.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One eye of one frame: where the view was and what it saw, in the layout of XrView (pose in the reference space,
+// fov angles in radians, left and down negative).
+struct PoseSample
+{
+    double time = 0.;
+    int eye = 0;
+    Vector3 position{};
+    Quaternion orientation{};
+    float angleLeft = -RENDER_PI / 4.f;
+    float angleRight = RENDER_PI / 4.f;
+    float angleUp = RENDER_PI / 4.f;
+    float angleDown = -RENDER_PI / 4.f;
+};
+
+// Text format, one sample per line, '#' starts a comment:
+//   <time s since trace start> <eye> <px> <py> <pz> <qx> <qy> <qz> <qw> <angle left> <angle right> <angle up> <angle down>
+// Hand-written pose lists can use 0 for time and eye.
+// Throws std::runtime_error with the line number on malformed lines.
+std::vector<PoseSample> ReadPoseTrace(std::istream& in);
+std::vector<PoseSample> LoadPoseTrace(const std::string& path);
+
+void WritePoseSample(std::ostream& out, const PoseSample& sample);
+
+// View matrix (inverse of the pose) and D3D projection of the sample, like the viewer builds them for rendering.
+ReferenceView ViewFromPoseSample(const PoseSample& sample, size_t screenWidth, size_t screenHeight, float nearZ = 0.05f, float farZ = 100.f);
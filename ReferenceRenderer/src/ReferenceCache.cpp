@@ -0,0 +1,228 @@
+#include "ReferenceCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// MurmurHash64A, fast enough to hash 8k textures in a fraction of the render time
+static uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint64_t multiplier = 0xc6a4a7935bd1e995ull;
+    const int shift = 47;
+
+    uint64_t hash = seed ^ (size * multiplier);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t blockCount = size / 8;
+    for (size_t block = 0; block < blockCount; block++)
+    {
+        uint64_t k;
+        memcpy(&k, bytes + block * 8, 8);
+        k *= multiplier;
+        k ^= k >> shift;
+        k *= multiplier;
+        hash ^= k;
+        hash *= multiplier;
+    }
+
+    const uint8_t* tail = bytes + blockCount * 8;
+    switch (size & 7)
+    {
+    case 7: hash ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+    case 6: hash ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+    case 5: hash ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+    case 4: hash ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+    case 3: hash ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+    case 2: hash ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+    case 1: hash ^= static_cast<uint64_t>(tail[0]);
+            hash *= multiplier;
+    }
+
+    hash ^= hash >> shift;
+    hash *= multiplier;
+    hash ^= hash >> shift;
+    return hash;
+}
+
+std::string ReferenceCacheKey::ToString() const
+{
+    char text[33];
+    snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+    return text;
+}
+
+uint64_t HashSphereTexture(const SphereTexture& texture)
+{
+    const uint64_t dimensions[2] = { static_cast<uint64_t>(texture.width), static_cast<uint64_t>(texture.height) };
+    uint64_t hash = HashBytes(dimensions, sizeof(dimensions), 0);
+    if (texture.data == nullptr) return hash;
+
+    // Rows are hashed separately so the hash does not depend on a single 200MB pass, then combined in order
+    const size_t rowSize = static_cast<size_t>(texture.width) * 3;
+    std::vector<uint64_t> rowHashes(texture.height);
+    RunTiles(texture.height, 0, [&](size_t y, int) {
+        rowHashes[y] = HashBytes(&texture.data[y * rowSize], rowSize, y);
+    });
+    return HashBytes(rowHashes.data(), rowHashes.size() * sizeof(uint64_t), hash);
+}
+
+ReferenceCacheKey MakeReferenceCacheKey(uint64_t textureHash, const ReferenceView& view, const RenderSettings& settings)
+{
+    // Only what changes the output, thread count and statistics do not
+    struct KeyData
+    {
+        uint64_t textureHash;
+        uint32_t rendererVersion;
+        uint32_t coverage;
+        float spaceToView[16];
+        float projection[16];
+        uint64_t screenWidth;
+        uint64_t screenHeight;
+        float adaptiveTolerance;
+        float summedAreaTableMinTexels;
+    } data;
+    memset(&data, 0, sizeof(data));
+    data.textureHash = textureHash;
+    data.rendererVersion = ReferenceRendererVersion;
+    data.coverage = static_cast<uint32_t>(settings.coverage);
+    memcpy(data.spaceToView, view.spaceToView.m, sizeof(data.spaceToView));
+    memcpy(data.projection, view.projection.m, sizeof(data.projection));
+    data.screenWidth = view.screenWidth;
+    data.screenHeight = view.screenHeight;
+    data.adaptiveTolerance = settings.coverage == CoverageMode::Adaptive ? settings.adaptiveTolerance : 0.f;
+    data.summedAreaTableMinTexels = settings.summedAreaTable != nullptr ? settings.summedAreaTableMinTexels : -1.f;
+
+    ReferenceCacheKey key{};
+    key.low = HashBytes(&data, sizeof(data), 0x5265664361636865ull);
+    key.high = HashBytes(&data, sizeof(data), key.low);
+    return key;
+}
+
+// Header of every cache file, followed by width * height * 3 bytes of RGB
+struct CacheFileHeader
+{
+    char magic[4];
+    uint32_t rendererVersion;
+    uint64_t keyLow;
+    uint64_t keyHigh;
+    uint32_t width;
+    uint32_t height;
+};
+static const char CacheFileMagic[4] = { 'R', 'R', 'E', 'F' };
+static const char* CacheFileExtension = ".rref";
+
+ReferenceCache::ReferenceCache(const std::string& directory, uint64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+    for (const auto& file : std::filesystem::recursive_directory_iterator(this->directory, error))
+    {
+        if (!file.is_regular_file(error) || file.path().extension() != CacheFileExtension) continue;
+        const Entry entry = { file.file_size(error), file.last_write_time(error) };
+        entries[file.path()] = entry;
+        totalBytes += entry.size;
+    }
+    Evict();
+}
+
+std::filesystem::path ReferenceCache::EntryPath(const ReferenceCacheKey& key) const
+{
+    // Two character fan out keeps directories small with many thousands of entries
+    const std::string name = key.ToString();
+    return directory / name.substr(0, 2) / (name + CacheFileExtension);
+}
+
+bool ReferenceCache::Load(const ReferenceCacheKey& key, size_t width, size_t height, uint8_t* outImage)
+{
+    const std::filesystem::path path = EntryPath(key);
+    std::ifstream file{ path, std::ios::binary };
+    if (!file) return false;
+
+    CacheFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || memcmp(header.magic, CacheFileMagic, sizeof(CacheFileMagic)) != 0
+        || header.rendererVersion != ReferenceRendererVersion || header.keyLow != key.low || header.keyHigh != key.high
+        || header.width != width || header.height != height)
+    {
+        return false;
+    }
+    file.read(reinterpret_cast<char*>(outImage), width * height * 3);
+    if (!file) return false;
+    file.close();
+
+    std::lock_guard lock{ mutex };
+    std::error_code error;
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(path, now, error);
+    auto entry = entries.find(path);
+    if (entry != entries.end()) entry->second.lastUse = now;
+    return true;
+}
+
+void ReferenceCache::Store(const ReferenceCacheKey& key, size_t width, size_t height, const uint8_t* image)
+{
+    const std::filesystem::path path = EntryPath(key);
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    CacheFileHeader header{};
+    memcpy(header.magic, CacheFileMagic, sizeof(CacheFileMagic));
+    header.rendererVersion = ReferenceRendererVersion;
+    header.keyLow = key.low;
+    header.keyHigh = key.high;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+
+    // Unique temporary name per thread, readers never see a partially written entry
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(image), width * height * 3);
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return;
+    }
+
+    std::lock_guard lock{ mutex };
+    const Entry entry = { sizeof(header) + width * height * 3, std::filesystem::file_time_type::clock::now() };
+    auto existing = entries.find(path);
+    if (existing != entries.end()) totalBytes -= existing->second.size;
+    entries[path] = entry;
+    totalBytes += entry.size;
+    Evict();
+}
+
+uint64_t ReferenceCache::GetSizeBytes()
+{
+    std::lock_guard lock{ mutex };
+    return totalBytes;
+}
+
+void ReferenceCache::Evict()
+{
+    while (totalBytes > maxBytes && !entries.empty())
+    {
+        auto oldest = entries.begin();
+        for (auto entry = entries.begin(); entry != entries.end(); entry++)
+        {
+            if (entry->second.lastUse < oldest->second.lastUse) oldest = entry;
+        }
+        std::error_code error;
+        std::filesystem::remove(oldest->first, error);
+        totalBytes -= oldest->second.size;
+        entries.erase(oldest);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ReferenceRenderer.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Bumped whenever a change to the renderer alters its output, so old cache entries are never returned for new code.
+constexpr uint32_t ReferenceRendererVersion = 7;
+
+// 128 bit digest of everything that determines a reference image.
+struct ReferenceCacheKey
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    std::string ToString() const;
+};
+
+// Hash of the texture dimensions and raw texels (before linearization). Computed once per texture.
+uint64_t HashSphereTexture(const SphereTexture& texture);
+
+// Combines the texture hash with view, projection, resolution, renderer version and the settings that change the output.
+ReferenceCacheKey MakeReferenceCacheKey(uint64_t textureHash, const ReferenceView& view, const RenderSettings& settings);
+
+// Content addressed store of finished reference images on disk, one file per key: a small header followed by the raw RGB
+// pixels. Entries beyond maxBytes are evicted least recently used first, where use is the file time, so the order
+// survives restarts. Safe to use from several threads, entries are written to a temporary file and renamed into place.
+class ReferenceCache
+{
+public:
+    ReferenceCache(const std::string& directory, uint64_t maxBytes);
+
+    // Copies the cached image into outImage (width * height * 3 bytes). False on a miss or a damaged entry.
+    bool Load(const ReferenceCacheKey& key, size_t width, size_t height, uint8_t* outImage);
+    void Store(const ReferenceCacheKey& key, size_t width, size_t height, const uint8_t* image);
+
+    uint64_t GetSizeBytes();
+
+private:
+    struct Entry
+    {
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    std::filesystem::path EntryPath(const ReferenceCacheKey& key) const;
+    void Evict();
+
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+    std::mutex mutex;
+    std::map<std::filesystem::path, Entry> entries;
+    uint64_t totalBytes = 0;
+};
@@ -0,0 +1,1155 @@
+#include "ReferenceRenderer.h"
+#include "TileScheduler.h"
+
+#include <SphereMapping.h>
+#include <VectorMath.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDER_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RENDER_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Output pixels are rendered in square tiles of this size, the unit of work stealing.
+constexpr size_t RenderTileSize = 32;
+
+// Subsamples per texel along each axis of the reference (CoverageMode::Subsamples) result.
+constexpr size_t SubSampleCount = 8;
+
+// Bounds stop this far before the texture edge, so the last subsample row of even the densest grid stays inside.
+constexpr float SubSampleEdgeEpsilon = 1.f / 64.f;
+
+// Sparsest subsample density the adaptive mode starts from. Densities are powers of two up to SubSampleCount, so
+// subsample positions stay exact floats.
+constexpr size_t MinAdaptiveSubSampleCount = 1;
+
+// Subsample (of the SubSampleCount grid) every adaptive density goes through, so each density holds every other
+// subsample of the next one.
+constexpr size_t AdaptiveLatticeOrigin = 2;
+
+// Writes up to two intersections in front of the ray start and returns how many there are.
+static int RaySphereIntersection(Vector3 rayStart, Vector3 rayDirection, Vector3 sphereCenter, float sphereRadius, Vector3 outIntersections[2])
+{
+    int intersectionCount = 0;
+
+    Vector3 raySphereOffset = rayStart - sphereCenter;
+
+    float a = Dot(rayDirection, rayDirection);
+    float b = 2.f * Dot(rayDirection, raySphereOffset);
+    float c = Dot(raySphereOffset, raySphereOffset) - sphereRadius * sphereRadius;
+    float discriminant = b * b - 4.f * a * c;
+
+    if (discriminant == 0.f) // TODO: use epsilon?
+    {
+        float t = -b / (2.f * a);
+        if (t >= 0.f)
+        {
+            outIntersections[intersectionCount++] = rayStart + rayDirection * t;
+        }
+    }
+    else if (discriminant > 0.f)
+    {
+        float t1 = (-b + sqrtf(discriminant)) / (2.f * a);
+        if (t1 >= 0.f)
+        {
+            outIntersections[intersectionCount++] = rayStart + rayDirection * t1;
+        }
+
+        float t2 = (-b - sqrtf(discriminant)) / (2.f * a);
+        if (t2 >= 0.f)
+        {
+            outIntersections[intersectionCount++] = rayStart + rayDirection * t2;
+        }
+    }
+    return intersectionCount;
+}
+
+// Orders a and b by y. Written with selects instead of a branch so the compiler can use conditional moves.
+static inline void CompareSwapY(Vector2& a, Vector2& b)
+{
+    const bool swap = b.y < a.y;
+    const Vector2 low = swap ? b : a;
+    const Vector2 high = swap ? a : b;
+    a = low;
+    b = high;
+}
+
+// Optimal sorting network for four elements.
+static inline void SortByY(Vector2 vertices[4])
+{
+    CompareSwapY(vertices[0], vertices[1]);
+    CompareSwapY(vertices[2], vertices[3]);
+    CompareSwapY(vertices[0], vertices[2]);
+    CompareSwapY(vertices[1], vertices[3]);
+    CompareSwapY(vertices[1], vertices[2]);
+}
+
+// Edge function of one triangle edge e1->e2 along a subsample row, E(px) = (px - e1.x) * (e2.y - e1.y) - (py - e1.y) * (e2.x - e1.x).
+// E > 0 means the subsample is on the positive side, E < 0 on the negative side and E == 0 on the edge.
+// Texture space has y pointing down and the footprint can be mirrored, so a subsample is inside when all three agree on either side.
+struct EdgeRow
+{
+    float originX;
+    float slope;
+    float rowOffset;
+};
+
+// The edges of both footprint triangles for one subsample row, three per triangle.
+struct FootprintRow
+{
+    EdgeRow edges[6];
+};
+
+static FootprintRow SetupFootprintRow(const Vector2 triangles[2][3], float py)
+{
+    FootprintRow row;
+    for (int triangle = 0; triangle < 2; triangle++)
+    {
+        for (int edge = 0; edge < 3; edge++)
+        {
+            const Vector2& e1 = triangles[triangle][edge];
+            const Vector2& e2 = triangles[triangle][(edge + 1) % 3];
+            row.edges[triangle * 3 + edge] = { e1.x, e2.y - e1.y, (py - e1.y) * (e2.x - e1.x) };
+        }
+    }
+    return row;
+}
+
+// Conservative x range in which the subsample row at py can touch the triangles, false if it misses them.
+// The edge functions still decide per subsample, so the span only has to contain every covered one.
+static bool FootprintRowSpan(const Vector2 triangles[2][3], float py, size_t subSampleCount, float& outMinX, float& outMaxX)
+{
+    const float padding = 1.f / subSampleCount;
+    outMinX = INFINITY;
+    outMaxX = -INFINITY;
+    for (int triangle = 0; triangle < 2; triangle++)
+    {
+        for (int edge = 0; edge < 3; edge++)
+        {
+            const Vector2& a = triangles[triangle][edge];
+            const Vector2& b = triangles[triangle][(edge + 1) % 3];
+            const float edgeMinX = std::min(a.x, b.x);
+            const float edgeMaxX = std::max(a.x, b.x);
+            if (py < std::min(a.y, b.y) - padding || py > std::max(a.y, b.y) + padding) continue;
+
+            float x = a.y == b.y ? a.x : a.x + (py - a.y) * (b.x - a.x) / (b.y - a.y);
+            x = std::clamp(x, edgeMinX, edgeMaxX);
+            outMinX = std::min(outMinX, a.y == b.y ? edgeMinX : x);
+            outMaxX = std::max(outMaxX, a.y == b.y ? edgeMaxX : x);
+        }
+    }
+    outMinX -= padding;
+    outMaxX += padding;
+    return outMinX <= outMaxX;
+}
+
+// Bit mask of the subsamples in one texel row (starting at texelX, lane i at (i + offset) / subSampleCount) that lie
+// inside either triangle and within [firstX, lastX], the subsamples the pixel's bounding box covers. Vectors hold 4
+// subsamples, so the reference density of 8 takes two per texel row and densities below 4 mask the unused lanes.
+#if defined(RENDER_SIMD_SSE2)
+static inline __m128 EvaluateEdge(const EdgeRow& edge, __m128 px)
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(px, _mm_set1_ps(edge.originX)), _mm_set1_ps(edge.slope)), _mm_set1_ps(edge.rowOffset));
+}
+
+static inline __m128 InsideTriangleMask(const EdgeRow edges[3], __m128 px)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 e1 = EvaluateEdge(edges[0], px);
+    const __m128 e2 = EvaluateEdge(edges[1], px);
+    const __m128 e3 = EvaluateEdge(edges[2], px);
+    const __m128 positive = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)), _mm_cmpge_ps(e3, zero));
+    const __m128 negative = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(e1, zero), _mm_cmple_ps(e2, zero)), _mm_cmple_ps(e3, zero));
+    return _mm_or_ps(positive, negative);
+}
+
+static inline uint32_t CoveredSubsampleMask(const FootprintRow& row, float texelX, float firstX, float lastX, size_t subSampleCount, float offset)
+{
+    const __m128 subSampleSize = _mm_set1_ps(1.f / subSampleCount);
+    const __m128 laneCount = _mm_set1_ps(static_cast<float>(subSampleCount));
+    uint32_t mask = 0;
+    for (size_t firstLane = 0; firstLane < subSampleCount; firstLane += 4)
+    {
+        const __m128 lanes = _mm_add_ps(_mm_set1_ps(static_cast<float>(firstLane)), _mm_setr_ps(0.f, 1.f, 2.f, 3.f));
+        const __m128 px = _mm_add_ps(_mm_set1_ps(texelX), _mm_mul_ps(_mm_add_ps(lanes, _mm_set1_ps(offset)), subSampleSize));
+        const __m128 inBounds = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, _mm_set1_ps(firstX)), _mm_cmple_ps(px, _mm_set1_ps(lastX))), _mm_cmplt_ps(lanes, laneCount));
+        const __m128 covered = _mm_or_ps(InsideTriangleMask(&row.edges[0], px), InsideTriangleMask(&row.edges[3], px));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(covered, inBounds))) << firstLane;
+    }
+    return mask;
+}
+#elif defined(RENDER_SIMD_NEON)
+static inline float32x4_t EvaluateEdge(const EdgeRow& edge, float32x4_t px)
+{
+    return vsubq_f32(vmulq_f32(vsubq_f32(px, vdupq_n_f32(edge.originX)), vdupq_n_f32(edge.slope)), vdupq_n_f32(edge.rowOffset));
+}
+
+static inline uint32x4_t InsideTriangleMask(const EdgeRow edges[3], float32x4_t px)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t e1 = EvaluateEdge(edges[0], px);
+    const float32x4_t e2 = EvaluateEdge(edges[1], px);
+    const float32x4_t e3 = EvaluateEdge(edges[2], px);
+    const uint32x4_t positive = vandq_u32(vandq_u32(vcgeq_f32(e1, zero), vcgeq_f32(e2, zero)), vcgeq_f32(e3, zero));
+    const uint32x4_t negative = vandq_u32(vandq_u32(vcleq_f32(e1, zero), vcleq_f32(e2, zero)), vcleq_f32(e3, zero));
+    return vorrq_u32(positive, negative);
+}
+
+static inline uint32_t CoveredSubsampleMask(const FootprintRow& row, float texelX, float firstX, float lastX, size_t subSampleCount, float offset)
+{
+    const float laneIndices[4] = { 0.f, 1.f, 2.f, 3.f };
+    const uint32_t laneBitValues[4] = { 1, 2, 4, 8 };
+    const uint32x4_t laneBits = vld1q_u32(laneBitValues);
+    const float32x4_t subSampleSize = vdupq_n_f32(1.f / subSampleCount);
+    const float32x4_t laneCount = vdupq_n_f32(static_cast<float>(subSampleCount));
+    uint32_t mask = 0;
+    for (size_t firstLane = 0; firstLane < subSampleCount; firstLane += 4)
+    {
+        const float32x4_t lanes = vaddq_f32(vdupq_n_f32(static_cast<float>(firstLane)), vld1q_f32(laneIndices));
+        const float32x4_t px = vaddq_f32(vdupq_n_f32(texelX), vmulq_f32(vaddq_f32(lanes, vdupq_n_f32(offset)), subSampleSize));
+        const uint32x4_t inBounds = vandq_u32(vandq_u32(vcgeq_f32(px, vdupq_n_f32(firstX)), vcleq_f32(px, vdupq_n_f32(lastX))), vcltq_f32(lanes, laneCount));
+        const uint32x4_t covered = vorrq_u32(InsideTriangleMask(&row.edges[0], px), InsideTriangleMask(&row.edges[3], px));
+        mask |= vaddvq_u32(vandq_u32(vandq_u32(covered, inBounds), laneBits)) << firstLane;
+    }
+    return mask;
+}
+#else
+static inline bool InsideTriangle(const EdgeRow edges[3], float px)
+{
+    const float e1 = (px - edges[0].originX) * edges[0].slope - edges[0].rowOffset;
+    const float e2 = (px - edges[1].originX) * edges[1].slope - edges[1].rowOffset;
+    const float e3 = (px - edges[2].originX) * edges[2].slope - edges[2].rowOffset;
+    return (e1 >= 0.f && e2 >= 0.f && e3 >= 0.f) || (e1 <= 0.f && e2 <= 0.f && e3 <= 0.f);
+}
+
+static inline uint32_t CoveredSubsampleMask(const FootprintRow& row, float texelX, float firstX, float lastX, size_t subSampleCount, float offset)
+{
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < subSampleCount; lane++)
+    {
+        const float px = texelX + (static_cast<float>(lane) + offset) * (1.f / subSampleCount);
+        if (px < firstX || px > lastX) continue;
+        if (InsideTriangle(&row.edges[0], px) || InsideTriangle(&row.edges[3], px)) mask |= 1u << lane;
+    }
+    return mask;
+}
+#endif
+
+// Texel values in the working color space, truncated to 8 bit exactly like the per-sample pow() this replaces
+static void BuildGammaTable(uint8_t outTable[256])
+{
+    for (int value = 0; value < 256; value++)
+    {
+        outTable[value] = static_cast<uint8_t>(pow(static_cast<double>(value) / 255., 1. / 2.2) * 255.);
+    }
+}
+
+// Lookup applied to every texel read of this texture, identity once LinearizeSphereTexture applied the curve
+static void BuildTexelTable(const SphereTexture& texture, uint8_t outTable[256])
+{
+    if (!texture.linearized)
+    {
+        BuildGammaTable(outTable);
+        return;
+    }
+    for (int value = 0; value < 256; value++)
+    {
+        outTable[value] = static_cast<uint8_t>(value);
+    }
+}
+
+// Texture and color conversion shared by the footprint filters.
+struct FilterSource
+{
+    const uint8_t* data;
+    int width;
+    int height;
+    const uint8_t* gammaTable;
+};
+
+// Footprints crossing the u = 0/1 seam are moved to continue past the right edge, texel lookups wrap them back.
+static inline size_t WrapTexelX(size_t texelX, int width)
+{
+    return texelX >= static_cast<size_t>(width) ? texelX - width : texelX;
+}
+
+// Corners closer to a pole than this (in v) have no usable longitude, atan2 of a (nearly) zero vector.
+constexpr float PoleCornerTolerance = 1e-5f;
+
+// Replaces a footprint with one corner on a pole by the wedge of the cap between its two pixel edges. Those edges go
+// through the pole, so they are meridians: vertical lines at the longitude of the neighbouring corners. The wedge is
+// cut off at the depth that gives it the area of the real footprint, whose outer edges run to the opposite corner.
+static void ClipPoleCorner(Vector2 corners[4], int poleCorner, int width, float poleY)
+{
+    // Screen order: the opposite corner is the diagonal one, the other two share a pixel edge with the pole corner
+    const int oppositeCorner = 3 - poleCorner;
+    Vector2 left = corners[poleCorner ^ 1];
+    Vector2 right = corners[poleCorner ^ 2];
+    Vector2 opposite = corners[oppositeCorner];
+
+    // The wedge is less than half a turn wide, move the corners left of the seam past the right edge
+    const float halfWidth = width * .5f;
+    const float minX = std::min(std::min(left.x, right.x), opposite.x);
+    const float maxX = std::max(std::max(left.x, right.x), opposite.x);
+    if (maxX - minX > halfWidth)
+    {
+        for (Vector2* corner : { &left, &right, &opposite })
+        {
+            if (corner->x < halfWidth) corner->x += width;
+        }
+    }
+    if (left.x > right.x) std::swap(left, right);
+
+    // Area between the pole row and the outline left -> opposite -> right, divided by the wedge width
+    const float depthLeft = std::abs(left.y - poleY);
+    const float depthRight = std::abs(right.y - poleY);
+    const float depthOpposite = std::abs(opposite.y - poleY);
+    const float oppositeX = std::clamp(opposite.x, left.x, right.x);
+    const float wedgeWidth = right.x - left.x;
+    const float depth = wedgeWidth > 0.f
+        ? ((oppositeX - left.x) * (depthLeft + depthOpposite) + (right.x - oppositeX) * (depthOpposite + depthRight)) * .5f / wedgeWidth
+        : std::max(std::max(depthLeft, depthRight), depthOpposite);
+
+    const float capTop = poleY == 0.f ? 0.f : poleY - depth;
+    const float capBottom = poleY == 0.f ? depth : poleY;
+    corners[0] = { left.x, capTop };
+    corners[1] = { right.x, capTop };
+    corners[2] = { left.x, capBottom };
+    corners[3] = { right.x, capBottom };
+}
+
+// Moves footprints that cross the seam into one continuous range and turns footprints around a pole into the cap they cover.
+// Returns true if the footprint was changed. Corners are in screen order (top left, top right, bottom left, bottom right).
+static bool UnwrapFootprint(Vector2 corners[4], int width, int height)
+{
+    // A corner exactly on a pole (the center of a straight up or down view with an even resolution) has no longitude
+    const float poleTolerance = PoleCornerTolerance * height;
+    for (int i = 0; i < 4; i++)
+    {
+        if (corners[i].y < poleTolerance || corners[i].y > height - poleTolerance)
+        {
+            ClipPoleCorner(corners, i, width, corners[i].y < poleTolerance ? 0.f : static_cast<float>(height));
+            return true;
+        }
+    }
+
+    const float halfWidth = width * .5f;
+    float minX = std::min(std::min(corners[0].x, corners[1].x), std::min(corners[2].x, corners[3].x));
+    float maxX = std::max(std::max(corners[0].x, corners[1].x), std::max(corners[2].x, corners[3].x));
+    if (maxX - minX <= halfWidth) return false;
+
+    // atan2 jumps from 1 to 0 in between the corners, continue the left ones past the right edge
+    for (int i = 0; i < 4; i++)
+    {
+        if (corners[i].x < halfWidth) corners[i].x += width;
+    }
+    minX = std::min(std::min(corners[0].x, corners[1].x), std::min(corners[2].x, corners[3].x));
+    maxX = std::max(std::max(corners[0].x, corners[1].x), std::max(corners[2].x, corners[3].x));
+    if (maxX - minX <= halfWidth) return true;
+
+    // Still spanning every longitude: the pixel contains a pole and covers all texels up to (or from) its lowest corner
+    const float minY = std::min(std::min(corners[0].y, corners[1].y), std::min(corners[2].y, corners[3].y));
+    const float maxY = std::max(std::max(corners[0].y, corners[1].y), std::max(corners[2].y, corners[3].y));
+    const bool northPole = minY + maxY < static_cast<float>(height);
+    const float capTop = northPole ? 0.f : minY;
+    const float capBottom = northPole ? maxY : static_cast<float>(height);
+    corners[0] = { 0.f, capTop };
+    corners[1] = { static_cast<float>(width), capTop };
+    corners[2] = { 0.f, capBottom };
+    corners[3] = { static_cast<float>(width), capBottom };
+    return true;
+}
+
+// Used when a footprint covers no sample at all: take the texel at the center of its bounds.
+static void WriteCenterTexel(const FilterSource& source, float minX, float maxX, float minY, float maxY, uint8_t* outPixel)
+{
+    size_t centerX = static_cast<size_t>(std::max((minX + maxX) / 2.f, 0.f)) % source.width;
+    size_t centerY = std::clamp((minY + maxY) / 2.f, 0.f, static_cast<float>(source.height - 1));
+    size_t sampleTexIndex = (centerY * source.width + centerX) * 3;
+    outPixel[0] = source.gammaTable[source.data[sampleTexIndex]];
+    outPixel[1] = source.gammaTable[source.data[sampleTexIndex + 1]];
+    outPixel[2] = source.gammaTable[source.data[sampleTexIndex + 2]];
+}
+
+// Number of texels inside the bounding box of the footprint.
+static float FootprintBoundsArea(const Vector2 corners[4])
+{
+    const float minX = std::min(std::min(corners[0].x, corners[1].x), std::min(corners[2].x, corners[3].x));
+    const float maxX = std::max(std::max(corners[0].x, corners[1].x), std::max(corners[2].x, corners[3].x));
+    const float minY = std::min(std::min(corners[0].y, corners[1].y), std::min(corners[2].y, corners[3].y));
+    const float maxY = std::max(std::max(corners[0].y, corners[1].y), std::max(corners[2].y, corners[3].y));
+    return (maxX - minX) * (maxY - minY);
+}
+
+// Footprint prepared for subsample counting, shared by every density the adaptive mode tries.
+struct SubsampleFootprint
+{
+    Vector2 triangles[2][3];
+    float minX;
+    float maxX;
+    float minY;
+    float maxY;
+};
+
+// Corners are in screen order (top left, top right, bottom left, bottom right).
+static SubsampleFootprint SetupSubsampleFootprint(const FilterSource& source, const Vector2 corners[4])
+{
+    Vector2 sampleQuadVertices[4] = { corners[0], corners[1], corners[2], corners[3] };
+
+    // Sort points on y axis, which also gives the vertical bounds
+    SortByY(sampleQuadVertices);
+
+    SubsampleFootprint footprint;
+    footprint.minX = std::min(std::min(sampleQuadVertices[0].x, sampleQuadVertices[1].x), std::min(sampleQuadVertices[2].x, sampleQuadVertices[3].x));
+    footprint.maxX = std::max(std::max(sampleQuadVertices[0].x, sampleQuadVertices[1].x), std::max(sampleQuadVertices[2].x, sampleQuadVertices[3].x));
+    footprint.minY = sampleQuadVertices[0].y;
+    footprint.maxY = sampleQuadVertices[3].y;
+
+    // Keep the last subsample row or column inside the texture (x may continue past the seam)
+    footprint.maxX = std::min(footprint.maxX, 2.f * source.width - SubSampleEdgeEpsilon);
+    footprint.maxY = std::min(footprint.maxY, source.height - SubSampleEdgeEpsilon);
+
+    // Split the quad into two triangles along the middle vertices
+    const bool middleSwapped = sampleQuadVertices[1].x > sampleQuadVertices[2].x;
+    const Vector2 middleLeft = middleSwapped ? sampleQuadVertices[2] : sampleQuadVertices[1];
+    const Vector2 middleRight = middleSwapped ? sampleQuadVertices[1] : sampleQuadVertices[2];
+
+    footprint.triangles[0][0] = sampleQuadVertices[0];
+    footprint.triangles[0][1] = middleRight;
+    footprint.triangles[0][2] = middleLeft;
+    footprint.triangles[1][0] = middleLeft;
+    footprint.triangles[1][1] = middleRight;
+    footprint.triangles[1][2] = sampleQuadVertices[3];
+    return footprint;
+}
+
+struct SubsampleSum
+{
+    size_t r = 0;
+    size_t g = 0;
+    size_t b = 0;
+    size_t count = 0;
+};
+
+// Subsamples at (index + offset) / count along one axis, count per texel. The offset is in subsample spacings and below
+// 1, 0.5 puts every subsample in the center of its cell.
+struct SubsampleLattice
+{
+    size_t count;
+    float offset;
+};
+
+static SubsampleLattice CenteredLattice(size_t count)
+{
+    return { count, .5f };
+}
+
+// Index of the subsample whose cell contains the position, 0 for positions before the first one.
+static inline size_t SubsampleCell(const SubsampleLattice& lattice, float position)
+{
+    return static_cast<size_t>(std::max(position * lattice.count - lattice.offset + .5f, 0.f));
+}
+
+static void AddSubsamples(SubsampleSum& sum, const FilterSource& source, size_t texelIndex, int count)
+{
+    const size_t sampleTexIndex = texelIndex * 3;
+    sum.r += count * source.gammaTable[source.data[sampleTexIndex]];
+    sum.g += count * source.gammaTable[source.data[sampleTexIndex + 1]];
+    sum.b += count * source.gammaTable[source.data[sampleTexIndex + 2]];
+    sum.count += count;
+}
+
+// Sums up all samples inside the two triangles on the lattice of rows x columns subsamples per texel.
+// Each subsample row only visits the texels its span touches instead of the whole bounding box.
+// The subsamples whose lane (index inside the texel) is set in splitLanes are also summed into outSplit, so a coarser
+// lattice contained in this one is sampled by the same pass.
+static SubsampleSum SumSubsamples(const FilterSource& source, const SubsampleFootprint& footprint, const SubsampleLattice& rows, const SubsampleLattice& columns,
+                           uint32_t splitLanes = 0, SubsampleSum* outSplit = nullptr)
+{
+    SubsampleSum sum{};
+    const size_t firstSubSampleX = SubsampleCell(columns, footprint.minX);
+    const size_t lastSubSampleX = SubsampleCell(columns, footprint.maxX);
+    const size_t lastSubSampleY = SubsampleCell(rows, footprint.maxY);
+    for (size_t subSampleY = SubsampleCell(rows, footprint.minY); subSampleY <= lastSubSampleY; subSampleY++)
+    {
+        const float py = (static_cast<float>(subSampleY) + rows.offset) / rows.count;
+        float spanMinX, spanMaxX;
+        if (!FootprintRowSpan(footprint.triangles, py, columns.count, spanMinX, spanMaxX)) continue;
+
+        const size_t spanFirstX = std::max(firstSubSampleX, SubsampleCell(columns, spanMinX));
+        const size_t spanLastX = std::min(lastSubSampleX, SubsampleCell(columns, spanMaxX));
+        if (spanFirstX > spanLastX) continue;
+
+        const float firstX = (static_cast<float>(spanFirstX) + columns.offset) / columns.count;
+        const float lastX = (static_cast<float>(spanLastX) + columns.offset) / columns.count;
+        const FootprintRow row = SetupFootprintRow(footprint.triangles, py);
+        const size_t texelRowIndex = (subSampleY / rows.count) * source.width;
+
+        for (size_t texelX = spanFirstX / columns.count; texelX <= spanLastX / columns.count; texelX++)
+        {
+            const uint32_t covered = CoveredSubsampleMask(row, static_cast<float>(texelX), firstX, lastX, columns.count, columns.offset);
+            if (covered == 0) continue;
+
+            const size_t texelIndex = texelRowIndex + WrapTexelX(texelX, source.width);
+            AddSubsamples(sum, source, texelIndex, std::popcount(covered));
+            if (outSplit != nullptr) AddSubsamples(*outSplit, source, texelIndex, std::popcount(covered & splitLanes));
+        }
+    }
+    return sum;
+}
+
+static void AddSubsampleSum(SubsampleSum& sum, const SubsampleSum& other)
+{
+    sum.r += other.r;
+    sum.g += other.g;
+    sum.b += other.b;
+    sum.count += other.count;
+}
+
+// Average sample results
+static void WriteSubsampleAverage(const FilterSource& source, const SubsampleFootprint& footprint, const SubsampleSum& sum, uint8_t* outPixel)
+{
+    if (sum.count == 0)
+    {
+        WriteCenterTexel(source, footprint.minX, footprint.maxX, footprint.minY, footprint.maxY, outPixel);
+        return;
+    }
+    outPixel[0] = static_cast<uint8_t>(sum.r / sum.count);
+    outPixel[1] = static_cast<uint8_t>(sum.g / sum.count);
+    outPixel[2] = static_cast<uint8_t>(sum.b / sum.count);
+}
+
+// Averages the subsamples inside the footprint, corners are in screen order (top left, top right, bottom left, bottom right).
+static void FilterFootprintSubsamples(const FilterSource& source, const Vector2 corners[4], uint8_t* outPixel)
+{
+    const SubsampleFootprint footprint = SetupSubsampleFootprint(source, corners);
+    const SubsampleLattice lattice = CenteredLattice(SubSampleCount);
+    WriteSubsampleAverage(source, footprint, SumSubsamples(source, footprint, lattice, lattice), outPixel);
+}
+
+// Lattice of the adaptive mode at a density, a subset of the reference grid that contains the lattices of the lower densities.
+static SubsampleLattice AdaptiveLattice(size_t subSampleCount)
+{
+    const size_t step = SubSampleCount / subSampleCount;
+    return { subSampleCount, (static_cast<float>(AdaptiveLatticeOrigin % step) + .5f) * subSampleCount / SubSampleCount };
+}
+
+// Starts at the density that gives the footprint a fixed number of samples, never above the reference density, and
+// doubles it until two successive estimates agree within the tolerance (in 8 bit levels) or the reference density is
+// reached. The densities are nested subsets of the reference grid, so a doubling
+// only samples the subsamples it adds, and a footprint that goes all the way gets exactly the 8x8 result. The coverage
+// error of a sample grid only comes from the texels under the outline and usually shrinks with every doubling, so
+// agreement between two levels is taken as a sign of convergence. It is a heuristic, not a bound: the result can still
+// differ from the 8x8 one by more than the tolerance.
+static void FilterFootprintAdaptive(const FilterSource& source, const Vector2 corners[4], float tolerance, uint8_t* outPixel)
+{
+    const SubsampleFootprint footprint = SetupSubsampleFootprint(source, corners);
+
+    // Four times the samples the reference gives a single texel: sparser starts rarely agree with the next density, and
+    // footprints below 16 texels go straight to the reference density without paying for a check
+    const float targetSamples = static_cast<float>(4 * SubSampleCount * SubSampleCount);
+    const float footprintArea = std::max(FootprintBoundsArea(corners), 1e-6f);
+    size_t subSampleCount = MinAdaptiveSubSampleCount;
+    while (subSampleCount < SubSampleCount && footprintArea * subSampleCount * subSampleCount < targetSamples)
+    {
+        subSampleCount *= 2;
+    }
+
+    const size_t startCount = subSampleCount;
+    SubsampleSum sum{};
+    SubsampleSum coarse{};
+    while (subSampleCount < SubSampleCount)
+    {
+        // The doubled density adds the rows in between the current ones, and the columns in between on the current rows.
+        // The first level samples its rows at the doubled density right away and splits off its own lanes, which gives
+        // the coarse estimate without a pass of its own.
+        const SubsampleLattice current = AdaptiveLattice(subSampleCount);
+        const SubsampleLattice between = { subSampleCount, current.offset < .5f ? current.offset + .5f : current.offset - .5f };
+        const SubsampleLattice doubled = AdaptiveLattice(subSampleCount * 2);
+        if (subSampleCount == startCount)
+        {
+            const uint32_t currentLanes = current.offset < .5f ? 0x55555555u : 0xAAAAAAAAu;
+            sum = SumSubsamples(source, footprint, current, doubled, currentLanes, &coarse);
+        }
+        else
+        {
+            coarse = sum;
+            AddSubsampleSum(sum, SumSubsamples(source, footprint, current, between));
+        }
+        AddSubsampleSum(sum, SumSubsamples(source, footprint, between, doubled));
+        subSampleCount *= 2;
+
+        bool converged = coarse.count > 0 && sum.count > 0;
+        if (converged)
+        {
+            const float coarseAverage[3] = { static_cast<float>(coarse.r) / coarse.count, static_cast<float>(coarse.g) / coarse.count, static_cast<float>(coarse.b) / coarse.count };
+            const float fineAverage[3] = { static_cast<float>(sum.r) / sum.count, static_cast<float>(sum.g) / sum.count, static_cast<float>(sum.b) / sum.count };
+            for (int channel = 0; channel < 3; channel++)
+            {
+                converged &= std::abs(coarseAverage[channel] - fineAverage[channel]) <= tolerance;
+            }
+        }
+        if (converged) break;
+    }
+
+    // Footprints of a few texels start at the reference density
+    if (startCount == SubSampleCount)
+    {
+        const SubsampleLattice lattice = AdaptiveLattice(SubSampleCount);
+        sum = SumSubsamples(source, footprint, lattice, lattice);
+    }
+
+    WriteSubsampleAverage(source, footprint, sum, outPixel);
+}
+
+// Quad clipped against up to four axis aligned lines gains at most one vertex per line.
+constexpr int MaxClippedVertices = 8;
+
+// Sutherland-Hodgman step: keeps the part of the polygon where the chosen coordinate is >= bound (keepAbove) or <= bound.
+static int ClipPolygon(const Vector2* polygon, int vertexCount, bool clipY, float bound, bool keepAbove, Vector2* outPolygon)
+{
+    auto coordinate = [clipY](const Vector2& v) { return clipY ? v.y : v.x; };
+    auto inside = [&](const Vector2& v) { return keepAbove ? coordinate(v) >= bound : coordinate(v) <= bound; };
+
+    int outCount = 0;
+    for (int i = 0; i < vertexCount; i++)
+    {
+        const Vector2& current = polygon[i];
+        const Vector2& next = polygon[(i + 1) % vertexCount];
+        const bool currentInside = inside(current);
+        const bool nextInside = inside(next);
+
+        if (currentInside)
+        {
+            outPolygon[outCount++] = current;
+        }
+        if (currentInside != nextInside)
+        {
+            const float t = (bound - coordinate(current)) / (coordinate(next) - coordinate(current));
+            Vector2 intersection = { current.x + (next.x - current.x) * t, current.y + (next.y - current.y) * t };
+            if (clipY) intersection.y = bound; else intersection.x = bound;
+            outPolygon[outCount++] = intersection;
+        }
+    }
+    return outCount;
+}
+
+// Shoelace formula, positive for counter clockwise polygons in a y-up system.
+static double SignedArea(const Vector2* polygon, int vertexCount)
+{
+    double area = 0.;
+    for (int i = 0; i < vertexCount; i++)
+    {
+        const Vector2& current = polygon[i];
+        const Vector2& next = polygon[(i + 1) % vertexCount];
+        area += static_cast<double>(current.x) * next.y - static_cast<double>(next.x) * current.y;
+    }
+    return area * .5;
+}
+
+// True if the quad (in perimeter order) turns the same way at every corner and encloses some area. Bow ties, dents
+// and quads collapsed to a line are not convex.
+static bool IsConvexQuad(const Vector2 quad[4])
+{
+    bool anyPositive = false;
+    bool anyNegative = false;
+    for (int i = 0; i < 4; i++)
+    {
+        const Vector2& previous = quad[(i + 3) % 4];
+        const Vector2& current = quad[i];
+        const Vector2& next = quad[(i + 1) % 4];
+        const double turn = (static_cast<double>(current.x) - previous.x) * (static_cast<double>(next.y) - current.y)
+            - (static_cast<double>(current.y) - previous.y) * (static_cast<double>(next.x) - current.x);
+        anyPositive |= turn > 0.;
+        anyNegative |= turn < 0.;
+    }
+    return anyPositive != anyNegative;
+}
+
+// Sum of the texels [firstColumn, endColumn) in one texel row, columns past the right edge continue at the left one.
+static inline void SumTexelRow(const SummedAreaTable& table, int texelY, int firstColumn, int endColumn, uint32_t outSums[3])
+{
+    if (firstColumn >= table.width)
+    {
+        firstColumn -= table.width;
+        endColumn -= table.width;
+    }
+    if (endColumn > table.width)
+    {
+        uint32_t wrappedSums[3];
+        SumTexelRow(table, texelY, 0, endColumn - table.width, wrappedSums);
+        SumTexelRow(table, texelY, firstColumn, table.width, outSums);
+        for (int channel = 0; channel < 3; channel++) outSums[channel] += wrappedSums[channel];
+        return;
+    }
+
+    const uint32_t* row = &table.sums[(texelY * (static_cast<size_t>(table.width) + 1)) * 3];
+    for (int channel = 0; channel < 3; channel++)
+    {
+        outSums[channel] = row[endColumn * 3 + channel] - row[firstColumn * 3 + channel];
+    }
+}
+
+// Weights every texel by the exact area of the footprint quad inside it.
+// The quad is cut into one strip per texel row and every strip into the texels of its x range, so the work
+// grows with the number of covered texels plus the rows the outline crosses, not with a subsample grid.
+// With a summed area table the texels a strip fully covers are summed in one lookup, only the texels under
+// the outline are clipped, which makes the work grow with the outline alone. That needs a convex quad, other
+// quads are clipped texel by texel even with a table.
+static void FilterFootprintAnalytic(const FilterSource& source, const Vector2 corners[4], const SummedAreaTable* table, uint8_t* outPixel)
+{
+    // Perimeter order, the corners come in screen row order
+    const Vector2 quad[4] = { corners[0], corners[1], corners[3], corners[2] };
+
+    float minX = quad[0].x;
+    float maxX = quad[0].x;
+    float minY = quad[0].y;
+    float maxY = quad[0].y;
+    for (const Vector2& vertex : quad)
+    {
+        minX = std::min(minX, vertex.x);
+        maxX = std::max(maxX, vertex.x);
+        minY = std::min(minY, vertex.y);
+        maxY = std::max(maxY, vertex.y);
+    }
+
+    // Signed areas keep the orientation of the quad, so mirrored footprints cancel out in the division below
+    const double orientation = SignedArea(quad, 4) < 0. ? -1. : 1.;
+    const SummedAreaTable* spanTable = IsConvexQuad(quad) ? table : nullptr;
+    double outR = 0.;
+    double outG = 0.;
+    double outB = 0.;
+    double sumArea = 0.;
+
+    const int firstRow = std::max(0, static_cast<int>(std::floor(minY)));
+    const int lastRow = std::min(source.height - 1, static_cast<int>(std::ceil(maxY)) - 1);
+    for (int texelY = firstRow; texelY <= lastRow; texelY++)
+    {
+        Vector2 clipped[MaxClippedVertices];
+        Vector2 strip[MaxClippedVertices];
+        int stripCount = ClipPolygon(quad, 4, true, static_cast<float>(texelY), true, clipped);
+        stripCount = ClipPolygon(clipped, stripCount, true, static_cast<float>(texelY + 1), false, strip);
+        if (stripCount < 3) continue;
+
+        float stripMinX = strip[0].x;
+        float stripMaxX = strip[0].x;
+        for (int i = 1; i < stripCount; i++)
+        {
+            stripMinX = std::min(stripMinX, strip[i].x);
+            stripMaxX = std::max(stripMaxX, strip[i].x);
+        }
+
+        const int firstColumn = std::max(0, static_cast<int>(std::floor(stripMinX)));
+        const int lastColumn = std::min(2 * source.width - 1, static_cast<int>(std::ceil(stripMaxX)) - 1);
+
+        // Texels between the outline on the top and bottom edge of the strip are fully covered, as the quad is convex
+        int innerFirstColumn = lastColumn + 1;
+        int innerEndColumn = lastColumn + 1;
+        if (spanTable != nullptr)
+        {
+            float topMinX = INFINITY, topMaxX = -INFINITY, bottomMinX = INFINITY, bottomMaxX = -INFINITY;
+            for (int i = 0; i < stripCount; i++)
+            {
+                if (strip[i].y == static_cast<float>(texelY))
+                {
+                    topMinX = std::min(topMinX, strip[i].x);
+                    topMaxX = std::max(topMaxX, strip[i].x);
+                }
+                if (strip[i].y == static_cast<float>(texelY + 1))
+                {
+                    bottomMinX = std::min(bottomMinX, strip[i].x);
+                    bottomMaxX = std::max(bottomMaxX, strip[i].x);
+                }
+            }
+
+            // Strips at the top and bottom of the footprint don't reach both edges and have no fully covered texels
+            const bool spansStrip = topMinX <= topMaxX && bottomMinX <= bottomMaxX;
+            const int fullFirst = spansStrip ? std::max(firstColumn, static_cast<int>(std::ceil(std::max(topMinX, bottomMinX)))) : 0;
+            const int fullEnd = spansStrip ? std::min(lastColumn + 1, static_cast<int>(std::floor(std::min(topMaxX, bottomMaxX)))) : 0;
+            if (fullFirst < fullEnd)
+            {
+                innerFirstColumn = fullFirst;
+                innerEndColumn = fullEnd;
+
+                uint32_t sums[3];
+                SumTexelRow(*spanTable, texelY, innerFirstColumn, innerEndColumn, sums);
+                outR += orientation * sums[0];
+                outG += orientation * sums[1];
+                outB += orientation * sums[2];
+                sumArea += orientation * (innerEndColumn - innerFirstColumn);
+            }
+        }
+
+        const size_t texelRowIndex = static_cast<size_t>(texelY) * source.width;
+        for (int texelX = firstColumn; texelX <= lastColumn; texelX++)
+        {
+            if (texelX == innerFirstColumn)
+            {
+                texelX = innerEndColumn - 1;
+                continue;
+            }
+
+            Vector2 cell[MaxClippedVertices];
+            int cellCount = ClipPolygon(strip, stripCount, false, static_cast<float>(texelX), true, clipped);
+            cellCount = ClipPolygon(clipped, cellCount, false, static_cast<float>(texelX + 1), false, cell);
+            if (cellCount < 3) continue;
+
+            const double area = SignedArea(cell, cellCount);
+            size_t sampleTexIndex = (texelRowIndex + WrapTexelX(texelX, source.width)) * 3;
+            outR += area * source.gammaTable[source.data[sampleTexIndex]];
+            outG += area * source.gammaTable[source.data[sampleTexIndex + 1]];
+            outB += area * source.gammaTable[source.data[sampleTexIndex + 2]];
+            sumArea += area;
+        }
+    }
+
+    if (sumArea == 0.)
+    {
+        WriteCenterTexel(source, minX, maxX, minY, maxY, outPixel);
+        return;
+    }
+    outPixel[0] = static_cast<uint8_t>(std::clamp(std::round(outR / sumArea), 0., 255.));
+    outPixel[1] = static_cast<uint8_t>(std::clamp(std::round(outG / sumArea), 0., 255.));
+    outPixel[2] = static_cast<uint8_t>(std::clamp(std::round(outB / sumArea), 0., 255.));
+}
+
+SphereTexture LinearizeSphereTexture(MemoryArena& arena, const SphereTexture& texture, int threadCount)
+{
+    if (texture.linearized) return texture;
+
+    uint8_t gammaTable[256];
+    BuildGammaTable(gammaTable);
+
+    const size_t rowSize = static_cast<size_t>(texture.width) * 3;
+    uint8_t* data = NewArray(arena, uint8_t, rowSize * texture.height);
+    RunTiles(texture.height, threadCount, [&](size_t y, int) {
+        const uint8_t* sourceRow = &texture.data[y * rowSize];
+        uint8_t* row = &data[y * rowSize];
+        for (size_t i = 0; i < rowSize; i++)
+        {
+            row[i] = gammaTable[sourceRow[i]];
+        }
+    });
+
+    SphereTexture result = texture;
+    result.data = data;
+    result.linearized = true;
+    return result;
+}
+
+SummedAreaTable CreateSummedAreaTable(MemoryArena& arena, const SphereTexture& texture, int threadCount)
+{
+    SummedAreaTable table{};
+    assert(texture.data != nullptr);
+    if (texture.data == nullptr) return table;
+
+    uint8_t gammaTable[256];
+    BuildTexelTable(texture, gammaTable);
+
+    const size_t stride = static_cast<size_t>(texture.width) + 1;
+    uint32_t* sums = NewArray(arena, uint32_t, stride * texture.height * 3);
+
+    // Column 0 stays zero so lookups need no bounds checks, rows are independent
+    RunTiles(texture.height, threadCount, [&](size_t y, int) {
+        uint32_t* row = &sums[(y * stride) * 3];
+        const uint8_t* texels = &texture.data[static_cast<size_t>(y) * texture.width * 3];
+        row[0] = row[1] = row[2] = 0;
+        for (int x = 0; x < texture.width; x++)
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                row[(x + 1) * 3 + channel] = row[x * 3 + channel] + gammaTable[texels[x * 3 + channel]];
+            }
+        }
+    });
+
+    table.width = texture.width;
+    table.height = texture.height;
+    table.sums = sums;
+    return table;
+}
+
+// Texture position of the ray through one pixel corner. Neighbouring pixels share corners, so they are computed once per image.
+struct CornerSample
+{
+    Vector2 texturePos{};
+    bool hit = false;
+};
+
+// Radius of the sphere the texture is mapped on. Off-center views depend on it, centered ones don't.
+constexpr float SphereRadius = 500.f;
+
+// A camera closer to the sphere center than this sees every point at the same angle as from the center (parallax below 2e-7 rad).
+constexpr float CenterCameraTolerance = 1e-4f;
+
+// Returns a gridWidth * gridHeight grid of samples, row by row. Grid point (x, y) is the ray through screen position
+// (x + pixelOffset, y + pixelOffset) in pixels: pixel corners for an offset of 0, pixel centers for 0.5.
+static CornerSample* CreateCornerGrid(MemoryArena& arena, const ReferenceView& view, int textureWidth, int textureHeight, int threadCount, size_t gridWidth, size_t gridHeight, float pixelOffset)
+{
+    CornerSample* grid = NewArray(arena, CornerSample, gridWidth * gridHeight);
+
+    // Clip space to world space: row vectors go world -> view -> clip, so this is inverse(projection) * inverse(view)
+    const Matrix4 inverseViewProjection = Inverse(Multiply(view.spaceToView, view.projection));
+    const SimdMath::Mat4V inverseViewProjectionV = SimdMath::Broadcast(ToMat4(inverseViewProjection));
+
+    // From the center every ray hits the sphere and its direction alone gives the texture position. The direction of a
+    // clip space point is its homogeneous world position, which is linear along a grid row.
+    const Matrix4 viewToSpace = Inverse(view.spaceToView);
+    const Vector3 cameraPosition = { viewToSpace.m[3][0], viewToSpace.m[3][1], viewToSpace.m[3][2] };
+    const bool centerCamera = Length(cameraPosition) < CenterCameraTolerance;
+
+    auto homogeneous = [&](float clipX, float clipY) {
+        const Vector3 clip = { clipX, clipY, 1.f };
+        const float w = clip.x * inverseViewProjection.m[0][3] + clip.y * inverseViewProjection.m[1][3] + clip.z * inverseViewProjection.m[2][3] + inverseViewProjection.m[3][3];
+        return std::pair{ Transform(clip, inverseViewProjection), w };
+    };
+    // Every point in front of the camera has the same sign of w, flip directions behind it
+    const float facing = homogeneous(0.f, 0.f).second < 0.f ? -1.f : 1.f;
+    const float clipStepX = 2.f / static_cast<float>(view.screenWidth);
+    const float clipStepY = 2.f / static_cast<float>(view.screenHeight);
+    const Vector3 rowStep = Vector3{ inverseViewProjection.m[0][0], inverseViewProjection.m[0][1], inverseViewProjection.m[0][2] } * (clipStepX * facing);
+
+    RunTiles(gridHeight, threadCount, [&](size_t y, int) {
+        CornerSample* row = &grid[y * gridWidth];
+        if (centerCamera)
+        {
+            // Directions are generated and converted in registers, SimdMath::Width corners at a time
+            using namespace SimdMath;
+            const Vector3 rowStart = homogeneous(pixelOffset * clipStepX - 1.f, (static_cast<float>(y) + pixelOffset) * clipStepY - 1.f).first * facing;
+            for (size_t x = 0; x < gridWidth; x += Width)
+            {
+                const FloatV index = Set(static_cast<float>(x)) + LaneIndex();
+                FloatV u, v;
+                DirectionToEquirect(MulAdd(index, Set(rowStep.x), Set(rowStart.x)), MulAdd(index, Set(rowStep.y), Set(rowStart.y)), MulAdd(index, Set(rowStep.z), Set(rowStart.z)), u, v);
+
+                float laneU[Width];
+                float laneV[Width];
+                Store(laneU, u * Set(static_cast<float>(textureWidth)));
+                Store(laneV, v * Set(static_cast<float>(textureHeight)));
+                for (size_t lane = 0; lane < Width && x + lane < gridWidth; lane++)
+                {
+                    row[x + lane].texturePos = { laneU[lane], laneV[lane] };
+                    row[x + lane].hit = true;
+                }
+            }
+            return;
+        }
+
+        // Off center the rays go from the near to the far plane. Their end points are transformed SimdMath::Width corners
+        // at a time, the sphere hit points (the directions from the sphere center) are converted in one batch per row.
+        const size_t paddedWidth = (gridWidth + SimdMath::Width - 1) / SimdMath::Width * SimdMath::Width;
+        thread_local std::vector<float> rowData;
+        rowData.resize(paddedWidth * 8);
+        float* nearX = &rowData[0];
+        float* nearY = &rowData[paddedWidth];
+        float* nearZ = &rowData[paddedWidth * 2];
+        float* farX = &rowData[paddedWidth * 3];
+        float* farY = &rowData[paddedWidth * 4];
+        float* farZ = &rowData[paddedWidth * 5];
+        float* u = &rowData[paddedWidth * 6];
+        float* v = &rowData[paddedWidth * 7];
+        {
+            using namespace SimdMath;
+            const FloatV clipY = Set(((static_cast<float>(y) + pixelOffset) / static_cast<float>(view.screenHeight)) * 2.f - 1.f);
+            for (size_t x = 0; x < gridWidth; x += Width)
+            {
+                const FloatV clipX = (Set(static_cast<float>(x) + pixelOffset) + LaneIndex()) / Set(static_cast<float>(view.screenWidth)) * Set(2.f) - Set(1.f);
+                FloatV pointX, pointY, pointZ;
+                TransformCoord(inverseViewProjectionV, clipX, clipY, Set(0.f), pointX, pointY, pointZ);
+                Store(&nearX[x], pointX);
+                Store(&nearY[x], pointY);
+                Store(&nearZ[x], pointZ);
+                TransformCoord(inverseViewProjectionV, clipX, clipY, Set(1.f), pointX, pointY, pointZ);
+                Store(&farX[x], pointX);
+                Store(&farY[x], pointY);
+                Store(&farZ[x], pointZ);
+            }
+        }
+
+        // The hit points overwrite the near points they started from
+        float* directionX = nearX;
+        float* directionY = nearY;
+        float* directionZ = nearZ;
+        for (size_t x = 0; x < gridWidth; x++)
+        {
+            const Vector3 rayStart = { nearX[x], nearY[x], nearZ[x] };
+            const Vector3 rayDirection = Normalize(Vector3{ farX[x], farY[x], farZ[x] } - rayStart);
+            Vector3 intersections[2];
+            row[x].hit = RaySphereIntersection(rayStart, rayDirection, { 0.f, 0.f, 0.f }, SphereRadius, intersections) > 0;
+            directionX[x] = row[x].hit ? intersections[0].x : 0.f;
+            directionY[x] = row[x].hit ? intersections[0].y : 0.f;
+            directionZ[x] = row[x].hit ? intersections[0].z : 0.f;
+        }
+
+        DirectionsToEquirect(directionX, directionY, directionZ, gridWidth, u, v);
+        for (size_t x = 0; x < gridWidth; x++)
+        {
+            if (row[x].hit) row[x].texturePos = { u[x] * static_cast<float>(textureWidth), v[x] * static_cast<float>(textureHeight) };
+        }
+    });
+    return grid;
+}
+
+// Looks up the texture footprint of one output pixel. Pixels whose corners miss the sphere are written blue and return false.
+static bool LookupFootprint(const FilterSource& source, const CornerSample* cornerGrid, size_t gridWidth, size_t x, size_t y, Vector2 outCorners[4], uint8_t* outPixel)
+{
+    // Look up the sphere intersections of the pixel corners
+    const CornerSample& topLeft = cornerGrid[y * gridWidth + x];
+    const CornerSample& topRight = cornerGrid[y * gridWidth + x + 1];
+    const CornerSample& botLeft = cornerGrid[(y + 1) * gridWidth + x];
+    const CornerSample& botRight = cornerGrid[(y + 1) * gridWidth + x + 1];
+
+    assert(topLeft.hit && topRight.hit && botLeft.hit && botRight.hit);
+    if (!topLeft.hit || !topRight.hit || !botLeft.hit || !botRight.hit)
+    {
+        outPixel[0] = 0;
+        outPixel[1] = 0;
+        outPixel[2] = 255;
+        return false;
+    }
+
+    outCorners[0] = topLeft.texturePos;
+    outCorners[1] = topRight.texturePos;
+    outCorners[2] = botLeft.texturePos;
+    outCorners[3] = botRight.texturePos;
+    UnwrapFootprint(outCorners, source.width, source.height);
+    return true;
+}
+
+// Filters one output pixel from the corner samples around it.
+static void RenderPixel(const FilterSource& source, const CornerSample* cornerGrid, size_t gridWidth, size_t x, size_t y, const RenderSettings& settings, uint8_t* outPixel)
+{
+    Vector2 corners[4];
+    if (!LookupFootprint(source, cornerGrid, gridWidth, x, y, corners, outPixel)) return;
+
+    if (settings.summedAreaTable != nullptr && FootprintBoundsArea(corners) > settings.summedAreaTableMinTexels)
+    {
+        FilterFootprintAnalytic(source, corners, settings.summedAreaTable, outPixel);
+        return;
+    }
+
+    switch (settings.coverage)
+    {
+    case CoverageMode::Subsamples:
+        FilterFootprintSubsamples(source, corners, outPixel);
+        break;
+    case CoverageMode::Analytic:
+        FilterFootprintAnalytic(source, corners, nullptr, outPixel);
+        break;
+    case CoverageMode::Adaptive:
+        FilterFootprintAdaptive(source, corners, settings.adaptiveTolerance, outPixel);
+        break;
+    }
+}
+
+// Cheap stand-in for the final filter used by the progressive passes, a subSampleCount of 0 takes the texel in the footprint center.
+static void RenderPixelPreview(const FilterSource& source, const CornerSample* cornerGrid, size_t gridWidth, size_t x, size_t y, size_t subSampleCount, uint8_t* outPixel)
+{
+    Vector2 corners[4];
+    if (!LookupFootprint(source, cornerGrid, gridWidth, x, y, corners, outPixel)) return;
+
+    const SubsampleFootprint footprint = SetupSubsampleFootprint(source, corners);
+    if (subSampleCount == 0)
+    {
+        WriteCenterTexel(source, footprint.minX, footprint.maxX, footprint.minY, footprint.maxY, outPixel);
+        return;
+    }
+    const SubsampleLattice lattice = CenteredLattice(subSampleCount);
+    WriteSubsampleAverage(source, footprint, SumSubsamples(source, footprint, lattice, lattice), outPixel);
+}
+
+// Densities of the progressive passes before the final one, 0 is the center texel.
+constexpr size_t ProgressivePassSubSampleCounts[] = { 0, 1, 2, 4 };
+
+static uint8_t* RenderReference(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view, const RenderSettings& settings, const ProgressCallback* onPass)
+{
+    const size_t screenWidth = view.screenWidth;
+    const size_t screenHeight = view.screenHeight;
+
+    uint8_t* outputData = NewArray(arena, uint8_t, screenWidth * screenHeight * 3);
+
+    assert(texture.data != nullptr);
+    if (texture.data == nullptr) return nullptr;
+
+    uint8_t gammaTable[256];
+    BuildTexelTable(texture, gammaTable);
+    const FilterSource source = { texture.data, texture.width, texture.height, gammaTable };
+
+    const size_t gridWidth = screenWidth + 1;
+    const CornerSample* cornerGrid = CreateCornerGrid(arena, view, texture.width, texture.height, settings.threadCount, gridWidth, screenHeight + 1, 0.f);
+
+    // Iterate output pixels in tiles, pixel cost varies by orders of magnitude between the equator and the poles
+    const size_t tilesX = (screenWidth + RenderTileSize - 1) / RenderTileSize;
+    const size_t tilesY = (screenHeight + RenderTileSize - 1) / RenderTileSize;
+    auto renderPass = [&](auto renderPixel, SchedulerStatistics* statistics) {
+        RunTiles(tilesX * tilesY, settings.threadCount, [&](size_t tile, int) {
+            const size_t tileX = (tile % tilesX) * RenderTileSize;
+            const size_t tileY = (tile / tilesX) * RenderTileSize;
+            for (size_t y = tileY; y < std::min(tileY + RenderTileSize, screenHeight); y++)
+            {
+                for (size_t x = tileX; x < std::min(tileX + RenderTileSize, screenWidth); x++)
+                {
+                    renderPixel(x, y, &outputData[(y * screenWidth + x) * 3]);
+                }
+            }
+        }, statistics);
+    };
+
+    const int passCount = onPass != nullptr ? static_cast<int>(std::size(ProgressivePassSubSampleCounts)) + 1 : 1;
+    if (onPass != nullptr)
+    {
+        for (int pass = 0; pass < passCount - 1; pass++)
+        {
+            const size_t subSampleCount = ProgressivePassSubSampleCounts[pass];
+            renderPass([&](size_t x, size_t y, uint8_t* outPixel) {
+                RenderPixelPreview(source, cornerGrid, gridWidth, x, y, subSampleCount, outPixel);
+            }, nullptr);
+            (*onPass)(pass, passCount, outputData);
+        }
+    }
+
+    renderPass([&](size_t x, size_t y, uint8_t* outPixel) {
+        RenderPixel(source, cornerGrid, gridWidth, x, y, settings, outPixel);
+    }, settings.statistics);
+    if (onPass != nullptr)
+    {
+        (*onPass)(passCount - 1, passCount, outputData);
+    }
+
+    return outputData;
+}
+
+uint8_t* CreatePerfectFilteredImage(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view, const RenderSettings& settings)
+{
+    return RenderReference(arena, texture, view, settings, nullptr);
+}
+
+uint8_t* CreatePerfectFilteredImageProgressive(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view, const RenderSettings& settings, const ProgressCallback& onPass)
+{
+    return RenderReference(arena, texture, view, settings, &onPass);
+}
+
+Vector2* CreateScreenTexturePositions(MemoryArena& arena, const ReferenceView& view, int threadCount)
+{
+    const size_t pixelCount = view.screenWidth * view.screenHeight;
+    const CornerSample* grid = CreateCornerGrid(arena, view, 1, 1, threadCount, view.screenWidth, view.screenHeight, .5f);
+
+    Vector2* positions = NewArray(arena, Vector2, pixelCount);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        positions[i] = grid[i].hit ? grid[i].texturePos : Vector2{ nan, nan };
+    }
+    return positions;
+}
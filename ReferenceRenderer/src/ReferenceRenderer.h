@@ -0,0 +1,91 @@
+#pragma once
+
+#include "RenderMath.h"
+#include "TileScheduler.h"
+#include "../../EquirectConverter/src/Memory.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// Equirectangular texture mapped onto the inside of the environment sphere, 3 channels (RGB) per pixel.
+struct SphereTexture
+{
+    int width = 0;
+    int height = 0;
+    const uint8_t* data = nullptr;
+
+    // Texels are already in the renderer's working color space (see LinearizeSphereTexture), filtering uses them unchanged.
+    bool linearized = false;
+};
+
+// Camera used to render the reference image. Matrices match the ones used by the viewer's D3D12 plugin.
+struct ReferenceView
+{
+    Matrix4 spaceToView{};
+    Matrix4 projection{};
+    size_t screenWidth = 0;
+    size_t screenHeight = 0;
+};
+
+// How the texels inside a screen pixel's footprint are found and weighted.
+enum class CoverageMode
+{
+    Subsamples, // 8x8 subsamples per texel tested against the footprint, every covered subsample counts once
+    Analytic,   // footprint clipped against the texel grid, every texel weighted by its exact covered area
+    Adaptive,   // subsample density picked per footprint up to the Subsamples one, refined until it agrees with the next density within adaptiveTolerance
+};
+
+// Prefix sums along every texel row of a SphereTexture in the renderer's working color space, height * (width + 1) entries
+// of 3 channels. The renderer only ever sums runs of texels within one row, so unlike a full summed area table the
+// rows are not accumulated down the columns, and a row sum never exceeds 2^32.
+// Build it once per texture and pass it to every render of that texture.
+struct SummedAreaTable
+{
+    int width = 0;
+    int height = 0;
+    const uint32_t* sums = nullptr;
+};
+
+struct RenderSettings
+{
+    CoverageMode coverage = CoverageMode::Subsamples;
+
+    // Allowed difference between two successive densities in CoverageMode::Adaptive, in 8 bit color levels.
+    float adaptiveTolerance = 1.f;
+
+    // Optional, footprints whose bounds cover more texels than summedAreaTableMinTexels are integrated exactly with it.
+    // This overrides the coverage mode for those footprints: they get CoverageMode::Analytic weights even when
+    // Subsamples or Adaptive is selected, so the image mixes both. Smaller footprints keep the selected coverage mode.
+    const SummedAreaTable* summedAreaTable = nullptr;
+    float summedAreaTableMinTexels = 64.f;
+
+    // Worker threads, 0 uses one per hardware thread.
+    int threadCount = 0;
+
+    // Optional, receives the per-thread utilization of the pixel pass.
+    SchedulerStatistics* statistics = nullptr;
+};
+
+// Copies the texture into the arena with the working color space curve applied, so it runs once per texel instead of once per lookup.
+SphereTexture LinearizeSphereTexture(MemoryArena& arena, const SphereTexture& texture, int threadCount = 0);
+
+// Builds the row prefix sums of the texture in parallel, allocated in the arena.
+SummedAreaTable CreateSummedAreaTable(MemoryArena& arena, const SphereTexture& texture, int threadCount = 0);
+
+// Renders the view by averaging every texel a screen pixel's footprint covers on the sphere (the "perfect" filter).
+// Returns screenWidth * screenHeight RGB pixels allocated in the arena.
+uint8_t* CreatePerfectFilteredImage(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view, const RenderSettings& settings = {});
+
+// Called after every progressive pass with the whole intermediate image, the buffer is overwritten by the next pass.
+// pass counts from 0, the last pass (passCount - 1) delivers the same image CreatePerfectFilteredImage returns.
+using ProgressCallback = std::function<void(int pass, int passCount, const uint8_t* image)>;
+
+// Same result as CreatePerfectFilteredImage, but first renders cheap passes (center texel, then 1, 2 and 4
+// subsamples per texel) over all tiles and hands every one of them to the callback before the final pass.
+uint8_t* CreatePerfectFilteredImageProgressive(MemoryArena& arena, const SphereTexture& texture, const ReferenceView& view, const RenderSettings& settings, const ProgressCallback& onPass);
+
+// Equirect texture position (u and v in [0, 1]) of the sphere point seen through every pixel center, what the viewer's
+// sphere mesh interpolates there. Returns screenWidth * screenHeight positions allocated in the arena, row by row in the
+// order of the rendered images. Pixels whose ray misses the sphere get NaN.
+Vector2* CreateScreenTexturePositions(MemoryArena& arena, const ReferenceView& view, int threadCount = 0);
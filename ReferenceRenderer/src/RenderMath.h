@@ -0,0 +1,197 @@
+#pragma once
+
+#include <VectorMath.h>
+
+#include <cmath>
+
+// Small replacement for the parts of DirectXMath the reference renderer needs, so it builds without the Windows SDK.
+// The matrix functions run on the Vec4 / Mat4 types of SimdMath/VectorMath.h.
+// Matrices follow the DirectXMath conventions: row-major, row vectors (v * M).
+// That means an XrMatrix4x4f (column-major, column vectors) can be copied over as-is.
+
+#define RENDER_PI 3.14159265358979323846f
+#define RENDER_2PI 6.28318530717958647692f
+
+struct Vector2
+{
+    float x = 0.f;
+    float y = 0.f;
+};
+
+struct Vector3
+{
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+};
+
+inline Vector3 operator+(const Vector3& a, const Vector3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vector3 operator-(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vector3 operator*(const Vector3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+
+inline float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float Length(const Vector3& v) { return std::sqrt(Dot(v, v)); }
+
+inline Vector3 Normalize(const Vector3& v)
+{
+    float length = Length(v);
+    if (length == 0.f) return v;
+    return v * (1.f / length);
+}
+
+// Same layout as XrQuaternionf.
+struct Quaternion
+{
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+    float w = 1.f;
+};
+
+struct Matrix4
+{
+    float m[4][4] = {
+        { 1.f, 0.f, 0.f, 0.f },
+        { 0.f, 1.f, 0.f, 0.f },
+        { 0.f, 0.f, 1.f, 0.f },
+        { 0.f, 0.f, 0.f, 1.f },
+    };
+};
+
+// Conversions to the SIMD types of SimdMath, the storage types here keep the plain float layout of XMFLOAT4X4.
+inline SimdMath::Mat4 ToMat4(const Matrix4& matrix) { return SimdMath::LoadMat4(&matrix.m[0][0]); }
+inline SimdMath::Vec4 ToVec4(const Vector3& v, float w) { return SimdMath::MakeVec4(v.x, v.y, v.z, w); }
+
+inline Matrix4 ToMatrix4(const SimdMath::Mat4& matrix)
+{
+    Matrix4 result;
+    SimdMath::StoreMat4(&result.m[0][0], matrix);
+    return result;
+}
+
+inline Vector3 ToVector3(SimdMath::Vec4 v)
+{
+    Vector3 result;
+    SimdMath::StoreVec3(&result.x, v);
+    return result;
+}
+
+inline Matrix4 Multiply(const Matrix4& a, const Matrix4& b)
+{
+    return ToMatrix4(SimdMath::Multiply(ToMat4(a), ToMat4(b)));
+}
+
+// General inverse via cofactors, computed in double precision. Returns identity for singular matrices.
+// Not SimdMath::Inverse: a reference image is inverted once, and the float inverse of a view-projection matrix moves the
+// pixel corners of off-center views enough to change some output pixels.
+inline Matrix4 Inverse(const Matrix4& matrix)
+{
+    double a[16];
+    for (int i = 0; i < 16; i++) a[i] = matrix.m[i / 4][i % 4];
+
+    double inv[16];
+    inv[0]  =  a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+    inv[4]  = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+    inv[8]  =  a[4] * a[9]  * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+    inv[12] = -a[4] * a[9]  * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+    inv[1]  = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+    inv[5]  =  a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+    inv[9]  = -a[0] * a[9]  * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+    inv[13] =  a[0] * a[9]  * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+    inv[2]  =  a[1] * a[6]  * a[15] - a[1] * a[7]  * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7]  - a[13] * a[3] * a[6];
+    inv[6]  = -a[0] * a[6]  * a[15] + a[0] * a[7]  * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7]  + a[12] * a[3] * a[6];
+    inv[10] =  a[0] * a[5]  * a[15] - a[0] * a[7]  * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7]  - a[12] * a[3] * a[5];
+    inv[14] = -a[0] * a[5]  * a[14] + a[0] * a[6]  * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6]  + a[12] * a[2] * a[5];
+    inv[3]  = -a[1] * a[6]  * a[11] + a[1] * a[7]  * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9]  * a[2] * a[7]  + a[9]  * a[3] * a[6];
+    inv[7]  =  a[0] * a[6]  * a[11] - a[0] * a[7]  * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8]  * a[2] * a[7]  - a[8]  * a[3] * a[6];
+    inv[11] = -a[0] * a[5]  * a[11] + a[0] * a[7]  * a[9]  + a[4] * a[1] * a[11] - a[4] * a[3] * a[9]  - a[8]  * a[1] * a[7]  + a[8]  * a[3] * a[5];
+    inv[15] =  a[0] * a[5]  * a[10] - a[0] * a[6]  * a[9]  - a[4] * a[1] * a[10] + a[4] * a[2] * a[9]  + a[8]  * a[1] * a[6]  - a[8]  * a[2] * a[5];
+
+    double determinant = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+    if (determinant == 0.) return Matrix4{};
+
+    Matrix4 result;
+    for (int i = 0; i < 16; i++) result.m[i / 4][i % 4] = static_cast<float>(inv[i] / determinant);
+    return result;
+}
+
+// Transforms (x, y, z, 1) and ignores the resulting w (like XMVector3Transform for affine matrices).
+inline Vector3 Transform(const Vector3& v, const Matrix4& matrix)
+{
+    return ToVector3(SimdMath::TransformPoint(ToVec4(v, 1.f), ToMat4(matrix)));
+}
+
+// Transforms (x, y, z, 1) and divides by the resulting w (like XMVector3TransformCoord).
+inline Vector3 TransformCoord(const Vector3& v, const Matrix4& matrix)
+{
+    return ToVector3(SimdMath::TransformCoord(ToVec4(v, 1.f), ToMat4(matrix)));
+}
+
+// Same rotation as XMMatrixRotationAxis.
+inline Matrix4 RotationAxis(const Vector3& axis, float angle)
+{
+    Vector3 n = Normalize(axis);
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    float t = 1.f - c;
+
+    Matrix4 result;
+    result.m[0][0] = c + t * n.x * n.x;
+    result.m[0][1] = t * n.x * n.y + s * n.z;
+    result.m[0][2] = t * n.x * n.z - s * n.y;
+    result.m[1][0] = t * n.x * n.y - s * n.z;
+    result.m[1][1] = c + t * n.y * n.y;
+    result.m[1][2] = t * n.y * n.z + s * n.x;
+    result.m[2][0] = t * n.x * n.z + s * n.y;
+    result.m[2][1] = t * n.y * n.z - s * n.x;
+    result.m[2][2] = c + t * n.z * n.z;
+    return result;
+}
+
+// Same rotation as XMMatrixRotationQuaternion, expects a unit quaternion.
+inline Matrix4 RotationQuaternion(const Quaternion& q)
+{
+    Matrix4 result;
+    result.m[0][0] = 1.f - 2.f * (q.y * q.y + q.z * q.z);
+    result.m[0][1] = 2.f * (q.x * q.y + q.z * q.w);
+    result.m[0][2] = 2.f * (q.x * q.z - q.y * q.w);
+    result.m[1][0] = 2.f * (q.x * q.y - q.z * q.w);
+    result.m[1][1] = 1.f - 2.f * (q.x * q.x + q.z * q.z);
+    result.m[1][2] = 2.f * (q.y * q.z + q.x * q.w);
+    result.m[2][0] = 2.f * (q.x * q.z + q.y * q.w);
+    result.m[2][1] = 2.f * (q.y * q.z - q.x * q.w);
+    result.m[2][2] = 1.f - 2.f * (q.x * q.x + q.y * q.y);
+    return result;
+}
+
+inline Matrix4 Translation(const Vector3& offset)
+{
+    Matrix4 result;
+    result.m[3][0] = offset.x;
+    result.m[3][1] = offset.y;
+    result.m[3][2] = offset.z;
+    return result;
+}
+
+// Same matrix as XrMatrix4x4f_CreateProjectionFov with GRAPHICS_D3D (angles in radians, left and down are negative).
+inline Matrix4 ProjectionFov(float angleLeft, float angleRight, float angleUp, float angleDown, float nearZ, float farZ)
+{
+    const float tanLeft = std::tan(angleLeft);
+    const float tanRight = std::tan(angleRight);
+    const float tanUp = std::tan(angleUp);
+    const float tanDown = std::tan(angleDown);
+
+    const float tanWidth = tanRight - tanLeft;
+    const float tanHeight = tanUp - tanDown;
+
+    Matrix4 result;
+    result.m[0][0] = 2.f / tanWidth;
+    result.m[1][1] = 2.f / tanHeight;
+    result.m[2][0] = (tanRight + tanLeft) / tanWidth;
+    result.m[2][1] = (tanUp + tanDown) / tanHeight;
+    result.m[2][2] = -farZ / (farZ - nearZ);
+    result.m[2][3] = -1.f;
+    result.m[3][2] = -(farZ * nearZ) / (farZ - nearZ);
+    result.m[3][3] = 0.f;
+    return result;
+}
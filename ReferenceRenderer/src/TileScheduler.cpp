@@ -0,0 +1,216 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Tiles owned by one thread. The owner takes from the front, thieves from the back, so both walk
+// away from each other and the owner keeps working on neighbouring tiles.
+struct TileQueue
+{
+    std::mutex mutex;
+    std::deque<size_t> tiles;
+
+    bool PopFront(size_t& outTile)
+    {
+        std::lock_guard lock{ mutex };
+        if (tiles.empty()) return false;
+        outTile = tiles.front();
+        tiles.pop_front();
+        return true;
+    }
+
+    bool PopBack(size_t& outTile)
+    {
+        std::lock_guard lock{ mutex };
+        if (tiles.empty()) return false;
+        outTile = tiles.back();
+        tiles.pop_back();
+        return true;
+    }
+};
+
+// One RunTiles call as seen by the pool: worker slots 1 to threadCount - 1 wait for a pool thread, slot 0 is the caller.
+struct TileRun
+{
+    const std::function<void(int thread)>* worker = nullptr;
+    int threadCount = 0;
+    int claimedSlots = 1;
+    int activeHelpers = 0;
+};
+
+// Threads that live for the whole process, so short runs do not pay for creating and joining threads. Runs may be
+// started from several threads at once and from inside a tile: the caller works through the whole run by itself if
+// no pool thread is free, and the pool grows when every thread is busy, so nested runs never wait on each other.
+class WorkerPool
+{
+public:
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock{ mutex };
+            stop = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void Run(const std::function<void(int thread)>& worker, int threadCount)
+    {
+        TileRun run{};
+        run.worker = &worker;
+        run.threadCount = threadCount;
+        {
+            std::lock_guard lock{ mutex };
+            pending.push_back(&run);
+            const int helperCount = threadCount - 1;
+            for (int started = idleCount; started < helperCount; started++)
+            {
+                threads.emplace_back([this] { HelpLoop(); });
+                idleCount++;
+            }
+        }
+        workAvailable.notify_all();
+
+        worker(0);
+
+        // Every tile is taken once the caller's worker returns, only helpers still finishing their last tile remain
+        std::unique_lock lock{ mutex };
+        pending.erase(std::remove(pending.begin(), pending.end(), &run), pending.end());
+        helpersDone.wait(lock, [&] { return run.activeHelpers == 0; });
+    }
+
+private:
+    void HelpLoop()
+    {
+        std::unique_lock lock{ mutex };
+        while (true)
+        {
+            workAvailable.wait(lock, [&] { return stop || !pending.empty(); });
+            if (stop) return;
+
+            TileRun& run = *pending.front();
+            const int slot = run.claimedSlots++;
+            if (run.claimedSlots == run.threadCount) pending.pop_front();
+            run.activeHelpers++;
+            idleCount--;
+
+            lock.unlock();
+            (*run.worker)(slot);
+            lock.lock();
+
+            idleCount++;
+            if (--run.activeHelpers == 0) helpersDone.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable helpersDone;
+    std::deque<TileRun*> pending; // runs with unclaimed slots
+    std::vector<std::thread> threads;
+    int idleCount = 0;
+    bool stop = false;
+};
+
+static WorkerPool& GetWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void RunTiles(size_t tileCount, int threadCount, const std::function<void(size_t tile, int thread)>& runTile, SchedulerStatistics* outStatistics)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threadCount = std::max(1, std::min(threadCount, static_cast<int>(std::max<size_t>(tileCount, 1))));
+
+    auto runStart = std::chrono::high_resolution_clock::now();
+    std::vector<ThreadUtilization> utilization(threadCount);
+
+    // Contiguous blocks keep neighbouring tiles (and their texels) on the same thread
+    std::vector<std::unique_ptr<TileQueue>> queues;
+    for (int thread = 0; thread < threadCount; thread++)
+    {
+        queues.push_back(std::make_unique<TileQueue>());
+        const size_t blockStart = tileCount * thread / threadCount;
+        const size_t blockEnd = tileCount * (thread + 1) / threadCount;
+        for (size_t tile = blockStart; tile < blockEnd; tile++)
+        {
+            queues[thread]->tiles.push_back(tile);
+        }
+    }
+
+    const std::function<void(int thread)> worker = [&](int thread) {
+        ThreadUtilization& stats = utilization[thread];
+        while (true)
+        {
+            size_t tile;
+            bool stolen = false;
+            if (!queues[thread]->PopFront(tile))
+            {
+                // Own block is done, look for work starting with the next thread
+                bool found = false;
+                for (int offset = 1; offset < threadCount && !found; offset++)
+                {
+                    found = queues[(thread + offset) % threadCount]->PopBack(tile);
+                }
+                if (!found) return;
+                stolen = true;
+            }
+
+            auto tileStart = std::chrono::high_resolution_clock::now();
+            runTile(tile, thread);
+            stats.busyMilliseconds += MillisecondsSince(tileStart);
+            stats.tileCount++;
+            stats.stolenTileCount += stolen;
+        }
+    };
+
+    if (threadCount == 1)
+    {
+        worker(0);
+    }
+    else
+    {
+        GetWorkerPool().Run(worker, threadCount);
+    }
+
+    if (outStatistics != nullptr)
+    {
+        outStatistics->wallMilliseconds = MillisecondsSince(runStart);
+        outStatistics->threads = std::move(utilization);
+    }
+}
+
+void PrintSchedulerStatistics(const SchedulerStatistics& statistics, std::ostream& out)
+{
+    out << "Threads (wall " << std::fixed << std::setprecision(2) << statistics.wallMilliseconds << "ms):" << std::endl;
+    for (size_t thread = 0; thread < statistics.threads.size(); thread++)
+    {
+        const ThreadUtilization& stats = statistics.threads[thread];
+        const double utilization = statistics.wallMilliseconds > 0. ? stats.busyMilliseconds / statistics.wallMilliseconds * 100. : 0.;
+        out << "  " << thread
+            << ": tiles " << stats.tileCount << " (stolen " << stats.stolenTileCount << ")"
+            << ", busy " << stats.busyMilliseconds << "ms"
+            << ", utilization " << utilization << "%"
+            << std::endl;
+    }
+    out << std::defaultfloat;
+}
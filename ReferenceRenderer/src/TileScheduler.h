@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Work done by one worker thread during a scheduler run.
+struct ThreadUtilization
+{
+    size_t tileCount = 0;
+    size_t stolenTileCount = 0;
+    double busyMilliseconds = 0.;
+};
+
+struct SchedulerStatistics
+{
+    double wallMilliseconds = 0.;
+    std::vector<ThreadUtilization> threads;
+};
+
+// Runs tileCount independent work items on threadCount threads (0 = one per hardware thread).
+// Every thread starts with a contiguous block of tiles and steals from the end of another thread's block once its own
+// block is empty, so tiles of very different cost still end at about the same time. The calling thread takes part, the
+// others come from a pool that persists between runs. Blocks that no pool thread picks up are stolen like any other.
+// runTile gets the tile index and the index of the thread it runs on.
+void RunTiles(size_t tileCount, int threadCount, const std::function<void(size_t tile, int thread)>& runTile, SchedulerStatistics* outStatistics = nullptr);
+
+// Prints tiles, steals and busy time per thread. Utilization is busy time relative to the wall time of the run.
+void PrintSchedulerStatistics(const SchedulerStatistics& statistics, std::ostream& out = std::cout);
@@ -0,0 +1,1028 @@
+#include "ReplayTrace.h"
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_reflection.h>
+#if __has_include(<openxr/openxr_loader_negotiation.h>)
+#include <openxr/openxr_loader_negotiation.h>
+#else
+#include <loader_interfaces.h> // src/common of OpenXR-SDK before 1.0.29
+#endif
+
+#include "../../OpenXRViewer/xr_demo/software_swapchain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define REPLAY_EXPORT __declspec(dllexport)
+#else
+#define REPLAY_EXPORT __attribute__((visibility("default")))
+#endif
+
+// OpenXR runtime without hardware: a head mounted display whose two views replay a pose trace (PoseTrace.h) frame by
+// frame, swapchains of plain memory for the viewer's software graphics plugin (software_swapchain.h) and no
+// controllers. Sessions are headless (XR_MND_headless), there is no compositor, submitted layers are dropped.
+//
+// The loader finds the runtime through the manifest next to the library, for example
+//   XR_RUNTIME_JSON=<build>/ReplayRuntime/ReplayRuntime.json XR_REPLAY_TRACE=head.txt OpenXRViewer --graphics Software
+// Environment variables:
+//   XR_REPLAY_TRACE        pose trace or frame trace recorded by the viewer (--record) to replay, required
+//   XR_REPLAY_VIEW_WIDTH   recommended swapchain size per view, 1024 by default
+//   XR_REPLAY_VIEW_HEIGHT
+//   XR_REPLAY_PACED        1 makes xrWaitFrame block until the traced frame is due, otherwise frames follow each
+//                          other as fast as the application renders them (with the traced display times)
+//   XR_REPLAY_TIMINGS      CSV file that receives the CPU time of every frame
+//
+// The session stops after the last frame of the trace. Every reference space coincides with the space of the trace,
+// except VIEW, which follows the head (between the eyes, oriented like the left one). Applications must call the
+// runtime from one thread.
+
+namespace
+{
+    constexpr const char* RuntimeName = "OpenXRViewer replay runtime";
+    constexpr XrSystemId ReplaySystemId = 1;
+    constexpr uint32_t SwapchainImageCount = 3;
+    constexpr uint32_t MaxViewSize = 8192;
+    constexpr uint32_t DefaultViewSize = 1024;
+
+    constexpr int64_t SwapchainFormats[] = { SoftwareSwapchainFormatRGBA8, SoftwareSwapchainFormatBGRA8 };
+    constexpr XrReferenceSpaceType ReferenceSpaceTypes[] = { XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL, XR_REFERENCE_SPACE_TYPE_STAGE };
+
+    struct Session;
+
+    struct Instance
+    {
+        bool headlessEnabled = false;
+        ReplayTrace trace;
+        uint32_t viewWidth = DefaultViewSize;
+        uint32_t viewHeight = DefaultViewSize;
+        bool paced = false;
+        std::string timingsPath;
+
+        std::vector<std::string> paths; // XrPath i + 1
+        std::deque<XrEventDataBuffer> events;
+        Session* session = nullptr;
+    };
+
+    struct Session
+    {
+        Instance* instance = nullptr;
+        XrSessionState state = XR_SESSION_STATE_UNKNOWN;
+        bool running = false;
+
+        // Frame loop: waitedFrames counts xrWaitFrame calls, endedFrames xrEndFrame calls. Frame i of the trace is
+        // displayed at startTime + its display time.
+        XrTime startTime = 0;
+        size_t waitedFrames = 0;
+        size_t endedFrames = 0;
+        std::chrono::steady_clock::time_point frameStart{};
+        std::vector<double> frameMilliseconds;
+    };
+
+    struct Space
+    {
+        Session* session = nullptr;
+        bool isReferenceSpace = false;
+        XrReferenceSpaceType referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+        XrPosef pose{}; // poseInReferenceSpace or poseInActionSpace
+    };
+
+    struct Swapchain
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<std::unique_ptr<uint8_t[]>> images;
+        uint32_t nextImage = 0;
+    };
+
+    struct ActionSet {};
+    struct Action
+    {
+        XrActionType type = XR_ACTION_TYPE_BOOLEAN_INPUT;
+    };
+
+    template <typename Handle, typename Object>
+    Handle ToHandle(Object* object)
+    {
+        return reinterpret_cast<Handle>(object);
+    }
+
+    template <typename Object, typename Handle>
+    Object* FromHandle(Handle handle)
+    {
+        return reinterpret_cast<Object*>(handle);
+    }
+
+    XrTime Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint32_t ReadViewSize(const char* name)
+    {
+        const char* value = std::getenv(name);
+        if (value == nullptr) return DefaultViewSize;
+        return std::clamp(static_cast<uint32_t>(std::strtoul(value, nullptr, 10)), 1u, MaxViewSize);
+    }
+
+    // Two-call idiom of the xrEnumerate functions.
+    template <typename T>
+    XrResult WriteArray(const T* values, size_t count, uint32_t capacityInput, uint32_t* countOutput, T* output)
+    {
+        if (countOutput == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *countOutput = static_cast<uint32_t>(count);
+        if (capacityInput == 0) return XR_SUCCESS;
+        if (capacityInput < count || output == nullptr) return XR_ERROR_SIZE_INSUFFICIENT;
+        std::copy(values, values + count, output);
+        return XR_SUCCESS;
+    }
+
+    XrResult WriteString(const std::string& value, uint32_t capacityInput, uint32_t* countOutput, char* buffer)
+    {
+        return WriteArray(value.c_str(), value.size() + 1, capacityInput, countOutput, buffer);
+    }
+
+    // Poses map from the local space to the parent one: x' = q x + p
+
+    XrVector3f Rotate(const XrQuaternionf& q, const XrVector3f& v)
+    {
+        const XrVector3f u{ q.x, q.y, q.z };
+        const XrVector3f t{ 2.f * (u.y * v.z - u.z * v.y), 2.f * (u.z * v.x - u.x * v.z), 2.f * (u.x * v.y - u.y * v.x) };
+        return { v.x + q.w * t.x + (u.y * t.z - u.z * t.y), v.y + q.w * t.y + (u.z * t.x - u.x * t.z), v.z + q.w * t.z + (u.x * t.y - u.y * t.x) };
+    }
+
+    XrQuaternionf Multiply(const XrQuaternionf& a, const XrQuaternionf& b)
+    {
+        return { a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                 a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                 a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                 a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z };
+    }
+
+    // parent applied after child
+    XrPosef Compose(const XrPosef& parent, const XrPosef& child)
+    {
+        const XrVector3f offset = Rotate(parent.orientation, child.position);
+        return { Multiply(parent.orientation, child.orientation),
+                 { parent.position.x + offset.x, parent.position.y + offset.y, parent.position.z + offset.z } };
+    }
+
+    XrPosef Invert(const XrPosef& pose)
+    {
+        const XrQuaternionf conjugate{ -pose.orientation.x, -pose.orientation.y, -pose.orientation.z, pose.orientation.w };
+        const XrVector3f position = Rotate(conjugate, pose.position);
+        return { conjugate, { -position.x, -position.y, -position.z } };
+    }
+
+    XrPosef ToXrPose(const PoseSample& sample)
+    {
+        return { { sample.orientation.x, sample.orientation.y, sample.orientation.z, sample.orientation.w },
+                 { sample.position.x, sample.position.y, sample.position.z } };
+    }
+
+    const ReplayFrame& FrameAt(const Session& session, XrTime time)
+    {
+        const ReplayTrace& trace = session.instance->trace;
+        return trace.frames[FindReplayFrame(trace, time - session.startTime)];
+    }
+
+    // Pose of the space in the trace space, false for spaces that cannot be located (controllers).
+    bool LocateInTrace(const Space& space, XrTime time, XrPosef& outPose)
+    {
+        if (!space.isReferenceSpace) return false;
+        if (space.referenceSpaceType != XR_REFERENCE_SPACE_TYPE_VIEW)
+        {
+            outPose = space.pose;
+            return true;
+        }
+
+        const ReplayFrame& frame = FrameAt(*space.session, time);
+        XrPosef head = ToXrPose(frame.views[0]);
+        const XrPosef right = ToXrPose(frame.views[1]);
+        head.position = { (head.position.x + right.position.x) * .5f, (head.position.y + right.position.y) * .5f, (head.position.z + right.position.z) * .5f };
+        outPose = Compose(head, space.pose);
+        return true;
+    }
+
+    void QueueSessionState(Session& session, XrSessionState state)
+    {
+        XrEventDataBuffer buffer{ XR_TYPE_EVENT_DATA_BUFFER };
+        XrEventDataSessionStateChanged event{ XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED };
+        event.session = ToHandle<XrSession>(&session);
+        event.state = state;
+        event.time = Now();
+        std::memcpy(&buffer, &event, sizeof(event));
+        session.instance->events.push_back(buffer);
+        session.state = state;
+    }
+
+    // The focused session goes back through visible and synchronized to stopping.
+    void StopSession(Session& session)
+    {
+        if (session.state == XR_SESSION_STATE_FOCUSED) QueueSessionState(session, XR_SESSION_STATE_VISIBLE);
+        if (session.state == XR_SESSION_STATE_VISIBLE) QueueSessionState(session, XR_SESSION_STATE_SYNCHRONIZED);
+        if (session.state == XR_SESSION_STATE_SYNCHRONIZED) QueueSessionState(session, XR_SESSION_STATE_STOPPING);
+    }
+
+    void ReportFrameTimes(const Session& session)
+    {
+        std::vector<double> sorted = session.frameMilliseconds;
+        if (sorted.empty()) return;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.;
+        for (double milliseconds : sorted) total += milliseconds;
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s: %zu frames, CPU frame time mean %.3fms, median %.3fms, 99th percentile %.3fms, max %.3fms",
+                      RuntimeName, sorted.size(), total / sorted.size(), sorted[sorted.size() / 2], sorted[(sorted.size() * 99) / 100], sorted.back());
+        std::cout << line << std::endl;
+
+        const std::string& path = session.instance->timingsPath;
+        if (path.empty()) return;
+        std::ofstream file{ path };
+        if (!file)
+        {
+            std::cerr << RuntimeName << ": failed to write " << path << std::endl;
+            return;
+        }
+        file << "frame,display_time_s,cpu_ms\n";
+        for (size_t i = 0; i < session.frameMilliseconds.size(); i++)
+        {
+            const ReplayTrace& trace = session.instance->trace;
+            file << i << ',' << trace.frames[std::min(i, trace.frames.size() - 1)].displayTime * 1e-9 << ',' << session.frameMilliseconds[i] << '\n';
+        }
+    }
+
+    // Instance
+
+    XrResult XRAPI_CALL EnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput, uint32_t* propertyCountOutput, XrExtensionProperties* properties)
+    {
+        if (layerName != nullptr) return XR_ERROR_API_LAYER_NOT_PRESENT;
+        if (propertyCountOutput == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *propertyCountOutput = 1;
+        if (propertyCapacityInput == 0) return XR_SUCCESS;
+        if (properties == nullptr) return XR_ERROR_SIZE_INSUFFICIENT;
+        std::snprintf(properties[0].extensionName, XR_MAX_EXTENSION_NAME_SIZE, "%s", XR_MND_HEADLESS_EXTENSION_NAME);
+        properties[0].extensionVersion = XR_MND_headless_SPEC_VERSION;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL CreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance)
+    {
+        if (createInfo == nullptr || instance == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+
+        auto replayInstance = std::make_unique<Instance>();
+        for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++)
+        {
+            if (std::strcmp(createInfo->enabledExtensionNames[i], XR_MND_HEADLESS_EXTENSION_NAME) != 0) return XR_ERROR_EXTENSION_NOT_PRESENT;
+            replayInstance->headlessEnabled = true;
+        }
+
+        const char* tracePath = std::getenv("XR_REPLAY_TRACE");
+        if (tracePath == nullptr)
+        {
+            std::cerr << RuntimeName << ": XR_REPLAY_TRACE is not set" << std::endl;
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        try
+        {
+            replayInstance->trace = LoadReplayTrace(tracePath);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << RuntimeName << ": " << ex.what() << std::endl;
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+
+        replayInstance->viewWidth = ReadViewSize("XR_REPLAY_VIEW_WIDTH");
+        replayInstance->viewHeight = ReadViewSize("XR_REPLAY_VIEW_HEIGHT");
+        const char* paced = std::getenv("XR_REPLAY_PACED");
+        replayInstance->paced = paced != nullptr && std::strcmp(paced, "1") == 0;
+        const char* timingsPath = std::getenv("XR_REPLAY_TIMINGS");
+        if (timingsPath != nullptr) replayInstance->timingsPath = timingsPath;
+
+        *instance = ToHandle<XrInstance>(replayInstance.release());
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroyInstance(XrInstance instance)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        delete FromHandle<Instance>(instance);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (instanceProperties == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+        std::snprintf(instanceProperties->runtimeName, XR_MAX_RUNTIME_NAME_SIZE, "%s", RuntimeName);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL PollEvent(XrInstance instance, XrEventDataBuffer* eventData)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (eventData == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        std::deque<XrEventDataBuffer>& events = FromHandle<Instance>(instance)->events;
+        if (events.empty()) return XR_EVENT_UNAVAILABLE;
+        *eventData = events.front();
+        events.pop_front();
+        return XR_SUCCESS;
+    }
+
+#define REPLAY_ENUM_NAME(name, value) \
+    case name:                        \
+        std::snprintf(buffer, bufferSize, "%s", #name); \
+        return XR_SUCCESS;
+
+    XrResult XRAPI_CALL ResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE])
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        constexpr size_t bufferSize = XR_MAX_RESULT_STRING_SIZE;
+        switch (value)
+        {
+            XR_LIST_ENUM_XrResult(REPLAY_ENUM_NAME)
+        default:
+            std::snprintf(buffer, bufferSize, "XR_UNKNOWN_%s_%d", value < 0 ? "FAILURE" : "SUCCESS", static_cast<int>(value));
+            return XR_SUCCESS;
+        }
+    }
+
+    XrResult XRAPI_CALL StructureTypeToString(XrInstance instance, XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE])
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        constexpr size_t bufferSize = XR_MAX_STRUCTURE_NAME_SIZE;
+        switch (value)
+        {
+            XR_LIST_ENUM_XrStructureType(REPLAY_ENUM_NAME)
+        default:
+            std::snprintf(buffer, bufferSize, "XR_UNKNOWN_STRUCTURE_TYPE_%d", static_cast<int>(value));
+            return XR_SUCCESS;
+        }
+    }
+
+#undef REPLAY_ENUM_NAME
+
+    XrResult XRAPI_CALL StringToPath(XrInstance instance, const char* pathString, XrPath* path)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (pathString == nullptr || path == nullptr || pathString[0] != '/') return XR_ERROR_PATH_FORMAT_INVALID;
+        std::vector<std::string>& paths = FromHandle<Instance>(instance)->paths;
+        auto it = std::find(paths.begin(), paths.end(), pathString);
+        if (it == paths.end()) it = paths.insert(paths.end(), pathString);
+        *path = static_cast<XrPath>(it - paths.begin()) + 1;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL PathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        const std::vector<std::string>& paths = FromHandle<Instance>(instance)->paths;
+        if (path == XR_NULL_PATH || path > paths.size()) return XR_ERROR_PATH_INVALID;
+        return WriteString(paths[path - 1], bufferCapacityInput, bufferCountOutput, buffer);
+    }
+
+    // System
+
+    XrResult XRAPI_CALL GetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr || systemId == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+        *systemId = ReplaySystemId;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+        if (properties == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        properties->systemId = systemId;
+        properties->vendorId = 0;
+        std::snprintf(properties->systemName, XR_MAX_SYSTEM_NAME_SIZE, "%s", RuntimeName);
+        properties->graphicsProperties.maxSwapchainImageWidth = MaxViewSize;
+        properties->graphicsProperties.maxSwapchainImageHeight = MaxViewSize;
+        properties->graphicsProperties.maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED;
+        properties->trackingProperties.orientationTracking = XR_TRUE;
+        properties->trackingProperties.positionTracking = XR_TRUE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                       uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+        if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+        constexpr XrEnvironmentBlendMode blendModes[] = { XR_ENVIRONMENT_BLEND_MODE_OPAQUE };
+        return WriteArray(blendModes, std::size(blendModes), environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes);
+    }
+
+    XrResult XRAPI_CALL EnumerateViewConfigurations(XrInstance instance, XrSystemId systemId, uint32_t viewConfigurationTypeCapacityInput,
+                                                    uint32_t* viewConfigurationTypeCountOutput, XrViewConfigurationType* viewConfigurationTypes)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+        constexpr XrViewConfigurationType types[] = { XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO };
+        return WriteArray(types, std::size(types), viewConfigurationTypeCapacityInput, viewConfigurationTypeCountOutput, viewConfigurationTypes);
+    }
+
+    XrResult XRAPI_CALL GetViewConfigurationProperties(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                       XrViewConfigurationProperties* configurationProperties)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+        if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+        if (configurationProperties == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        configurationProperties->viewConfigurationType = viewConfigurationType;
+        configurationProperties->fovMutable = XR_FALSE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType,
+                                                        uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+        if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+        if (viewCountOutput == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *viewCountOutput = ReplayViewCount;
+        if (viewCapacityInput == 0) return XR_SUCCESS;
+        if (viewCapacityInput < ReplayViewCount || views == nullptr) return XR_ERROR_SIZE_INSUFFICIENT;
+
+        const Instance& replayInstance = *FromHandle<Instance>(instance);
+        for (int i = 0; i < ReplayViewCount; i++)
+        {
+            views[i].recommendedImageRectWidth = replayInstance.viewWidth;
+            views[i].maxImageRectWidth = MaxViewSize;
+            views[i].recommendedImageRectHeight = replayInstance.viewHeight;
+            views[i].maxImageRectHeight = MaxViewSize;
+            views[i].recommendedSwapchainSampleCount = 1;
+            views[i].maxSwapchainSampleCount = 1;
+        }
+        return XR_SUCCESS;
+    }
+
+    // Session
+
+    XrResult XRAPI_CALL CreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || session == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (createInfo->systemId != ReplaySystemId) return XR_ERROR_SYSTEM_INVALID;
+
+        // Only headless sessions, there is no graphics API to bind
+        Instance& replayInstance = *FromHandle<Instance>(instance);
+        if (!replayInstance.headlessEnabled) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+        if (createInfo->next != nullptr) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+        if (replayInstance.session != nullptr) return XR_ERROR_LIMIT_REACHED;
+
+        Session* replaySession = new Session();
+        replaySession->instance = &replayInstance;
+        replayInstance.session = replaySession;
+        QueueSessionState(*replaySession, XR_SESSION_STATE_IDLE);
+        QueueSessionState(*replaySession, XR_SESSION_STATE_READY);
+        *session = ToHandle<XrSession>(replaySession);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroySession(XrSession session)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        Session* replaySession = FromHandle<Session>(session);
+        replaySession->instance->session = nullptr;
+        delete replaySession;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL BeginSession(XrSession session, const XrSessionBeginInfo* beginInfo)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (beginInfo == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (replaySession.running) return XR_ERROR_SESSION_RUNNING;
+        if (replaySession.state != XR_SESSION_STATE_READY) return XR_ERROR_SESSION_NOT_READY;
+
+        // The first frame is due one period from now
+        replaySession.running = true;
+        replaySession.startTime = Now() + ReplayFramePeriod(replaySession.instance->trace, 0);
+        replaySession.waitedFrames = 0;
+        replaySession.endedFrames = 0;
+        replaySession.frameMilliseconds.clear();
+        QueueSessionState(replaySession, XR_SESSION_STATE_SYNCHRONIZED);
+        QueueSessionState(replaySession, XR_SESSION_STATE_VISIBLE);
+        QueueSessionState(replaySession, XR_SESSION_STATE_FOCUSED);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EndSession(XrSession session)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (!replaySession.running) return XR_ERROR_SESSION_NOT_RUNNING;
+        if (replaySession.state != XR_SESSION_STATE_STOPPING) return XR_ERROR_SESSION_NOT_STOPPING;
+
+        replaySession.running = false;
+        ReportFrameTimes(replaySession);
+        QueueSessionState(replaySession, XR_SESSION_STATE_IDLE);
+        QueueSessionState(replaySession, XR_SESSION_STATE_EXITING);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL RequestExitSession(XrSession session)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (!replaySession.running) return XR_ERROR_SESSION_NOT_RUNNING;
+        StopSession(replaySession);
+        return XR_SUCCESS;
+    }
+
+    // Frames
+
+    XrResult XRAPI_CALL WaitFrame(XrSession session, const XrFrameWaitInfo* /*frameWaitInfo*/, XrFrameState* frameState)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (frameState == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (!replaySession.running) return XR_ERROR_SESSION_NOT_RUNNING;
+
+        // Frames past the end of the trace (before the application saw the stop) repeat the last one
+        const ReplayTrace& trace = replaySession.instance->trace;
+        const size_t frameIndex = std::min(replaySession.waitedFrames, trace.frames.size() - 1);
+        frameState->predictedDisplayTime = replaySession.startTime + trace.frames[frameIndex].displayTime;
+        frameState->predictedDisplayPeriod = ReplayFramePeriod(trace, frameIndex);
+        frameState->shouldRender = replaySession.state == XR_SESSION_STATE_VISIBLE || replaySession.state == XR_SESSION_STATE_FOCUSED ? XR_TRUE : XR_FALSE;
+
+        // A compositor would release the application one period before the frame is displayed
+        if (replaySession.instance->paced)
+        {
+            const XrTime wakeTime = frameState->predictedDisplayTime - frameState->predictedDisplayPeriod;
+            const XrTime now = Now();
+            if (wakeTime > now) std::this_thread::sleep_for(std::chrono::nanoseconds(wakeTime - now));
+        }
+
+        replaySession.waitedFrames++;
+        replaySession.frameStart = std::chrono::steady_clock::now();
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL BeginFrame(XrSession session, const XrFrameBeginInfo* /*frameBeginInfo*/)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (!replaySession.running) return XR_ERROR_SESSION_NOT_RUNNING;
+        if (replaySession.waitedFrames == replaySession.endedFrames) return XR_ERROR_CALL_ORDER_INVALID;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (frameEndInfo == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        Session& replaySession = *FromHandle<Session>(session);
+        if (!replaySession.running) return XR_ERROR_SESSION_NOT_RUNNING;
+        if (replaySession.waitedFrames == replaySession.endedFrames) return XR_ERROR_CALL_ORDER_INVALID;
+        if (frameEndInfo->environmentBlendMode != XR_ENVIRONMENT_BLEND_MODE_OPAQUE) return XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED;
+
+        // CPU time of the frame: from the return of xrWaitFrame until the frame is submitted
+        const auto frameEnd = std::chrono::steady_clock::now();
+        replaySession.frameMilliseconds.push_back(std::chrono::duration<double, std::milli>(frameEnd - replaySession.frameStart).count());
+        replaySession.endedFrames++;
+        if (replaySession.endedFrames == replaySession.instance->trace.frames.size()) StopSession(replaySession);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL LocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState,
+                                    uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (viewLocateInfo == nullptr || viewState == nullptr || viewCountOutput == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (viewLocateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+        if (viewLocateInfo->space == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        *viewCountOutput = ReplayViewCount;
+        if (viewCapacityInput == 0) return XR_SUCCESS;
+        if (viewCapacityInput < ReplayViewCount || views == nullptr) return XR_ERROR_SIZE_INSUFFICIENT;
+
+        const Session& replaySession = *FromHandle<Session>(session);
+        XrPosef spacePose{};
+        if (!LocateInTrace(*FromHandle<Space>(viewLocateInfo->space), viewLocateInfo->displayTime, spacePose))
+        {
+            viewState->viewStateFlags = 0;
+            return XR_SUCCESS;
+        }
+
+        const XrPosef traceToSpace = Invert(spacePose);
+        const ReplayFrame& frame = FrameAt(replaySession, viewLocateInfo->displayTime);
+        for (int i = 0; i < ReplayViewCount; i++)
+        {
+            const PoseSample& sample = frame.views[i];
+            views[i].pose = Compose(traceToSpace, ToXrPose(sample));
+            views[i].fov = { sample.angleLeft, sample.angleRight, sample.angleUp, sample.angleDown };
+        }
+        viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+                                    XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+        return XR_SUCCESS;
+    }
+
+    // Spaces
+
+    XrResult XRAPI_CALL EnumerateReferenceSpaces(XrSession session, uint32_t spaceCapacityInput, uint32_t* spaceCountOutput, XrReferenceSpaceType* spaces)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return WriteArray(ReferenceSpaceTypes, std::size(ReferenceSpaceTypes), spaceCapacityInput, spaceCountOutput, spaces);
+    }
+
+    XrResult XRAPI_CALL CreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || space == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (std::find(std::begin(ReferenceSpaceTypes), std::end(ReferenceSpaceTypes), createInfo->referenceSpaceType) == std::end(ReferenceSpaceTypes))
+        {
+            return XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+        }
+
+        Space* replaySpace = new Space();
+        replaySpace->session = FromHandle<Session>(session);
+        replaySpace->isReferenceSpace = true;
+        replaySpace->referenceSpaceType = createInfo->referenceSpaceType;
+        replaySpace->pose = createInfo->poseInReferenceSpace;
+        *space = ToHandle<XrSpace>(replaySpace);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType /*referenceSpaceType*/, XrExtent2Df* bounds)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (bounds == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *bounds = { 0.f, 0.f };
+        return XR_SPACE_BOUNDS_UNAVAILABLE;
+    }
+
+    XrResult XRAPI_CALL CreateActionSpace(XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || space == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        Space* replaySpace = new Space();
+        replaySpace->session = FromHandle<Session>(session);
+        replaySpace->pose = createInfo->poseInActionSpace;
+        *space = ToHandle<XrSpace>(replaySpace);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL LocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)
+    {
+        if (space == XR_NULL_HANDLE || baseSpace == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (location == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        XrPosef spacePose{};
+        XrPosef basePose{};
+        if (!LocateInTrace(*FromHandle<Space>(space), time, spacePose) || !LocateInTrace(*FromHandle<Space>(baseSpace), time, basePose))
+        {
+            location->locationFlags = 0;
+            return XR_SUCCESS;
+        }
+        location->pose = Compose(Invert(basePose), spacePose);
+        location->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                                  XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroySpace(XrSpace space)
+    {
+        if (space == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        delete FromHandle<Space>(space);
+        return XR_SUCCESS;
+    }
+
+    // Swapchains
+
+    XrResult XRAPI_CALL EnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return WriteArray(SwapchainFormats, std::size(SwapchainFormats), formatCapacityInput, formatCountOutput, formats);
+    }
+
+    XrResult XRAPI_CALL CreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || swapchain == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        if (std::find(std::begin(SwapchainFormats), std::end(SwapchainFormats), createInfo->format) == std::end(SwapchainFormats))
+        {
+            return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+        }
+        if (createInfo->width == 0 || createInfo->height == 0 || createInfo->width > MaxViewSize || createInfo->height > MaxViewSize ||
+            createInfo->arraySize != 1 || createInfo->faceCount != 1 || createInfo->mipCount != 1 || createInfo->sampleCount != 1)
+        {
+            return XR_ERROR_FEATURE_UNSUPPORTED;
+        }
+
+        Swapchain* replaySwapchain = new Swapchain();
+        replaySwapchain->width = createInfo->width;
+        replaySwapchain->height = createInfo->height;
+        for (uint32_t i = 0; i < SwapchainImageCount; i++)
+        {
+            replaySwapchain->images.push_back(std::make_unique<uint8_t[]>(static_cast<size_t>(createInfo->width) * createInfo->height * 4));
+        }
+        *swapchain = ToHandle<XrSwapchain>(replaySwapchain);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroySwapchain(XrSwapchain swapchain)
+    {
+        if (swapchain == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        delete FromHandle<Swapchain>(swapchain);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images)
+    {
+        if (swapchain == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (imageCountOutput == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *imageCountOutput = SwapchainImageCount;
+        if (imageCapacityInput == 0) return XR_SUCCESS;
+        if (imageCapacityInput < SwapchainImageCount || images == nullptr) return XR_ERROR_SIZE_INSUFFICIENT;
+        if (images->type != XR_TYPE_SWAPCHAIN_IMAGE_SOFTWARE_VIEWER) return XR_ERROR_VALIDATION_FAILURE;
+
+        const Swapchain& replaySwapchain = *FromHandle<Swapchain>(swapchain);
+        XrSwapchainImageSoftwareViewer* softwareImages = reinterpret_cast<XrSwapchainImageSoftwareViewer*>(images);
+        for (uint32_t i = 0; i < SwapchainImageCount; i++)
+        {
+            softwareImages[i].pixels = replaySwapchain.images[i].get();
+            softwareImages[i].rowPitch = replaySwapchain.width * 4;
+        }
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL AcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* /*acquireInfo*/, uint32_t* index)
+    {
+        if (swapchain == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (index == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        Swapchain& replaySwapchain = *FromHandle<Swapchain>(swapchain);
+        *index = replaySwapchain.nextImage;
+        replaySwapchain.nextImage = (replaySwapchain.nextImage + 1) % SwapchainImageCount;
+        return XR_SUCCESS;
+    }
+
+    // Images are written by the CPU before release, nothing to wait for
+    XrResult XRAPI_CALL WaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* /*waitInfo*/)
+    {
+        return swapchain == XR_NULL_HANDLE ? XR_ERROR_HANDLE_INVALID : XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL ReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* /*releaseInfo*/)
+    {
+        return swapchain == XR_NULL_HANDLE ? XR_ERROR_HANDLE_INVALID : XR_SUCCESS;
+    }
+
+    // Actions: accepted and never active, the replayed device has no controllers
+
+    XrResult XRAPI_CALL CreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || actionSet == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *actionSet = ToHandle<XrActionSet>(new ActionSet());
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroyActionSet(XrActionSet actionSet)
+    {
+        if (actionSet == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        delete FromHandle<ActionSet>(actionSet);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL CreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action)
+    {
+        if (actionSet == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (createInfo == nullptr || action == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        Action* replayAction = new Action();
+        replayAction->type = createInfo->actionType;
+        *action = ToHandle<XrAction>(replayAction);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL DestroyAction(XrAction action)
+    {
+        if (action == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        delete FromHandle<Action>(action);
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL SuggestInteractionProfileBindings(XrInstance instance, const XrInteractionProfileSuggestedBinding* suggestedBindings)
+    {
+        if (instance == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return suggestedBindings == nullptr ? XR_ERROR_VALIDATION_FAILURE : XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL AttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo* attachInfo)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return attachInfo == nullptr ? XR_ERROR_VALIDATION_FAILURE : XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetCurrentInteractionProfile(XrSession session, XrPath /*topLevelUserPath*/, XrInteractionProfileState* interactionProfile)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (interactionProfile == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        interactionProfile->interactionProfile = XR_NULL_PATH;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL SyncActions(XrSession session, const XrActionsSyncInfo* syncInfo)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (syncInfo == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        return FromHandle<Session>(session)->state == XR_SESSION_STATE_FOCUSED ? XR_SUCCESS : XR_SESSION_NOT_FOCUSED;
+    }
+
+    XrResult XRAPI_CALL GetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr || state == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        state->currentState = XR_FALSE;
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        state->isActive = XR_FALSE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr || state == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        state->currentState = 0.f;
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        state->isActive = XR_FALSE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetActionStateVector2f(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* state)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr || state == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        state->currentState = { 0.f, 0.f };
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        state->isActive = XR_FALSE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetActionStatePose(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStatePose* state)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr || state == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        state->isActive = XR_FALSE;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL EnumerateBoundSourcesForAction(XrSession session, const XrBoundSourcesForActionEnumerateInfo* enumerateInfo,
+                                                       uint32_t sourceCapacityInput, uint32_t* sourceCountOutput, XrPath* sources)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (enumerateInfo == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        return WriteArray<XrPath>(nullptr, 0, sourceCapacityInput, sourceCountOutput, sources);
+    }
+
+    XrResult XRAPI_CALL GetInputSourceLocalizedName(XrSession session, const XrInputSourceLocalizedNameGetInfo* getInfo,
+                                                    uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        if (getInfo == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        return WriteString("", bufferCapacityInput, bufferCountOutput, buffer);
+    }
+
+    XrResult XRAPI_CALL ApplyHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo, const XrHapticBaseHeader* hapticFeedback)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return hapticActionInfo == nullptr || hapticFeedback == nullptr ? XR_ERROR_VALIDATION_FAILURE : XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL StopHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo)
+    {
+        if (session == XR_NULL_HANDLE) return XR_ERROR_HANDLE_INVALID;
+        return hapticActionInfo == nullptr ? XR_ERROR_VALIDATION_FAILURE : XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL GetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
+
+    struct NamedFunction
+    {
+        const char* name;
+        PFN_xrVoidFunction function;
+        bool withoutInstance; // may be queried with XR_NULL_HANDLE
+    };
+
+#define REPLAY_FUNCTION(name, function) { name, reinterpret_cast<PFN_xrVoidFunction>(function), false }
+
+    const NamedFunction Functions[] = {
+        { "xrGetInstanceProcAddr", reinterpret_cast<PFN_xrVoidFunction>(GetInstanceProcAddr), true },
+        { "xrEnumerateInstanceExtensionProperties", reinterpret_cast<PFN_xrVoidFunction>(EnumerateInstanceExtensionProperties), true },
+        { "xrCreateInstance", reinterpret_cast<PFN_xrVoidFunction>(CreateInstance), true },
+        REPLAY_FUNCTION("xrDestroyInstance", DestroyInstance),
+        REPLAY_FUNCTION("xrGetInstanceProperties", GetInstanceProperties),
+        REPLAY_FUNCTION("xrPollEvent", PollEvent),
+        REPLAY_FUNCTION("xrResultToString", ResultToString),
+        REPLAY_FUNCTION("xrStructureTypeToString", StructureTypeToString),
+        REPLAY_FUNCTION("xrStringToPath", StringToPath),
+        REPLAY_FUNCTION("xrPathToString", PathToString),
+        REPLAY_FUNCTION("xrGetSystem", GetSystem),
+        REPLAY_FUNCTION("xrGetSystemProperties", GetSystemProperties),
+        REPLAY_FUNCTION("xrEnumerateEnvironmentBlendModes", EnumerateEnvironmentBlendModes),
+        REPLAY_FUNCTION("xrEnumerateViewConfigurations", EnumerateViewConfigurations),
+        REPLAY_FUNCTION("xrGetViewConfigurationProperties", GetViewConfigurationProperties),
+        REPLAY_FUNCTION("xrEnumerateViewConfigurationViews", EnumerateViewConfigurationViews),
+        REPLAY_FUNCTION("xrCreateSession", CreateSession),
+        REPLAY_FUNCTION("xrDestroySession", DestroySession),
+        REPLAY_FUNCTION("xrBeginSession", BeginSession),
+        REPLAY_FUNCTION("xrEndSession", EndSession),
+        REPLAY_FUNCTION("xrRequestExitSession", RequestExitSession),
+        REPLAY_FUNCTION("xrWaitFrame", WaitFrame),
+        REPLAY_FUNCTION("xrBeginFrame", BeginFrame),
+        REPLAY_FUNCTION("xrEndFrame", EndFrame),
+        REPLAY_FUNCTION("xrLocateViews", LocateViews),
+        REPLAY_FUNCTION("xrEnumerateReferenceSpaces", EnumerateReferenceSpaces),
+        REPLAY_FUNCTION("xrCreateReferenceSpace", CreateReferenceSpace),
+        REPLAY_FUNCTION("xrGetReferenceSpaceBoundsRect", GetReferenceSpaceBoundsRect),
+        REPLAY_FUNCTION("xrCreateActionSpace", CreateActionSpace),
+        REPLAY_FUNCTION("xrLocateSpace", LocateSpace),
+        REPLAY_FUNCTION("xrDestroySpace", DestroySpace),
+        REPLAY_FUNCTION("xrEnumerateSwapchainFormats", EnumerateSwapchainFormats),
+        REPLAY_FUNCTION("xrCreateSwapchain", CreateSwapchain),
+        REPLAY_FUNCTION("xrDestroySwapchain", DestroySwapchain),
+        REPLAY_FUNCTION("xrEnumerateSwapchainImages", EnumerateSwapchainImages),
+        REPLAY_FUNCTION("xrAcquireSwapchainImage", AcquireSwapchainImage),
+        REPLAY_FUNCTION("xrWaitSwapchainImage", WaitSwapchainImage),
+        REPLAY_FUNCTION("xrReleaseSwapchainImage", ReleaseSwapchainImage),
+        REPLAY_FUNCTION("xrCreateActionSet", CreateActionSet),
+        REPLAY_FUNCTION("xrDestroyActionSet", DestroyActionSet),
+        REPLAY_FUNCTION("xrCreateAction", CreateAction),
+        REPLAY_FUNCTION("xrDestroyAction", DestroyAction),
+        REPLAY_FUNCTION("xrSuggestInteractionProfileBindings", SuggestInteractionProfileBindings),
+        REPLAY_FUNCTION("xrAttachSessionActionSets", AttachSessionActionSets),
+        REPLAY_FUNCTION("xrGetCurrentInteractionProfile", GetCurrentInteractionProfile),
+        REPLAY_FUNCTION("xrSyncActions", SyncActions),
+        REPLAY_FUNCTION("xrGetActionStateBoolean", GetActionStateBoolean),
+        REPLAY_FUNCTION("xrGetActionStateFloat", GetActionStateFloat),
+        REPLAY_FUNCTION("xrGetActionStateVector2f", GetActionStateVector2f),
+        REPLAY_FUNCTION("xrGetActionStatePose", GetActionStatePose),
+        REPLAY_FUNCTION("xrEnumerateBoundSourcesForAction", EnumerateBoundSourcesForAction),
+        REPLAY_FUNCTION("xrGetInputSourceLocalizedName", GetInputSourceLocalizedName),
+        REPLAY_FUNCTION("xrApplyHapticFeedback", ApplyHapticFeedback),
+        REPLAY_FUNCTION("xrStopHapticFeedback", StopHapticFeedback),
+    };
+
+#undef REPLAY_FUNCTION
+
+    XrResult XRAPI_CALL GetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
+    {
+        if (name == nullptr || function == nullptr) return XR_ERROR_VALIDATION_FAILURE;
+        *function = nullptr;
+        for (const NamedFunction& entry : Functions)
+        {
+            if (std::strcmp(entry.name, name) != 0) continue;
+            if (instance == XR_NULL_HANDLE && !entry.withoutInstance) return XR_ERROR_HANDLE_INVALID;
+            *function = entry.function;
+            return XR_SUCCESS;
+        }
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+}
+
+// Entry point of the runtime, called by the loader after it loaded the library named in the manifest.
+extern "C" REPLAY_EXPORT XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(const XrNegotiateLoaderInfo* loaderInfo, XrNegotiateRuntimeRequest* runtimeRequest)
+{
+    if (loaderInfo == nullptr || runtimeRequest == nullptr ||
+        loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO || loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION ||
+        loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+        runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST || runtimeRequest->structVersion != XR_RUNTIME_INFO_STRUCT_VERSION ||
+        runtimeRequest->structSize != sizeof(XrNegotiateRuntimeRequest))
+    {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    if (loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION || loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->minApiVersion > XR_CURRENT_API_VERSION || loaderInfo->maxApiVersion < XR_CURRENT_API_VERSION)
+    {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+    runtimeRequest->getInstanceProcAddr = GetInstanceProcAddr;
+    return XR_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "ReplayTrace.h"
+
+#include "../../OpenXRViewer/xr_demo/frame_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    bool IsFrameTrace(const std::string& path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return file && magic == FrameTraceMagic;
+    }
+
+    // One sample per located view of every tracked frame, timed by its predicted display time.
+    std::vector<PoseSample> LoadFrameTracePoses(const std::string& path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        FrameTraceHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.version != FrameTraceVersion || header.recordSize != sizeof(FrameTraceRecord) || header.viewCount != FrameTraceViewCount)
+        {
+            throw std::runtime_error("Frame trace " + path + " has an unsupported version");
+        }
+
+        constexpr XrViewStateFlags TrackedFlags = XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_VALID_BIT;
+        std::vector<PoseSample> samples;
+        XrTime startTime = 0;
+        FrameTraceRecord record{};
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            if ((record.viewStateFlags & TrackedFlags) != TrackedFlags) continue;
+            if (samples.empty()) startTime = record.predictedDisplayTime;
+
+            for (uint32_t eye = 0; eye < std::min(record.viewCount, FrameTraceViewCount); eye++)
+            {
+                const FrameTraceView& view = record.views[eye];
+                PoseSample sample{};
+                sample.time = static_cast<double>(record.predictedDisplayTime - startTime) * 1e-9;
+                sample.eye = static_cast<int>(eye);
+                sample.position = { view.pose.position.x, view.pose.position.y, view.pose.position.z };
+                sample.orientation = { view.pose.orientation.x, view.pose.orientation.y, view.pose.orientation.z, view.pose.orientation.w };
+                sample.angleLeft = view.fov.angleLeft;
+                sample.angleRight = view.fov.angleRight;
+                sample.angleUp = view.fov.angleUp;
+                sample.angleDown = view.fov.angleDown;
+                samples.push_back(sample);
+            }
+        }
+        return samples;
+    }
+}
+
+ReplayTrace BuildReplayTrace(const std::vector<PoseSample>& samples)
+{
+    ReplayTrace trace{};
+    bool hasView[ReplayViewCount] = {};
+    double sampleTime = 0.;
+    for (const PoseSample& sample : samples)
+    {
+        const int eye = std::clamp(sample.eye, 0, ReplayViewCount - 1);
+        const bool newFrame = trace.frames.empty() || sample.time != sampleTime || hasView[eye];
+        if (newFrame)
+        {
+            ReplayFrame frame{};
+            frame.displayTime = std::llround(sample.time * 1e9);
+            if (!trace.frames.empty())
+            {
+                const int64_t previousTime = trace.frames.back().displayTime;
+                if (!(frame.displayTime > previousTime)) frame.displayTime = previousTime + DefaultReplayPeriod;
+            }
+            trace.frames.push_back(frame);
+            std::fill(std::begin(hasView), std::end(hasView), false);
+            sampleTime = sample.time;
+        }
+
+        ReplayFrame& frame = trace.frames.back();
+        frame.views[eye] = sample;
+        hasView[eye] = true;
+        if (eye == 0 && !hasView[1]) frame.views[1] = sample;
+    }
+
+    // Display times count from the first frame
+    if (!trace.frames.empty())
+    {
+        const int64_t startTime = trace.frames.front().displayTime;
+        for (ReplayFrame& frame : trace.frames)
+        {
+            frame.displayTime -= startTime;
+        }
+    }
+    return trace;
+}
+
+ReplayTrace LoadReplayTrace(const std::string& path)
+{
+    ReplayTrace trace = BuildReplayTrace(IsFrameTrace(path) ? LoadFrameTracePoses(path) : LoadPoseTrace(path));
+    if (trace.frames.empty())
+    {
+        throw std::runtime_error("Pose trace " + path + " contains no poses");
+    }
+    return trace;
+}
+
+int64_t ReplayFramePeriod(const ReplayTrace& trace, size_t frameIndex)
+{
+    if (trace.frames.size() < 2) return DefaultReplayPeriod;
+    const size_t next = std::min(frameIndex + 1, trace.frames.size() - 1);
+    const size_t current = next - 1;
+    return trace.frames[next].displayTime - trace.frames[current].displayTime;
+}
+
+size_t FindReplayFrame(const ReplayTrace& trace, int64_t displayTime)
+{
+    auto later = std::upper_bound(trace.frames.begin(), trace.frames.end(), displayTime,
+                                  [](int64_t time, const ReplayFrame& frame) { return time < frame.displayTime; });
+    return later == trace.frames.begin() ? 0 : static_cast<size_t>(later - trace.frames.begin()) - 1;
+}
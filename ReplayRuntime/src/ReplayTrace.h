@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../../ReferenceRenderer/src/PoseTrace.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A pose trace (PoseTrace.h) cut into the frames the replay runtime hands out, one sample per eye.
+
+constexpr int ReplayViewCount = 2;
+
+// Frame period for traces without usable timestamps (hand-written pose lists use 0 everywhere), 90 Hz, in nanoseconds.
+constexpr int64_t DefaultReplayPeriod = 11111111;
+
+struct ReplayFrame
+{
+    // Nanoseconds since the first frame, like XrTime: the runtime hands out exactly these times and looks them up again,
+    // so they must not pass through a rounding conversion on the way.
+    int64_t displayTime = 0;
+    PoseSample views[ReplayViewCount];
+};
+
+struct ReplayTrace
+{
+    std::vector<ReplayFrame> frames;
+};
+
+// A frame ends when the time changes or an eye repeats. Frames missing the right eye reuse the left one, so mono
+// traces replay with both eyes at the same pose. Display times are made strictly increasing, frames that do not advance
+// the time are placed DefaultReplayPeriod after the previous one.
+ReplayTrace BuildReplayTrace(const std::vector<PoseSample>& samples);
+
+// Reads text pose traces as well as the binary frame traces the viewer records (frame_trace.h).
+// Throws std::runtime_error for missing, malformed or empty traces.
+ReplayTrace LoadReplayTrace(const std::string& path);
+
+// Nanoseconds from this frame to the next one, the last frame repeats the period before it.
+int64_t ReplayFramePeriod(const ReplayTrace& trace, size_t frameIndex);
+
+// Index of the last frame displayed at or before the time (nanoseconds since the first frame), 0 for earlier times.
+size_t FindReplayFrame(const ReplayTrace& trace, int64_t displayTime);
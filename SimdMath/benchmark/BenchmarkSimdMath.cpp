@@ -0,0 +1,235 @@
+#include "../src/SimdMath.h"
+#include "../src/SphereMapping.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compares the SimdMath approximations against double precision std:: functions (accuracy) and against a plain
+// float std:: loop (throughput). Exits with 1 if an error exceeds the bound documented in the headers.
+
+constexpr double ExactPi = 3.14159265358979323846;
+
+struct BenchmarkOptions
+{
+    size_t count = 1 << 20;
+    int iterations = 10;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkSimdMath [--count|-n <values per function>] [--iterations|-i <best of>]" << std::endl;
+}
+
+bool ParseCommandLine(BenchmarkOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--count" || arg == "-n")
+        {
+            options.count = std::stoul(getNextArg());
+        }
+        else if (arg == "--iterations" || arg == "-i")
+        {
+            options.iterations = std::stoi(getNextArg());
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return true;
+}
+
+double MeasureBest(int iterations, const std::function<void()>& run)
+{
+    double bestMilliseconds = 0.;
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        run();
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(measureEnd - measureStart).count();
+        bestMilliseconds = iteration == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+    }
+    return bestMilliseconds;
+}
+
+// Deterministic pseudo random values in [minValue, maxValue]
+std::vector<float> MakeInputs(size_t count, float minValue, float maxValue, uint32_t seed)
+{
+    std::vector<float> values(count);
+    uint32_t state = seed;
+    for (float& value : values)
+    {
+        state = state * 1664525u + 1013904223u;
+        value = minValue + (maxValue - minValue) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+    }
+    return values;
+}
+
+struct Report
+{
+    bool passed = true;
+
+    void Print(const char* name, double maxError, double bound, double fastMilliseconds, double stdMilliseconds, size_t count)
+    {
+        const bool withinBound = maxError <= bound;
+        passed &= withinBound;
+        std::cout << "  " << name << ": max error " << maxError << " (bound " << bound << (withinBound ? ")" : ", EXCEEDED)")
+                  << ", " << count / fastMilliseconds / 1000. << " M/s vs std " << count / stdMilliseconds / 1000. << " M/s"
+                  << ", " << stdMilliseconds / fastMilliseconds << "x" << std::endl;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options{};
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    const size_t count = options.count;
+    std::cout << "SimdMath " << SimdMath::InstructionSet << " (" << SimdMath::Width << " wide), " << count << " values, best of " << options.iterations << std::endl;
+    Report report{};
+
+    // Directions covering the whole sphere, including the exact poles and axes
+    std::vector<float> x = MakeInputs(count, -1.f, 1.f, 1);
+    std::vector<float> y = MakeInputs(count, -1.f, 1.f, 2);
+    std::vector<float> z = MakeInputs(count, -1.f, 1.f, 3);
+    if (count >= 4)
+    {
+        x[0] = 0.f; y[0] = 1.f; z[0] = 0.f;
+        x[1] = 0.f; y[1] = -1.f; z[1] = 0.f;
+        x[2] = -1.f; y[2] = 0.f; z[2] = 0.f;
+        x[3] = 1.f; y[3] = 0.f; z[3] = -0.f;
+    }
+    std::vector<float> u(count), v(count);
+    std::vector<float> stdU(count), stdV(count);
+    {
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] { DirectionsToEquirect(x.data(), y.data(), z.data(), count, u.data(), v.data()); });
+        const double stdMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float length = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+                stdU[i] = std::atan2(z[i], x[i]) / (2.f * SimdMath::Pi) + 0.5f;
+                stdV[i] = std::acos(y[i] / length) / SimdMath::Pi;
+            }
+        });
+
+        double maxError = 0.;
+        for (size_t i = 0; i < count; i++)
+        {
+            const double length = std::sqrt(static_cast<double>(x[i]) * x[i] + static_cast<double>(y[i]) * y[i] + static_cast<double>(z[i]) * z[i]);
+            const double exactU = std::atan2(static_cast<double>(z[i]), static_cast<double>(x[i])) / (2. * ExactPi) + 0.5;
+            const double exactV = std::acos(y[i] / length) / ExactPi;
+            double errorU = std::abs(u[i] - exactU);
+            errorU = std::min(errorU, 1. - errorU); // u = 0 and u = 1 are the same seam
+            maxError = std::max({ maxError, errorU, std::abs(v[i] - exactV) });
+        }
+        report.Print("DirectionsToEquirect", maxError, 2e-7, fastMilliseconds, stdMilliseconds, count);
+    }
+
+    {
+        std::vector<float> outX(count), outY(count), outZ(count);
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] { EquirectToDirections(u.data(), v.data(), count, outX.data(), outY.data(), outZ.data()); });
+        const double stdMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float phi = u[i] * 2.f * SimdMath::Pi - SimdMath::Pi;
+                const float theta = v[i] * SimdMath::Pi;
+                outX[i] = std::sin(theta) * std::cos(phi);
+                outY[i] = std::cos(theta);
+                outZ[i] = std::sin(theta) * std::sin(phi);
+            }
+        });
+        EquirectToDirections(u.data(), v.data(), count, outX.data(), outY.data(), outZ.data());
+
+        double maxError = 0.;
+        for (size_t i = 0; i < count; i++)
+        {
+            const double phi = u[i] * 2. * ExactPi - ExactPi;
+            const double theta = v[i] * ExactPi;
+            maxError = std::max({ maxError, std::abs(outX[i] - std::sin(theta) * std::cos(phi)), std::abs(outY[i] - std::cos(theta)), std::abs(outZ[i] - std::sin(theta) * std::sin(phi)) });
+        }
+        report.Print("EquirectToDirections", maxError, 4e-7, fastMilliseconds, stdMilliseconds, count);
+    }
+
+    {
+        const std::vector<float> angles = MakeInputs(count, -8192.f, 8192.f, 4);
+        std::vector<float> sines(count), cosines(count);
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] { SinCosArray(angles.data(), count, sines.data(), cosines.data()); });
+        const double stdMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++)
+            {
+                sines[i] = std::sin(angles[i]);
+                cosines[i] = std::cos(angles[i]);
+            }
+        });
+        SinCosArray(angles.data(), count, sines.data(), cosines.data());
+
+        double maxError = 0.;
+        for (size_t i = 0; i < count; i++)
+        {
+            maxError = std::max({ maxError, std::abs(sines[i] - std::sin(static_cast<double>(angles[i]))), std::abs(cosines[i] - std::cos(static_cast<double>(angles[i]))) });
+        }
+        report.Print("SinCosArray", maxError, 1.2e-7, fastMilliseconds, stdMilliseconds, count);
+    }
+
+    {
+        // Acos on its own, through the vector type directly
+        const std::vector<float> values = MakeInputs(count, -1.f, 1.f, 5);
+        std::vector<float> angles(count);
+        const size_t vectorCount = count / SimdMath::Width * SimdMath::Width;
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < vectorCount; i += SimdMath::Width)
+            {
+                SimdMath::Store(&angles[i], SimdMath::Acos(SimdMath::Load(&values[i])));
+            }
+        });
+        const double stdMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < vectorCount; i++) angles[i] = std::acos(values[i]);
+        });
+        for (size_t i = 0; i < vectorCount; i += SimdMath::Width)
+        {
+            SimdMath::Store(&angles[i], SimdMath::Acos(SimdMath::Load(&values[i])));
+        }
+
+        double maxError = 0.;
+        for (size_t i = 0; i < vectorCount; i++)
+        {
+            maxError = std::max(maxError, std::abs(angles[i] - std::acos(static_cast<double>(values[i]))));
+        }
+        report.Print("Acos", maxError, 6e-7, fastMilliseconds, stdMilliseconds, vectorCount);
+    }
+
+    return report.passed ? 0 : 1;
+}
@@ -0,0 +1,384 @@
+#include "../src/VectorMath.h"
+
+#include <xr_linear.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compares the Vec4 / Mat4 layer against the scalar xr_linear.h functions of the viewer. An XrMatrix4x4f (column vectors)
+// has the same memory layout as a Mat4 (row vectors), so XrMatrix4x4f_Multiply(b, a) is Multiply(a, b).
+// Errors are relative to the magnitude of the terms summed per element (rounding can't do better for sums that cancel),
+// for the inverses to the largest element. Exits with 1 if an error exceeds its bound.
+
+struct BenchmarkOptions
+{
+    size_t count = 100000; // Not a power of two, so the SoA arrays of one benchmark don't alias in the cache
+    int iterations = 10;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkVectorMath [--count|-n <matrices and points per function>] [--iterations|-i <best of>]" << std::endl;
+}
+
+bool ParseCommandLine(BenchmarkOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--count" || arg == "-n")
+        {
+            options.count = std::stoul(getNextArg());
+        }
+        else if (arg == "--iterations" || arg == "-i")
+        {
+            options.iterations = std::stoi(getNextArg());
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return true;
+}
+
+double MeasureBest(int iterations, const std::function<void()>& run)
+{
+    double bestMilliseconds = 0.;
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        run();
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(measureEnd - measureStart).count();
+        bestMilliseconds = iteration == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+    }
+    return bestMilliseconds;
+}
+
+// Deterministic pseudo random values in [minValue, maxValue]
+struct Random
+{
+    uint32_t state;
+
+    float Next(float minValue, float maxValue)
+    {
+        state = state * 1664525u + 1013904223u;
+        return minValue + (maxValue - minValue) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+    }
+};
+
+// Random poses times a headset-like projection, the kind of matrix the renderer inverts
+std::vector<XrMatrix4x4f> MakeViewProjections(size_t count, bool withProjection, uint32_t seed)
+{
+    Random random{ seed };
+    std::vector<XrMatrix4x4f> matrices(count);
+    for (XrMatrix4x4f& matrix : matrices)
+    {
+        XrQuaternionf orientation = { random.Next(-1.f, 1.f), random.Next(-1.f, 1.f), random.Next(-1.f, 1.f), random.Next(-1.f, 1.f) };
+        const float length = std::sqrt(orientation.x * orientation.x + orientation.y * orientation.y + orientation.z * orientation.z + orientation.w * orientation.w);
+        orientation = { orientation.x / length, orientation.y / length, orientation.z / length, orientation.w / length };
+        const XrVector3f position = { random.Next(-2.f, 2.f), random.Next(-2.f, 2.f), random.Next(-2.f, 2.f) };
+        const XrVector3f scale = { 1.f, 1.f, 1.f };
+
+        XrMatrix4x4f pose;
+        XrMatrix4x4f_CreateTranslationRotationScale(&pose, &position, &orientation, &scale);
+        if (!withProjection)
+        {
+            matrix = pose;
+            continue;
+        }
+
+        const XrFovf fov = { random.Next(-0.9f, -0.6f), random.Next(0.6f, 0.9f), random.Next(0.6f, 0.9f), random.Next(-0.9f, -0.6f) };
+        XrMatrix4x4f projection;
+        XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_D3D, fov, 0.05f, 100.f);
+        XrMatrix4x4f_Multiply(&matrix, &projection, &pose);
+    }
+    return matrices;
+}
+
+// Double precision cofactor inverse of one matrix, the accuracy reference
+void InverseDouble(const float* matrix, double* outInverse)
+{
+    double a[16];
+    for (int i = 0; i < 16; i++) a[i] = matrix[i];
+    auto minor = [&](int r0, int r1, int r2, int c0, int c1, int c2) {
+        return a[4 * r0 + c0] * (a[4 * r1 + c1] * a[4 * r2 + c2] - a[4 * r2 + c1] * a[4 * r1 + c2])
+            - a[4 * r0 + c1] * (a[4 * r1 + c0] * a[4 * r2 + c2] - a[4 * r2 + c0] * a[4 * r1 + c2])
+            + a[4 * r0 + c2] * (a[4 * r1 + c0] * a[4 * r2 + c1] - a[4 * r2 + c0] * a[4 * r1 + c1]);
+    };
+    const int others[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+    double cofactors[16];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            const int* r = others[row];
+            const int* c = others[col];
+            cofactors[row * 4 + col] = ((row + col) % 2 == 0 ? 1. : -1.) * minor(r[0], r[1], r[2], c[0], c[1], c[2]);
+        }
+    }
+    const double determinant = a[0] * cofactors[0] + a[1] * cofactors[1] + a[2] * cofactors[2] + a[3] * cofactors[3];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            outInverse[row * 4 + col] = cofactors[col * 4 + row] / determinant;
+        }
+    }
+}
+
+// Largest difference of count blocks of elementCount floats, each relative to the magnitude the reference gives for it
+template <typename Reference>
+double MaxRelativeError(const float* values, size_t count, size_t elementCount, Reference reference)
+{
+    double maxError = 0.;
+    std::vector<double> expected(elementCount);
+    std::vector<double> magnitude(elementCount);
+    for (size_t i = 0; i < count; i++)
+    {
+        reference(i, expected.data(), magnitude.data());
+        for (size_t element = 0; element < elementCount; element++)
+        {
+            const double error = std::abs(values[i * elementCount + element] - expected[element]);
+            maxError = std::max(maxError, magnitude[element] > 0. ? error / magnitude[element] : error);
+        }
+    }
+    return maxError;
+}
+
+// The largest element as the magnitude of every element
+void LargestMagnitude(const double* expected, size_t elementCount, double* outMagnitude)
+{
+    double largest = 0.;
+    for (size_t element = 0; element < elementCount; element++) largest = std::max(largest, std::abs(expected[element]));
+    for (size_t element = 0; element < elementCount; element++) outMagnitude[element] = largest;
+}
+
+struct Report
+{
+    bool passed = true;
+
+    void Print(const char* name, double maxError, double xrError, double bound, double fastMilliseconds, double xrMilliseconds, size_t count)
+    {
+        const bool withinBound = maxError <= bound;
+        passed &= withinBound;
+        std::cout << "  " << name << ": max error " << maxError << " (xr_linear " << xrError << ", bound " << bound << (withinBound ? ")" : ", EXCEEDED)")
+                  << ", " << count / fastMilliseconds / 1000. << " M/s vs xr_linear " << count / xrMilliseconds / 1000. << " M/s"
+                  << ", " << xrMilliseconds / fastMilliseconds << "x" << std::endl;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options{};
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    using namespace SimdMath;
+    const size_t count = options.count;
+    std::cout << "VectorMath Vec4 " << Vec4InstructionSet << ", SoA " << InstructionSet << " (" << Width << " wide), "
+              << count << " matrices and points, best of " << options.iterations << std::endl;
+    Report report{};
+
+    const std::vector<XrMatrix4x4f> viewProjections = MakeViewProjections(count, true, 1);
+    const std::vector<XrMatrix4x4f> poses = MakeViewProjections(count, false, 2);
+    std::vector<XrMatrix4x4f> fastResults(count);
+    std::vector<XrMatrix4x4f> xrResults(count);
+
+    {
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++)
+            {
+                StoreMat4(fastResults[i].m, Multiply(LoadMat4(poses[i].m), LoadMat4(viewProjections[i].m)));
+            }
+        });
+        const double xrMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) XrMatrix4x4f_Multiply(&xrResults[i], &viewProjections[i], &poses[i]);
+        });
+
+        auto reference = [&](size_t i, double* expected, double* magnitude) {
+            const float* a = poses[i].m;
+            const float* b = viewProjections[i].m;
+            for (int element = 0; element < 16; element++)
+            {
+                const int row = element / 4;
+                const int col = element % 4;
+                expected[element] = 0.;
+                magnitude[element] = 0.;
+                for (int k = 0; k < 4; k++)
+                {
+                    const double term = static_cast<double>(a[row * 4 + k]) * b[k * 4 + col];
+                    expected[element] += term;
+                    magnitude[element] += std::abs(term);
+                }
+            }
+        };
+        report.Print("Multiply", MaxRelativeError(fastResults[0].m, count, 16, reference), MaxRelativeError(xrResults[0].m, count, 16, reference),
+            3e-7, fastMilliseconds, xrMilliseconds, count);
+    }
+
+    {
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) StoreMat4(fastResults[i].m, Inverse(LoadMat4(viewProjections[i].m)));
+        });
+        const double xrMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) XrMatrix4x4f_Invert(&xrResults[i], &viewProjections[i]);
+        });
+
+        auto reference = [&](size_t i, double* expected, double* magnitude) {
+            InverseDouble(viewProjections[i].m, expected);
+            LargestMagnitude(expected, 16, magnitude);
+        };
+        report.Print("Inverse", MaxRelativeError(fastResults[0].m, count, 16, reference), MaxRelativeError(xrResults[0].m, count, 16, reference),
+            2e-5, fastMilliseconds, xrMilliseconds, count);
+    }
+
+    {
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) StoreMat4(fastResults[i].m, InverseRigid(LoadMat4(poses[i].m)));
+        });
+        const double xrMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) XrMatrix4x4f_InvertRigidBody(&xrResults[i], &poses[i]);
+        });
+
+        auto reference = [&](size_t i, double* expected, double* magnitude) {
+            InverseDouble(poses[i].m, expected);
+            LargestMagnitude(expected, 16, magnitude);
+        };
+        report.Print("InverseRigid", MaxRelativeError(fastResults[0].m, count, 16, reference), MaxRelativeError(xrResults[0].m, count, 16, reference),
+            2e-6, fastMilliseconds, xrMilliseconds, count);
+    }
+
+    // World space points inside the view frustum (from random clip space points), every point transformed by the same matrix
+    const XrMatrix4x4f& matrix = viewProjections[0];
+    double inverse[16];
+    InverseDouble(matrix.m, inverse);
+    Random random{ 3 };
+    std::vector<XrVector4f> points(count);
+    for (XrVector4f& point : points)
+    {
+        const double clip[4] = { random.Next(-1.f, 1.f), random.Next(-1.f, 1.f), random.Next(0.f, 1.f), 1. };
+        double world[4] = {};
+        for (int col = 0; col < 4; col++)
+        {
+            for (int k = 0; k < 4; k++) world[col] += clip[k] * inverse[k * 4 + col];
+        }
+        point = { static_cast<float>(world[0] / world[3]), static_cast<float>(world[1] / world[3]), static_cast<float>(world[2] / world[3]), 1.f };
+    }
+
+    {
+        std::vector<XrVector4f> fastPoints(count);
+        std::vector<XrVector4f> xrPoints(count);
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            const Mat4 loaded = LoadMat4(matrix.m);
+            for (size_t i = 0; i < count; i++) StoreVec4(&fastPoints[i].x, Transform(LoadVec4(&points[i].x), loaded));
+        });
+        const double xrMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++) XrMatrix4x4f_TransformVector4f(&xrPoints[i], &matrix, &points[i]);
+        });
+
+        auto reference = [&](size_t i, double* expected, double* magnitude) {
+            const float* p = &points[i].x;
+            for (int col = 0; col < 4; col++)
+            {
+                expected[col] = 0.;
+                magnitude[col] = 0.;
+                for (int k = 0; k < 4; k++)
+                {
+                    const double term = static_cast<double>(p[k]) * matrix.m[k * 4 + col];
+                    expected[col] += term;
+                    magnitude[col] += std::abs(term);
+                }
+            }
+        };
+        report.Print("Transform (Vec4)", MaxRelativeError(&fastPoints[0].x, count, 4, reference), MaxRelativeError(&xrPoints[0].x, count, 4, reference),
+            3e-7, fastMilliseconds, xrMilliseconds, count);
+    }
+
+    {
+        std::vector<float> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+            z[i] = points[i].z;
+        }
+        std::vector<float> outX(count), outY(count), outZ(count);
+        std::vector<XrVector3f> xrPoints(count);
+        const double fastMilliseconds = MeasureBest(options.iterations, [&] {
+            TransformCoordsSoA(LoadMat4(matrix.m), x.data(), y.data(), z.data(), count, outX.data(), outY.data(), outZ.data());
+        });
+        const double xrMilliseconds = MeasureBest(options.iterations, [&] {
+            for (size_t i = 0; i < count; i++)
+            {
+                const XrVector3f point = { x[i], y[i], z[i] };
+                XrMatrix4x4f_TransformVector3f(&xrPoints[i], &matrix, &point);
+            }
+        });
+
+        std::vector<float> fastPoints(count * 3);
+        for (size_t i = 0; i < count; i++)
+        {
+            fastPoints[i * 3] = outX[i];
+            fastPoints[i * 3 + 1] = outY[i];
+            fastPoints[i * 3 + 2] = outZ[i];
+        }
+        auto reference = [&](size_t i, double* expected, double* magnitude) {
+            const double p[4] = { x[i], y[i], z[i], 1. };
+            double w = 0.;
+            double wMagnitude = 0.;
+            for (int k = 0; k < 4; k++)
+            {
+                w += p[k] * matrix.m[k * 4 + 3];
+                wMagnitude += std::abs(p[k] * matrix.m[k * 4 + 3]);
+            }
+            for (int col = 0; col < 3; col++)
+            {
+                expected[col] = 0.;
+                magnitude[col] = 0.;
+                for (int k = 0; k < 4; k++)
+                {
+                    expected[col] += p[k] * matrix.m[k * 4 + col];
+                    magnitude[col] += std::abs(p[k] * matrix.m[k * 4 + col]);
+                }
+                expected[col] /= w;
+                // Rounding of the numerator and of w both scale with the result
+                magnitude[col] = (magnitude[col] + std::abs(expected[col]) * wMagnitude) / std::abs(w);
+            }
+        };
+        report.Print("TransformCoordsSoA", MaxRelativeError(fastPoints.data(), count, 3, reference), MaxRelativeError(&xrPoints[0].x, count, 3, reference),
+            3e-7, fastMilliseconds, xrMilliseconds, count);
+    }
+
+    return report.passed ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Stand-in for the OpenXR SDK header when the OpenXR-SDK submodule is not checked out. Only the plain math structs that
+// xr_linear.h uses, with the layouts of the specification, so BenchmarkVectorMath can build on any platform.
+
+typedef struct XrVector2f { float x; float y; } XrVector2f;
+typedef struct XrVector3f { float x; float y; float z; } XrVector3f;
+typedef struct XrVector4f { float x; float y; float z; float w; } XrVector4f;
+typedef struct XrQuaternionf { float x; float y; float z; float w; } XrQuaternionf;
+typedef struct XrColor4f { float r; float g; float b; float a; } XrColor4f;
+typedef struct XrFovf { float angleLeft; float angleRight; float angleUp; float angleDown; } XrFovf;
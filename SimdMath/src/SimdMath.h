@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Float vectors of the widest instruction set the build targets, with the few operations the CPU tools need and
+// polynomial approximations of the transcendental functions on top. Code written against FloatV runs 8 wide with AVX2
+// (SIMD_MATH_AVX2 cmake option), 4 wide with SSE2 or NEON and falls back to plain floats everywhere else.
+// Maximum errors are documented per function, BenchmarkSimdMath measures them against double precision std:: functions.
+
+#if defined(__AVX2__)
+#define SIMD_MATH_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_MATH_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_MATH_NEON
+#include <arm_neon.h>
+#else
+#define SIMD_MATH_SCALAR
+#endif
+
+namespace SimdMath
+{
+    constexpr float Pi = 3.14159265358979323846f;
+
+#if defined(SIMD_MATH_AVX2)
+    constexpr const char* InstructionSet = "AVX2";
+    struct FloatV { __m256 v; };
+    struct IntV { __m256i v; };
+    struct MaskV { __m256 v; };
+    constexpr size_t Width = 8;
+
+    inline FloatV Set(float value) { return { _mm256_set1_ps(value) }; }
+    inline FloatV Load(const float* source) { return { _mm256_loadu_ps(source) }; }
+    inline void Store(float* target, FloatV value) { _mm256_storeu_ps(target, value.v); }
+    inline FloatV LaneIndex() { return { _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f) }; }
+
+    inline FloatV operator+(FloatV a, FloatV b) { return { _mm256_add_ps(a.v, b.v) }; }
+    inline FloatV operator-(FloatV a, FloatV b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    inline FloatV operator*(FloatV a, FloatV b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    inline FloatV operator/(FloatV a, FloatV b) { return { _mm256_div_ps(a.v, b.v) }; }
+#if defined(__FMA__)
+    inline FloatV MulAdd(FloatV a, FloatV b, FloatV c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+    inline FloatV MulAdd(FloatV a, FloatV b, FloatV c) { return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) }; }
+#endif
+    inline FloatV Min(FloatV a, FloatV b) { return { _mm256_min_ps(a.v, b.v) }; }
+    inline FloatV Max(FloatV a, FloatV b) { return { _mm256_max_ps(a.v, b.v) }; }
+    inline FloatV Sqrt(FloatV a) { return { _mm256_sqrt_ps(a.v) }; }
+    inline FloatV Abs(FloatV a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v) }; }
+    inline FloatV SignBit(FloatV a) { return { _mm256_and_ps(_mm256_set1_ps(-0.f), a.v) }; }
+    inline FloatV Xor(FloatV a, FloatV b) { return { _mm256_xor_ps(a.v, b.v) }; }
+
+    inline MaskV operator<(FloatV a, FloatV b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    inline MaskV operator>(FloatV a, FloatV b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    inline FloatV Select(MaskV mask, FloatV ifTrue, FloatV ifFalse) { return { _mm256_blendv_ps(ifFalse.v, ifTrue.v, mask.v) }; }
+
+    // Rounds to the nearest integer, ties to even.
+    inline IntV RoundToInt(FloatV a) { return { _mm256_cvtps_epi32(a.v) }; }
+    // Rounds toward negative infinity.
+    inline FloatV Floor(FloatV a) { return { _mm256_floor_ps(a.v) }; }
+    inline FloatV ToFloat(IntV a) { return { _mm256_cvtepi32_ps(a.v) }; }
+    inline IntV operator+(IntV a, int b) { return { _mm256_add_epi32(a.v, _mm256_set1_epi32(b)) }; }
+    inline MaskV BitSet(IntV a, int bit) { return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(a.v, _mm256_set1_epi32(bit)), _mm256_set1_epi32(bit))) }; }
+#elif defined(SIMD_MATH_SSE2)
+    constexpr const char* InstructionSet = "SSE2";
+    struct FloatV { __m128 v; };
+    struct IntV { __m128i v; };
+    struct MaskV { __m128 v; };
+    constexpr size_t Width = 4;
+
+    inline FloatV Set(float value) { return { _mm_set1_ps(value) }; }
+    inline FloatV Load(const float* source) { return { _mm_loadu_ps(source) }; }
+    inline void Store(float* target, FloatV value) { _mm_storeu_ps(target, value.v); }
+    inline FloatV LaneIndex() { return { _mm_setr_ps(0.f, 1.f, 2.f, 3.f) }; }
+
+    inline FloatV operator+(FloatV a, FloatV b) { return { _mm_add_ps(a.v, b.v) }; }
+    inline FloatV operator-(FloatV a, FloatV b) { return { _mm_sub_ps(a.v, b.v) }; }
+    inline FloatV operator*(FloatV a, FloatV b) { return { _mm_mul_ps(a.v, b.v) }; }
+    inline FloatV operator/(FloatV a, FloatV b) { return { _mm_div_ps(a.v, b.v) }; }
+    inline FloatV MulAdd(FloatV a, FloatV b, FloatV c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+    inline FloatV Min(FloatV a, FloatV b) { return { _mm_min_ps(a.v, b.v) }; }
+    inline FloatV Max(FloatV a, FloatV b) { return { _mm_max_ps(a.v, b.v) }; }
+    inline FloatV Sqrt(FloatV a) { return { _mm_sqrt_ps(a.v) }; }
+    inline FloatV Abs(FloatV a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+    inline FloatV SignBit(FloatV a) { return { _mm_and_ps(_mm_set1_ps(-0.f), a.v) }; }
+    inline FloatV Xor(FloatV a, FloatV b) { return { _mm_xor_ps(a.v, b.v) }; }
+
+    inline MaskV operator<(FloatV a, FloatV b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    inline MaskV operator>(FloatV a, FloatV b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    inline FloatV Select(MaskV mask, FloatV ifTrue, FloatV ifFalse) { return { _mm_or_ps(_mm_and_ps(mask.v, ifTrue.v), _mm_andnot_ps(mask.v, ifFalse.v)) }; }
+
+    // Rounds to the nearest integer, ties to even.
+    inline IntV RoundToInt(FloatV a) { return { _mm_cvtps_epi32(a.v) }; }
+    // Rounds toward negative infinity. SSE2 has no floor instruction, this is exact below 2^31 in magnitude.
+    inline FloatV Floor(FloatV a)
+    {
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+        return { _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.f))) };
+    }
+    inline FloatV ToFloat(IntV a) { return { _mm_cvtepi32_ps(a.v) }; }
+    inline IntV operator+(IntV a, int b) { return { _mm_add_epi32(a.v, _mm_set1_epi32(b)) }; }
+    inline MaskV BitSet(IntV a, int bit) { return { _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a.v, _mm_set1_epi32(bit)), _mm_set1_epi32(bit))) }; }
+#elif defined(SIMD_MATH_NEON)
+    constexpr const char* InstructionSet = "NEON";
+    struct FloatV { float32x4_t v; };
+    struct IntV { int32x4_t v; };
+    struct MaskV { uint32x4_t v; };
+    constexpr size_t Width = 4;
+
+    inline FloatV Set(float value) { return { vdupq_n_f32(value) }; }
+    inline FloatV Load(const float* source) { return { vld1q_f32(source) }; }
+    inline void Store(float* target, FloatV value) { vst1q_f32(target, value.v); }
+    inline FloatV LaneIndex() { const float lanes[4] = { 0.f, 1.f, 2.f, 3.f }; return { vld1q_f32(lanes) }; }
+
+    inline FloatV operator+(FloatV a, FloatV b) { return { vaddq_f32(a.v, b.v) }; }
+    inline FloatV operator-(FloatV a, FloatV b) { return { vsubq_f32(a.v, b.v) }; }
+    inline FloatV operator*(FloatV a, FloatV b) { return { vmulq_f32(a.v, b.v) }; }
+    inline FloatV operator/(FloatV a, FloatV b) { return { vdivq_f32(a.v, b.v) }; }
+    inline FloatV MulAdd(FloatV a, FloatV b, FloatV c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+    inline FloatV Min(FloatV a, FloatV b) { return { vminq_f32(a.v, b.v) }; }
+    inline FloatV Max(FloatV a, FloatV b) { return { vmaxq_f32(a.v, b.v) }; }
+    inline FloatV Sqrt(FloatV a) { return { vsqrtq_f32(a.v) }; }
+    inline FloatV Abs(FloatV a) { return { vabsq_f32(a.v) }; }
+    inline FloatV SignBit(FloatV a) { return { vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vdupq_n_u32(0x80000000u))) }; }
+    inline FloatV Xor(FloatV a, FloatV b) { return { vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) }; }
+
+    inline MaskV operator<(FloatV a, FloatV b) { return { vcltq_f32(a.v, b.v) }; }
+    inline MaskV operator>(FloatV a, FloatV b) { return { vcgtq_f32(a.v, b.v) }; }
+    inline FloatV Select(MaskV mask, FloatV ifTrue, FloatV ifFalse) { return { vbslq_f32(mask.v, ifTrue.v, ifFalse.v) }; }
+
+    // Rounds to the nearest integer, ties to even.
+    inline IntV RoundToInt(FloatV a) { return { vcvtnq_s32_f32(a.v) }; }
+    // Rounds toward negative infinity.
+    inline FloatV Floor(FloatV a) { return { vrndmq_f32(a.v) }; }
+    inline FloatV ToFloat(IntV a) { return { vcvtq_f32_s32(a.v) }; }
+    inline IntV operator+(IntV a, int b) { return { vaddq_s32(a.v, vdupq_n_s32(b)) }; }
+    inline MaskV BitSet(IntV a, int bit) { return { vtstq_s32(a.v, vdupq_n_s32(bit)) }; }
+#else
+    constexpr const char* InstructionSet = "scalar";
+    struct FloatV { float v; };
+    struct IntV { int32_t v; };
+    struct MaskV { bool v; };
+    constexpr size_t Width = 1;
+
+    inline FloatV Set(float value) { return { value }; }
+    inline FloatV Load(const float* source) { return { *source }; }
+    inline void Store(float* target, FloatV value) { *target = value.v; }
+    inline FloatV LaneIndex() { return { 0.f }; }
+
+    inline FloatV operator+(FloatV a, FloatV b) { return { a.v + b.v }; }
+    inline FloatV operator-(FloatV a, FloatV b) { return { a.v - b.v }; }
+    inline FloatV operator*(FloatV a, FloatV b) { return { a.v * b.v }; }
+    inline FloatV operator/(FloatV a, FloatV b) { return { a.v / b.v }; }
+    inline FloatV MulAdd(FloatV a, FloatV b, FloatV c) { return { a.v * b.v + c.v }; }
+    inline FloatV Min(FloatV a, FloatV b) { return { a.v < b.v ? a.v : b.v }; }
+    inline FloatV Max(FloatV a, FloatV b) { return { a.v > b.v ? a.v : b.v }; }
+    inline FloatV Sqrt(FloatV a) { return { std::sqrt(a.v) }; }
+    inline FloatV Abs(FloatV a) { return { std::fabs(a.v) }; }
+    inline FloatV SignBit(FloatV a) { return { std::signbit(a.v) ? -0.f : 0.f }; }
+    inline FloatV Xor(FloatV a, FloatV b) { return { std::signbit(b.v) ? -a.v : a.v }; } // only used to flip signs
+
+    inline MaskV operator<(FloatV a, FloatV b) { return { a.v < b.v }; }
+    inline MaskV operator>(FloatV a, FloatV b) { return { a.v > b.v }; }
+    inline FloatV Select(MaskV mask, FloatV ifTrue, FloatV ifFalse) { return { mask.v ? ifTrue.v : ifFalse.v }; }
+
+    // Rounds to the nearest integer, ties to even.
+    inline IntV RoundToInt(FloatV a) { return { static_cast<int32_t>(std::nearbyint(a.v)) }; }
+    // Rounds toward negative infinity.
+    inline FloatV Floor(FloatV a) { return { std::floor(a.v) }; }
+    inline FloatV ToFloat(IntV a) { return { static_cast<float>(a.v) }; }
+    inline IntV operator+(IntV a, int b) { return { a.v + b }; }
+    inline MaskV BitSet(IntV a, int bit) { return { (a.v & bit) != 0 }; }
+#endif
+
+    // Evaluates coefficients[0] + x * coefficients[1] + x^2 * coefficients[2] ... with Horner's scheme.
+    template <size_t N>
+    inline FloatV Polynomial(FloatV x, const float (&coefficients)[N])
+    {
+        FloatV result = Set(coefficients[N - 1]);
+        for (size_t i = N - 1; i > 0; i--)
+        {
+            result = MulAdd(result, x, Set(coefficients[i - 1]));
+        }
+        return result;
+    }
+
+    // Minimax fit of atan(a) / a as a polynomial in a^2 on [0, 1].
+    constexpr float AtanCoefficients[] = { 0.999996112f, -0.333173687f, 0.198078177f, -0.13233343f, 0.0796236146f, -0.0336041321f, 0.0068117561f };
+
+    // Same quadrants as std::atan2, including the sign of zero y. Max error 2.5e-7 rad plus rounding of the result (5e-7 measured).
+    // atan2(0, 0) returns 0.
+    inline FloatV Atan2(FloatV y, FloatV x)
+    {
+        const FloatV absX = Abs(x);
+        const FloatV absY = Abs(y);
+        const FloatV larger = Max(absX, absY);
+
+        // Reduce to [0, 1], the smallest normal float as divisor turns 0 / 0 into 0
+        const FloatV a = Min(absX, absY) / Max(larger, Set(1.17549435e-38f));
+        FloatV angle = a * Polynomial(a * a, AtanCoefficients);
+
+        angle = Select(absY > absX, Set(Pi / 2.f) - angle, angle);
+        angle = Select(x < Set(0.f), Set(Pi) - angle, angle);
+        return Xor(angle, SignBit(y));
+    }
+
+    // Max error 6e-7 rad on [-1, 1]. Goes through Atan2, which stays accurate near +-1 where acos is ill-conditioned.
+    inline FloatV Acos(FloatV x)
+    {
+        const FloatV one = Set(1.f);
+        return Atan2(Sqrt(Max((one - x) * (one + x), Set(0.f))), x);
+    }
+
+    // Cephes single precision sin and cos on [-pi/4, pi/4].
+    constexpr float SinCoefficients[] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+    constexpr float CosCoefficients[] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+
+    // Both at once, they share the range reduction. Max error 1.2e-7 for |x| <= 8192 (larger arguments lose precision in the
+    // reduction, like any float implementation without Payne-Hanek reduction).
+    inline void SinCos(FloatV x, FloatV& outSin, FloatV& outCos)
+    {
+        // x = quadrant * pi / 2 + r, pi / 2 split in three parts so the subtraction stays exact
+        const IntV quadrant = RoundToInt(x * Set(2.f / Pi));
+        const FloatV k = ToFloat(quadrant);
+        FloatV r = MulAdd(k, Set(-1.5703125f), x);
+        r = MulAdd(k, Set(-4.837512969970703125e-4f), r);
+        r = MulAdd(k, Set(-7.54978995489188216e-8f), r);
+
+        const FloatV r2 = r * r;
+        const FloatV sinR = MulAdd(r * r2, Polynomial(r2, SinCoefficients), r);
+        const FloatV cosR = MulAdd(r2 * r2, Polynomial(r2, CosCoefficients), MulAdd(r2, Set(-0.5f), Set(1.f)));
+
+        // Odd quadrants swap sin and cos, quadrants 2 and 3 negate sin, 1 and 2 negate cos
+        const MaskV odd = BitSet(quadrant, 1);
+        const FloatV sinValue = Select(odd, cosR, sinR);
+        const FloatV cosValue = Select(odd, sinR, cosR);
+        const FloatV negativeZero = Set(-0.f);
+        const FloatV zero = Set(0.f);
+        outSin = Xor(sinValue, Select(BitSet(quadrant, 2), negativeZero, zero));
+        outCos = Xor(cosValue, Select(BitSet(quadrant + 1, 2), negativeZero, zero));
+    }
+
+    inline FloatV Sin(FloatV x) { FloatV s, c; SinCos(x, s, c); return s; }
+    inline FloatV Cos(FloatV x) { FloatV s, c; SinCos(x, s, c); return c; }
+}
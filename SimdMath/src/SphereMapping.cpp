@@ -0,0 +1,61 @@
+#include "SphereMapping.h"
+
+#include <algorithm>
+
+using namespace SimdMath;
+
+// Runs kernel on full vectors, then once more on the remaining elements copied into zero padded buffers.
+// Every kernel reads inputCount arrays and writes outputCount arrays, outputs may be nullptr.
+template <size_t InputCount, size_t OutputCount, typename Kernel>
+static void ForEachVector(const float* const (&inputs)[InputCount], float* const (&outputs)[OutputCount], size_t count, Kernel kernel)
+{
+    FloatV in[InputCount];
+    FloatV out[OutputCount];
+    size_t i = 0;
+    for (; i + Width <= count; i += Width)
+    {
+        for (size_t input = 0; input < InputCount; input++) in[input] = Load(&inputs[input][i]);
+        kernel(in, out);
+        for (size_t output = 0; output < OutputCount; output++)
+        {
+            if (outputs[output] != nullptr) Store(&outputs[output][i], out[output]);
+        }
+    }
+    if (i == count) return;
+
+    const size_t tail = count - i;
+    float buffer[Width] = {};
+    for (size_t input = 0; input < InputCount; input++)
+    {
+        std::copy(&inputs[input][i], &inputs[input][count], buffer);
+        in[input] = Load(buffer);
+    }
+    kernel(in, out);
+    for (size_t output = 0; output < OutputCount; output++)
+    {
+        if (outputs[output] == nullptr) continue;
+        Store(buffer, out[output]);
+        std::copy(buffer, buffer + tail, &outputs[output][i]);
+    }
+}
+
+void DirectionsToEquirect(const float* x, const float* y, const float* z, size_t count, float* outU, float* outV)
+{
+    ForEachVector({ x, y, z }, { outU, outV }, count, [](const FloatV* in, FloatV* out) {
+        DirectionToEquirect(in[0], in[1], in[2], out[0], out[1]);
+    });
+}
+
+void EquirectToDirections(const float* u, const float* v, size_t count, float* outX, float* outY, float* outZ)
+{
+    ForEachVector({ u, v }, { outX, outY, outZ }, count, [](const FloatV* in, FloatV* out) {
+        EquirectToDirection(in[0], in[1], out[0], out[1], out[2]);
+    });
+}
+
+void SinCosArray(const float* angles, size_t count, float* outSin, float* outCos)
+{
+    ForEachVector({ angles }, { outSin, outCos }, count, [](const FloatV* in, FloatV* out) {
+        SinCos(in[0], out[0], out[1]);
+    });
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SimdMath.h"
+
+#include <cstddef>
+
+// Batch conversions between directions and equirectangular texture coordinates, vectorized with SimdMath.
+// Convention of the viewer and the reference renderer: u = atan2(z, x) / 2pi + 0.5, v = acos(y) / pi, both in [0, 1],
+// v = 0 is +y. Arrays may have any length, they are processed SimdMath::Width elements at a time with a scalar-sized tail.
+
+// Directions do not need to be normalized, (0, 0, 0) maps to (0.5, 0). Max error 2e-7 in u and v.
+void DirectionsToEquirect(const float* x, const float* y, const float* z, size_t count, float* outU, float* outV);
+
+// Unit directions for the texture coordinates. Max error 4e-7 per component, most of it from rounding u * 2pi to float.
+void EquirectToDirections(const float* u, const float* v, size_t count, float* outX, float* outY, float* outZ);
+
+// Sine and cosine of every angle, either output may be nullptr. Max error 1.2e-7 for |angle| <= 8192.
+void SinCosArray(const float* angles, size_t count, float* outSin, float* outCos);
+
+namespace SimdMath
+{
+    // Kernels of the batch functions for callers that produce directions in registers themselves.
+    inline void DirectionToEquirect(FloatV x, FloatV y, FloatV z, FloatV& outU, FloatV& outV)
+    {
+        const FloatV phi = Atan2(z, x);
+        const FloatV theta = Atan2(Sqrt(MulAdd(x, x, z * z)), y);
+        outU = MulAdd(phi, Set(0.5f / Pi), Set(0.5f));
+        outV = theta * Set(1.f / Pi);
+    }
+
+    inline void EquirectToDirection(FloatV u, FloatV v, FloatV& outX, FloatV& outY, FloatV& outZ)
+    {
+        FloatV sinPhi, cosPhi, sinTheta, cosTheta;
+        SinCos(MulAdd(u, Set(2.f * Pi), Set(-Pi)), sinPhi, cosPhi);
+        SinCos(v * Set(Pi), sinTheta, cosTheta);
+        outX = sinTheta * cosPhi;
+        outY = cosTheta;
+        outZ = sinTheta * sinPhi;
+    }
+}
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "SimdMath.h"
+
+// 3 and 4 component vectors and 4x4 matrices for the CPU tools, the subset of DirectXMath they used. Header only.
+// Vec4 is always one 128 bit register: SSE2 (also in AVX2 builds), NEON or four plain floats. The SoA batch functions
+// at the end work on FloatV instead and run SimdMath::Width points at a time.
+// Matrices follow the DirectXMath conventions: row-major, row vectors (v * M). An XrMatrix4x4f (column-major, column
+// vectors) has the same memory layout and can be loaded as-is, BenchmarkVectorMath compares against xr_linear.h.
+
+#if defined(SIMD_MATH_AVX2) || defined(SIMD_MATH_SSE2)
+#define SIMD_MATH_VEC4_SSE
+#elif defined(SIMD_MATH_NEON)
+#define SIMD_MATH_VEC4_NEON
+#else
+#define SIMD_MATH_VEC4_SCALAR
+#endif
+
+namespace SimdMath
+{
+#if defined(SIMD_MATH_VEC4_SSE)
+    constexpr const char* Vec4InstructionSet = "SSE2";
+    struct Vec4 { __m128 v; };
+
+    inline Vec4 MakeVec4(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+    inline Vec4 SplatVec4(float value) { return { _mm_set1_ps(value) }; }
+    inline Vec4 LoadVec4(const float* source) { return { _mm_loadu_ps(source) }; }
+    inline void StoreVec4(float* target, Vec4 value) { _mm_storeu_ps(target, value.v); }
+
+    inline Vec4 operator+(Vec4 a, Vec4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    inline Vec4 operator-(Vec4 a, Vec4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    inline Vec4 operator*(Vec4 a, Vec4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    inline Vec4 operator/(Vec4 a, Vec4 b) { return { _mm_div_ps(a.v, b.v) }; }
+#if defined(__FMA__)
+    inline Vec4 MulAdd(Vec4 a, Vec4 b, Vec4 c) { return { _mm_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+    inline Vec4 MulAdd(Vec4 a, Vec4 b, Vec4 c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+#endif
+    inline Vec4 Sqrt(Vec4 a) { return { _mm_sqrt_ps(a.v) }; }
+    inline float GetX(Vec4 a) { return _mm_cvtss_f32(a.v); }
+
+    // { a[i0], a[i1], b[i2], b[i3] }, the semantics of _mm_shuffle_ps
+    template <int i0, int i1, int i2, int i3>
+    inline Vec4 Shuffle(Vec4 a, Vec4 b) { return { _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(i3, i2, i1, i0)) }; }
+#elif defined(SIMD_MATH_VEC4_NEON)
+    constexpr const char* Vec4InstructionSet = "NEON";
+    struct Vec4 { float32x4_t v; };
+
+    inline Vec4 MakeVec4(float x, float y, float z, float w) { const float lanes[4] = { x, y, z, w }; return { vld1q_f32(lanes) }; }
+    inline Vec4 SplatVec4(float value) { return { vdupq_n_f32(value) }; }
+    inline Vec4 LoadVec4(const float* source) { return { vld1q_f32(source) }; }
+    inline void StoreVec4(float* target, Vec4 value) { vst1q_f32(target, value.v); }
+
+    inline Vec4 operator+(Vec4 a, Vec4 b) { return { vaddq_f32(a.v, b.v) }; }
+    inline Vec4 operator-(Vec4 a, Vec4 b) { return { vsubq_f32(a.v, b.v) }; }
+    inline Vec4 operator*(Vec4 a, Vec4 b) { return { vmulq_f32(a.v, b.v) }; }
+    inline Vec4 operator/(Vec4 a, Vec4 b) { return { vdivq_f32(a.v, b.v) }; }
+    inline Vec4 MulAdd(Vec4 a, Vec4 b, Vec4 c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+    inline Vec4 Sqrt(Vec4 a) { return { vsqrtq_f32(a.v) }; }
+    inline float GetX(Vec4 a) { return vgetq_lane_f32(a.v, 0); }
+
+    // { a[i0], a[i1], b[i2], b[i3] }, the semantics of _mm_shuffle_ps
+    template <int i0, int i1, int i2, int i3>
+    inline Vec4 Shuffle(Vec4 a, Vec4 b)
+    {
+        float32x4_t result = vdupq_n_f32(vgetq_lane_f32(a.v, i0));
+        result = vsetq_lane_f32(vgetq_lane_f32(a.v, i1), result, 1);
+        result = vsetq_lane_f32(vgetq_lane_f32(b.v, i2), result, 2);
+        result = vsetq_lane_f32(vgetq_lane_f32(b.v, i3), result, 3);
+        return { result };
+    }
+#else
+    constexpr const char* Vec4InstructionSet = "scalar";
+    struct Vec4 { float v[4]; };
+
+    inline Vec4 MakeVec4(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+    inline Vec4 SplatVec4(float value) { return { { value, value, value, value } }; }
+    inline Vec4 LoadVec4(const float* source) { return { { source[0], source[1], source[2], source[3] } }; }
+    inline void StoreVec4(float* target, Vec4 value) { for (int i = 0; i < 4; i++) target[i] = value.v[i]; }
+
+    inline Vec4 operator+(Vec4 a, Vec4 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+    inline Vec4 operator-(Vec4 a, Vec4 b) { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+    inline Vec4 operator*(Vec4 a, Vec4 b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+    inline Vec4 operator/(Vec4 a, Vec4 b) { return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+    inline Vec4 MulAdd(Vec4 a, Vec4 b, Vec4 c) { return a * b + c; }
+    inline Vec4 Sqrt(Vec4 a) { return { { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+    inline float GetX(Vec4 a) { return a.v[0]; }
+
+    // { a[i0], a[i1], b[i2], b[i3] }, the semantics of _mm_shuffle_ps
+    template <int i0, int i1, int i2, int i3>
+    inline Vec4 Shuffle(Vec4 a, Vec4 b) { return { { a.v[i0], a.v[i1], b.v[i2], b.v[i3] } }; }
+#endif
+
+    // Everything below is written against the operations above and shared by all backends.
+
+    template <int i0, int i1, int i2, int i3>
+    inline Vec4 Swizzle(Vec4 a) { return Shuffle<i0, i1, i2, i3>(a, a); }
+    template <int lane>
+    inline Vec4 Splat(Vec4 a) { return Shuffle<lane, lane, lane, lane>(a, a); }
+
+    inline float GetY(Vec4 a) { return GetX(Splat<1>(a)); }
+    inline float GetZ(Vec4 a) { return GetX(Splat<2>(a)); }
+    inline float GetW(Vec4 a) { return GetX(Splat<3>(a)); }
+
+    // Reads exactly three floats, w is set separately (1 for points, 0 for directions).
+    inline Vec4 LoadVec3(const float* source, float w) { return MakeVec4(source[0], source[1], source[2], w); }
+    inline void StoreVec3(float* target, Vec4 value)
+    {
+        float lanes[4];
+        StoreVec4(lanes, value);
+        target[0] = lanes[0];
+        target[1] = lanes[1];
+        target[2] = lanes[2];
+    }
+
+    inline Vec4 operator*(Vec4 a, float s) { return a * SplatVec4(s); }
+
+    // Horizontal sums, broadcast to every lane
+    inline Vec4 Dot4V(Vec4 a, Vec4 b)
+    {
+        const Vec4 products = a * b;
+        const Vec4 pairs = products + Swizzle<2, 3, 0, 1>(products);
+        return pairs + Swizzle<1, 0, 3, 2>(pairs);
+    }
+    inline Vec4 Dot3V(Vec4 a, Vec4 b)
+    {
+        const Vec4 products = a * b;
+        return Splat<0>(products) + Splat<1>(products) + Splat<2>(products);
+    }
+
+    inline float Dot4(Vec4 a, Vec4 b) { return GetX(Dot4V(a, b)); }
+    inline float Dot3(Vec4 a, Vec4 b) { return GetX(Dot3V(a, b)); }
+    inline float Length3(Vec4 a) { return GetX(Sqrt(Dot3V(a, a))); }
+
+    // w of the result is 0.
+    inline Vec4 Cross3(Vec4 a, Vec4 b)
+    {
+        return Swizzle<1, 2, 0, 3>(a) * Swizzle<2, 0, 1, 3>(b) - Swizzle<2, 0, 1, 3>(a) * Swizzle<1, 2, 0, 3>(b);
+    }
+
+    // Zero vectors are returned unchanged.
+    inline Vec4 Normalize3(Vec4 a)
+    {
+        const Vec4 length = Sqrt(Dot3V(a, a));
+        return GetX(length) == 0.f ? a : a / length;
+    }
+
+    struct Mat4
+    {
+        Vec4 rows[4];
+    };
+
+    inline Mat4 IdentityMat4()
+    {
+        return { { MakeVec4(1.f, 0.f, 0.f, 0.f), MakeVec4(0.f, 1.f, 0.f, 0.f), MakeVec4(0.f, 0.f, 1.f, 0.f), MakeVec4(0.f, 0.f, 0.f, 1.f) } };
+    }
+
+    // 16 floats, row after row.
+    inline Mat4 LoadMat4(const float* source)
+    {
+        return { { LoadVec4(source), LoadVec4(source + 4), LoadVec4(source + 8), LoadVec4(source + 12) } };
+    }
+    inline void StoreMat4(float* target, const Mat4& matrix)
+    {
+        for (int row = 0; row < 4; row++) StoreVec4(target + row * 4, matrix.rows[row]);
+    }
+
+    // v * M
+    inline Vec4 Transform(Vec4 v, const Mat4& matrix)
+    {
+        Vec4 result = Splat<0>(v) * matrix.rows[0];
+        result = MulAdd(Splat<1>(v), matrix.rows[1], result);
+        result = MulAdd(Splat<2>(v), matrix.rows[2], result);
+        return MulAdd(Splat<3>(v), matrix.rows[3], result);
+    }
+
+    // (x, y, z, 1) * M, the w of v is ignored and the w of the result is kept (like XMVector3Transform).
+    inline Vec4 TransformPoint(Vec4 v, const Mat4& matrix)
+    {
+        Vec4 result = MulAdd(Splat<0>(v), matrix.rows[0], matrix.rows[3]);
+        result = MulAdd(Splat<1>(v), matrix.rows[1], result);
+        return MulAdd(Splat<2>(v), matrix.rows[2], result);
+    }
+
+    // (x, y, z, 1) * M divided by the resulting w (like XMVector3TransformCoord).
+    inline Vec4 TransformCoord(Vec4 v, const Mat4& matrix)
+    {
+        const Vec4 result = TransformPoint(v, matrix);
+        return result / Splat<3>(result);
+    }
+
+    // a * b, applies a first
+    inline Mat4 Multiply(const Mat4& a, const Mat4& b)
+    {
+        return { { Transform(a.rows[0], b), Transform(a.rows[1], b), Transform(a.rows[2], b), Transform(a.rows[3], b) } };
+    }
+
+    inline Mat4 Transpose(const Mat4& matrix)
+    {
+        const Vec4 low01 = Shuffle<0, 1, 0, 1>(matrix.rows[0], matrix.rows[1]);
+        const Vec4 high01 = Shuffle<2, 3, 2, 3>(matrix.rows[0], matrix.rows[1]);
+        const Vec4 low23 = Shuffle<0, 1, 0, 1>(matrix.rows[2], matrix.rows[3]);
+        const Vec4 high23 = Shuffle<2, 3, 2, 3>(matrix.rows[2], matrix.rows[3]);
+        return { {
+            Shuffle<0, 2, 0, 2>(low01, low23),
+            Shuffle<1, 3, 1, 3>(low01, low23),
+            Shuffle<0, 2, 0, 2>(high01, high23),
+            Shuffle<1, 3, 1, 3>(high01, high23),
+        } };
+    }
+
+    // 2x2 matrices packed row-major into one Vec4, for the block inverse below.
+    // a * b
+    inline Vec4 Mat2Multiply(Vec4 a, Vec4 b) { return a * Swizzle<0, 3, 0, 3>(b) + Swizzle<1, 0, 3, 2>(a) * Swizzle<2, 1, 2, 1>(b); }
+    // adjugate(a) * b
+    inline Vec4 Mat2AdjugateMultiply(Vec4 a, Vec4 b) { return Swizzle<3, 3, 0, 0>(a) * b - Swizzle<1, 1, 2, 2>(a) * Swizzle<2, 3, 0, 1>(b); }
+    // a * adjugate(b)
+    inline Vec4 Mat2MultiplyAdjugate(Vec4 a, Vec4 b) { return a * Swizzle<3, 0, 3, 0>(b) - Swizzle<1, 0, 3, 2>(a) * Swizzle<2, 1, 2, 1>(b); }
+
+    // General inverse from the four 2x2 blocks of the matrix. Float precision: the result of a projection matrix with a
+    // large far / near ratio loses a few bits compared to a double precision cofactor inverse.
+    // Returns identity for singular matrices, outDeterminant receives the determinant if not null.
+    inline Mat4 Inverse(const Mat4& matrix, float* outDeterminant = nullptr)
+    {
+        const Vec4 a = Shuffle<0, 1, 0, 1>(matrix.rows[0], matrix.rows[1]);
+        const Vec4 b = Shuffle<2, 3, 2, 3>(matrix.rows[0], matrix.rows[1]);
+        const Vec4 c = Shuffle<0, 1, 0, 1>(matrix.rows[2], matrix.rows[3]);
+        const Vec4 d = Shuffle<2, 3, 2, 3>(matrix.rows[2], matrix.rows[3]);
+
+        // Determinants of the blocks a, b, c, d in one vector
+        const Vec4 blockDeterminants = Shuffle<0, 2, 0, 2>(matrix.rows[0], matrix.rows[2]) * Shuffle<1, 3, 1, 3>(matrix.rows[1], matrix.rows[3])
+            - Shuffle<1, 3, 1, 3>(matrix.rows[0], matrix.rows[2]) * Shuffle<0, 2, 0, 2>(matrix.rows[1], matrix.rows[3]);
+        const Vec4 detA = Splat<0>(blockDeterminants);
+        const Vec4 detB = Splat<1>(blockDeterminants);
+        const Vec4 detC = Splat<2>(blockDeterminants);
+        const Vec4 detD = Splat<3>(blockDeterminants);
+
+        const Vec4 dc = Mat2AdjugateMultiply(d, c);
+        const Vec4 ab = Mat2AdjugateMultiply(a, b);
+        const Vec4 x = detD * a - Mat2Multiply(b, dc);
+        const Vec4 w = detA * d - Mat2Multiply(c, ab);
+        const Vec4 y = detB * c - Mat2MultiplyAdjugate(d, ab);
+        const Vec4 z = detC * b - Mat2MultiplyAdjugate(a, dc);
+
+        // det(M) = det(a) det(d) + det(b) det(c) - trace(adjugate(a) b adjugate(d) c)
+        const Vec4 trace = Dot4V(ab, Swizzle<0, 2, 1, 3>(dc));
+        const Vec4 determinant = detA * detD + detB * detC - trace;
+        if (outDeterminant != nullptr) *outDeterminant = GetX(determinant);
+        if (GetX(determinant) == 0.f) return IdentityMat4();
+
+        const Vec4 scale = MakeVec4(1.f, -1.f, -1.f, 1.f) / determinant;
+        const Vec4 scaledX = x * scale;
+        const Vec4 scaledY = y * scale;
+        const Vec4 scaledZ = z * scale;
+        const Vec4 scaledW = w * scale;
+        return { {
+            Shuffle<3, 1, 3, 1>(scaledX, scaledY),
+            Shuffle<2, 0, 2, 0>(scaledX, scaledY),
+            Shuffle<3, 1, 3, 1>(scaledZ, scaledW),
+            Shuffle<2, 0, 2, 0>(scaledZ, scaledW),
+        } };
+    }
+
+    // Inverse of a rotation followed by a translation, exact up to rounding and much cheaper than the general inverse.
+    inline Mat4 InverseRigid(const Mat4& matrix)
+    {
+        // The zero row becomes the w column, so the transposed rotation rows and the translation below have w = 0
+        const Vec4 zero = SplatVec4(0.f);
+        Mat4 result = Transpose({ { matrix.rows[0], matrix.rows[1], matrix.rows[2], zero } });
+        const Vec4 translation = MulAdd(Splat<2>(matrix.rows[3]), result.rows[2], MulAdd(Splat<1>(matrix.rows[3]), result.rows[1], Splat<0>(matrix.rows[3]) * result.rows[0]));
+        result.rows[3] = MakeVec4(0.f, 0.f, 0.f, 1.f) - translation;
+        return result;
+    }
+
+    // A matrix with every element broadcast to a FloatV, to transform SimdMath::Width points at once.
+    struct Mat4V
+    {
+        FloatV m[4][4];
+    };
+
+    inline Mat4V Broadcast(const Mat4& matrix)
+    {
+        float elements[16];
+        StoreMat4(elements, matrix);
+        Mat4V result;
+        for (int i = 0; i < 16; i++) result.m[i / 4][i % 4] = Set(elements[i]);
+        return result;
+    }
+
+    // (x, y, z, 1) * M without the w of the result, for affine matrices.
+    inline void TransformPoint(const Mat4V& matrix, FloatV x, FloatV y, FloatV z, FloatV& outX, FloatV& outY, FloatV& outZ)
+    {
+        outX = MulAdd(z, matrix.m[2][0], MulAdd(y, matrix.m[1][0], MulAdd(x, matrix.m[0][0], matrix.m[3][0])));
+        outY = MulAdd(z, matrix.m[2][1], MulAdd(y, matrix.m[1][1], MulAdd(x, matrix.m[0][1], matrix.m[3][1])));
+        outZ = MulAdd(z, matrix.m[2][2], MulAdd(y, matrix.m[1][2], MulAdd(x, matrix.m[0][2], matrix.m[3][2])));
+    }
+
+    // (x, y, z, 1) * M divided by the resulting w.
+    inline void TransformCoord(const Mat4V& matrix, FloatV x, FloatV y, FloatV z, FloatV& outX, FloatV& outY, FloatV& outZ)
+    {
+        const FloatV w = MulAdd(z, matrix.m[2][3], MulAdd(y, matrix.m[1][3], MulAdd(x, matrix.m[0][3], matrix.m[3][3])));
+        const FloatV rcpW = Set(1.f) / w;
+        TransformPoint(matrix, x, y, z, outX, outY, outZ);
+        outX = outX * rcpW;
+        outY = outY * rcpW;
+        outZ = outZ * rcpW;
+    }
+
+    // Runs a FloatV transform over SoA arrays. The tail goes through zero padded buffers, outputs may alias the inputs.
+    template <typename Kernel>
+    inline void TransformArrays(const Mat4& matrix, const float* x, const float* y, const float* z, size_t count, float* outX, float* outY, float* outZ, Kernel kernel)
+    {
+        const Mat4V broadcast = Broadcast(matrix);
+        FloatV resultX, resultY, resultZ;
+        size_t i = 0;
+        for (; i + Width <= count; i += Width)
+        {
+            kernel(broadcast, Load(&x[i]), Load(&y[i]), Load(&z[i]), resultX, resultY, resultZ);
+            Store(&outX[i], resultX);
+            Store(&outY[i], resultY);
+            Store(&outZ[i], resultZ);
+        }
+        if (i == count) return;
+
+        float tail[6][Width] = {};
+        for (size_t lane = 0; i + lane < count; lane++)
+        {
+            tail[0][lane] = x[i + lane];
+            tail[1][lane] = y[i + lane];
+            tail[2][lane] = z[i + lane];
+        }
+        kernel(broadcast, Load(tail[0]), Load(tail[1]), Load(tail[2]), resultX, resultY, resultZ);
+        Store(tail[3], resultX);
+        Store(tail[4], resultY);
+        Store(tail[5], resultZ);
+        for (size_t lane = 0; i + lane < count; lane++)
+        {
+            outX[i + lane] = tail[3][lane];
+            outY[i + lane] = tail[4][lane];
+            outZ[i + lane] = tail[5][lane];
+        }
+    }
+}
+
+// Batch transforms of count points stored as separate x, y and z arrays.
+inline void TransformPointsSoA(const SimdMath::Mat4& matrix, const float* x, const float* y, const float* z, size_t count, float* outX, float* outY, float* outZ)
+{
+    SimdMath::TransformArrays(matrix, x, y, z, count, outX, outY, outZ, [](const SimdMath::Mat4V& m, SimdMath::FloatV px, SimdMath::FloatV py, SimdMath::FloatV pz, SimdMath::FloatV& ox, SimdMath::FloatV& oy, SimdMath::FloatV& oz) {
+        SimdMath::TransformPoint(m, px, py, pz, ox, oy, oz);
+    });
+}
+
+inline void TransformCoordsSoA(const SimdMath::Mat4& matrix, const float* x, const float* y, const float* z, size_t count, float* outX, float* outY, float* outZ)
+{
+    SimdMath::TransformArrays(matrix, x, y, z, count, outX, outY, outZ, [](const SimdMath::Mat4V& m, SimdMath::FloatV px, SimdMath::FloatV py, SimdMath::FloatV pz, SimdMath::FloatV& ox, SimdMath::FloatV& oy, SimdMath::FloatV& oz) {
+        SimdMath::TransformCoord(m, px, py, pz, ox, oy, oz);
+    });
+}
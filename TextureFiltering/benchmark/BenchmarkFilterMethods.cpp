@@ -0,0 +1,448 @@
+#include "../src/PhotoViewerShader.h"
+#include "../../ReferenceRenderer/src/BatchRenderer.h"
+#include "../../ReferenceRenderer/src/PoseTrace.h"
+
+#include <ImageMetrics.h>
+#include <SimdMath.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Quality against cost of every mip filter and shader sampling combination the viewer can use. Each variant is scored
+// against CreatePerfectFilteredImage for every texture and view, the results go into a JSON and a CSV table with the
+// Pareto-optimal variants marked. Runs with the same label, size and views can be compared across commits.
+//
+// Everything works on the texture in the reference renderer's working color space (LinearizeSphereTexture), so the
+// variants only differ in the mip filter and the sampling, not in color handling.
+
+// View rotations about the x axis used without a pose trace, in degrees. 90 is the downward view the viewer's
+// comparison screenshots use, 0 looks at the horizon.
+constexpr float DefaultViewAngles[] = { 90.f, 60.f, 30.f, 0.f, -45.f };
+
+struct SweepOptions
+{
+    std::vector<std::string> texturePaths;
+    std::string posesPath;
+    size_t size = 512;
+    int iterations = 3;
+    int threadCount = 0;
+    SamplerDesc sampler = ViewerSampler;
+    std::string jsonPath = "filter_methods.json";
+    std::string csvPath = "filter_methods.csv";
+    std::string label;
+};
+
+// One variant rendered for one texture and view.
+struct SweepSample
+{
+    size_t texture = 0;
+    size_t view = 0;
+    MipFilter filter = MipFilter::Point;
+    ShaderSampling sampling = ShaderSampling::Default;
+    double renderMilliseconds = 0.;
+    ImageMetrics metrics{};
+};
+
+// A variant summed up over all textures and views.
+struct VariantResult
+{
+    MipFilter filter = MipFilter::Point;
+    ShaderSampling sampling = ShaderSampling::Default;
+    double mipMilliseconds = 0.;  // sum over the textures
+    size_t mipBytes = 0;          // sum over the textures
+    size_t mipArenaBytes = 0;     // largest scratch and level memory of one texture
+    double renderMilliseconds = 0.; // mean per view
+    double ssim = 0.;
+    double msSsim = 0.;
+    double mse = 0.;
+    double psnr = 0.;             // of the mean MSE
+    bool pareto = false;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkFilterMethods [--texture|-t <equirect image>]... [--poses|-p <pose trace>] [--size|-s <pixels>]" << std::endl;
+    std::cout << "                       [--iterations|-i <best of count>] [--threads|-j <count, 0 = all>] [--label|-l <text>]" << std::endl;
+    std::cout << "                       [--sampler <Trilinear|Anisotropic>] [--max-anisotropy <1 - 16>] [--json <path>] [--csv <path>]" << std::endl;
+    std::cout << "Without textures a single pixel checkerboard is used, without poses a sweep from looking down to the horizon." << std::endl;
+    std::cout << "The sampler defaults to the viewer's, anisotropic with up to 16 probes." << std::endl;
+    std::cout << "Variants are on the Pareto front if no other one is at most as expensive in mip time, mip memory and render time and has a higher SSIM." << std::endl;
+}
+
+// Sampler filter by its SamplerFilterName, case sensitive.
+SamplerFilter ParseSamplerFilter(const std::string& name)
+{
+    for (SamplerFilter filter : AllSamplerFilters)
+    {
+        if (name == SamplerFilterName(filter)) return filter;
+    }
+    throw std::invalid_argument("Unknown sampler filter: " + name);
+}
+
+bool ParseCommandLine(SweepOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePaths.push_back(getNextArg());
+        }
+        else if (arg == "--poses" || arg == "-p")
+        {
+            options.posesPath = getNextArg();
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.size = std::stoul(getNextArg());
+        }
+        else if (arg == "--iterations" || arg == "-i")
+        {
+            options.iterations = std::max(1, std::stoi(getNextArg()));
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--label" || arg == "-l")
+        {
+            options.label = getNextArg();
+        }
+        else if (arg == "--json")
+        {
+            options.jsonPath = getNextArg();
+        }
+        else if (arg == "--csv")
+        {
+            options.csvPath = getNextArg();
+        }
+        else if (arg == "--sampler")
+        {
+            options.sampler.filter = ParseSamplerFilter(getNextArg());
+        }
+        else if (arg == "--max-anisotropy")
+        {
+            options.sampler.maxAnisotropy = std::clamp(std::stoi(getNextArg()), 1, 16);
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    if (options.size < 2)
+    {
+        std::cout << "The view needs at least 2x2 pixels" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Runs the function repeatedly and returns the best time in milliseconds, the arena is reset before every run.
+template <typename Function>
+double MeasureBest(MemoryArena& arena, int iterations, Function function)
+{
+    double bestMilliseconds = 0.;
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        arena.Reset();
+        auto measureStart = std::chrono::high_resolution_clock::now();
+        function();
+        auto measureEnd = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(measureEnd - measureStart).count();
+        bestMilliseconds = iteration == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+    }
+    return bestMilliseconds;
+}
+
+// Single pixel checkerboard, the worst case for aliasing
+SphereTexture CreateCheckerboard(MemoryArena& arena)
+{
+    SphereTexture texture{};
+    texture.width = 2048;
+    texture.height = 1024;
+    uint8_t* pixels = NewArray(arena, uint8_t, texture.width * texture.height * 3);
+    for (int i = 0; i < texture.width * texture.height; i++)
+    {
+        const uint8_t value = ((i % texture.width) + (i / texture.width)) % 2 == 0 ? 0 : 255;
+        pixels[i * 3] = pixels[i * 3 + 1] = pixels[i * 3 + 2] = value;
+    }
+    texture.data = pixels;
+    return texture;
+}
+
+// Marks every variant no other variant dominates: at most the same mip time, mip memory and render time and a higher SSIM,
+// or lower cost somewhere at the same SSIM.
+void MarkParetoFront(std::vector<VariantResult>& variants)
+{
+    for (VariantResult& variant : variants)
+    {
+        variant.pareto = true;
+        for (const VariantResult& other : variants)
+        {
+            const bool noWorse = other.mipMilliseconds <= variant.mipMilliseconds && other.mipBytes <= variant.mipBytes
+                && other.renderMilliseconds <= variant.renderMilliseconds && other.ssim >= variant.ssim;
+            const bool better = other.mipMilliseconds < variant.mipMilliseconds || other.mipBytes < variant.mipBytes
+                || other.renderMilliseconds < variant.renderMilliseconds || other.ssim > variant.ssim;
+            if (noWorse && better)
+            {
+                variant.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+// JSON has no infinity, identical images get null
+nlohmann::json JsonNumber(double value)
+{
+    return std::isfinite(value) ? nlohmann::json(value) : nlohmann::json(nullptr);
+}
+
+int main(int argc, char* argv[])
+{
+    SweepOptions options{};
+    std::vector<ReferenceView> views;
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+        if (!options.posesPath.empty())
+        {
+            for (const PoseSample& pose : LoadPoseTrace(options.posesPath))
+            {
+                views.push_back(ViewFromPoseSample(pose, options.size, options.size));
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    if (options.posesPath.empty())
+    {
+        for (float angle : DefaultViewAngles)
+        {
+            ReferenceView view{};
+            view.spaceToView = RotationAxis({ 1.f, 0.f, 0.f }, angle * RENDER_PI / 180.f);
+            view.projection = ProjectionFov(-RENDER_PI / 4.f, RENDER_PI / 4.f, RENDER_PI / 4.f, -RENDER_PI / 4.f, 0.05f, 100.f);
+            view.screenWidth = options.size;
+            view.screenHeight = options.size;
+            views.push_back(view);
+        }
+    }
+
+    std::vector<std::string> textureNames = options.texturePaths;
+    if (textureNames.empty()) textureNames.push_back("checkerboard");
+
+    std::vector<VariantResult> variants;
+    for (MipFilter filter : AllMipFilters)
+    {
+        for (ShaderSampling sampling : AllShaderSamplings)
+        {
+            VariantResult variant{};
+            variant.filter = filter;
+            variant.sampling = sampling;
+            variants.push_back(variant);
+        }
+    }
+
+    MemoryArena textureArena{ "SweepTexture", 4ull * 1024 * 1024 * 1024 };
+    MemoryArena mipArena{ "SweepMips" };
+    MemoryArena referenceArena{ "SweepReference" };
+    MemoryArena renderArena{ "SweepRender" };
+    MemoryArena metricArena{ "SweepMetrics" };
+
+    std::vector<SweepSample> samples;
+    std::vector<double> referenceMilliseconds;
+    auto sweepStart = std::chrono::high_resolution_clock::now();
+    for (size_t textureIndex = 0; textureIndex < textureNames.size(); textureIndex++)
+    {
+        textureArena.Reset();
+        SphereTexture texture{};
+        uint8_t* loadedData = nullptr;
+        if (!options.texturePaths.empty())
+        {
+            int channelCount;
+            loadedData = stbi_load(options.texturePaths[textureIndex].c_str(), &texture.width, &texture.height, &channelCount, 3);
+            if (loadedData == nullptr)
+            {
+                std::cout << options.texturePaths[textureIndex] << ": " << stbi_failure_reason() << std::endl;
+                return 1;
+            }
+            texture.data = loadedData;
+        }
+        else
+        {
+            texture = CreateCheckerboard(textureArena);
+        }
+
+        // The reference integrates every footprint exactly with the summed area table
+        const PreparedTexture prepared = PrepareTexture(textureArena, texture, true, options.threadCount);
+        if (loadedData != nullptr) stbi_image_free(loadedData);
+        RenderSettings referenceSettings{};
+        referenceSettings.coverage = CoverageMode::Analytic;
+        referenceSettings.summedAreaTable = &GetSummedAreaTable(prepared);
+        referenceSettings.threadCount = options.threadCount;
+
+        std::vector<const uint8_t*> references;
+        referenceArena.Reset();
+        for (const ReferenceView& view : views)
+        {
+            auto measureStart = std::chrono::high_resolution_clock::now();
+            references.push_back(CreatePerfectFilteredImage(referenceArena, prepared.texture, view, referenceSettings));
+            auto measureEnd = std::chrono::high_resolution_clock::now();
+            referenceMilliseconds.push_back(std::chrono::duration<double, std::milli>(measureEnd - measureStart).count());
+        }
+
+        for (VariantResult& variant : variants)
+        {
+            MipChain chain{};
+            const double mipMilliseconds = MeasureBest(mipArena, options.iterations, [&] {
+                chain = GenerateMipChain(mipArena, prepared.texture, variant.filter, options.threadCount);
+            });
+            variant.mipMilliseconds += mipMilliseconds;
+            variant.mipBytes += chain.byteCount;
+            variant.mipArenaBytes = std::max(variant.mipArenaBytes, mipArena.used);
+
+            for (size_t viewIndex = 0; viewIndex < views.size(); viewIndex++)
+            {
+                SweepSample sample{};
+                sample.texture = textureIndex;
+                sample.view = viewIndex;
+                sample.filter = variant.filter;
+                sample.sampling = variant.sampling;
+
+                const uint8_t* image = nullptr;
+                sample.renderMilliseconds = MeasureBest(renderArena, options.iterations, [&] {
+                    image = RenderPhotoViewer(renderArena, chain, views[viewIndex], variant.sampling, options.sampler, options.threadCount);
+                });
+
+                MetricSettings metricSettings{};
+                metricSettings.threadCount = options.threadCount;
+                const MetricImage referenceImage{ static_cast<int>(options.size), static_cast<int>(options.size), 3, references[viewIndex] };
+                const MetricImage variantImage{ static_cast<int>(options.size), static_cast<int>(options.size), 3, image };
+                metricArena.Reset();
+                sample.metrics = CompareImages(metricArena, referenceImage, variantImage, metricSettings);
+                samples.push_back(sample);
+            }
+        }
+        std::cout << "Finished " << textureNames[textureIndex] << std::endl;
+    }
+    auto sweepEnd = std::chrono::high_resolution_clock::now();
+
+    for (VariantResult& variant : variants)
+    {
+        size_t count = 0;
+        for (const SweepSample& sample : samples)
+        {
+            if (sample.filter != variant.filter || sample.sampling != variant.sampling) continue;
+            variant.renderMilliseconds += sample.renderMilliseconds;
+            variant.ssim += sample.metrics.ssim;
+            variant.msSsim += sample.metrics.msSsim;
+            variant.mse += sample.metrics.mse;
+            count++;
+        }
+        variant.renderMilliseconds /= count;
+        variant.ssim /= count;
+        variant.msSsim /= count;
+        variant.mse /= count;
+        variant.psnr = PsnrFromMse(variant.mse);
+    }
+    MarkParetoFront(variants);
+
+    nlohmann::json json;
+    json["label"] = options.label;
+    json["instructionSet"] = SimdMath::InstructionSet;
+    json["size"] = options.size;
+    json["samplerFilter"] = SamplerFilterName(options.sampler.filter);
+    json["maxAnisotropy"] = options.sampler.maxAnisotropy;
+    json["iterations"] = options.iterations;
+    json["textures"] = textureNames;
+    json["viewCount"] = views.size();
+    json["sweepMilliseconds"] = std::chrono::duration<double, std::milli>(sweepEnd - sweepStart).count();
+    json["referenceMilliseconds"] = referenceMilliseconds;
+    for (const VariantResult& variant : variants)
+    {
+        json["variants"].push_back({
+            { "mipFilter", MipFilterName(variant.filter) },
+            { "sampling", ShaderSamplingName(variant.sampling) },
+            { "mipMilliseconds", variant.mipMilliseconds },
+            { "mipBytes", variant.mipBytes },
+            { "mipArenaBytes", variant.mipArenaBytes },
+            { "renderMilliseconds", variant.renderMilliseconds },
+            { "ssim", variant.ssim },
+            { "msSsim", variant.msSsim },
+            { "mse", variant.mse },
+            { "psnr", JsonNumber(variant.psnr) },
+            { "pareto", variant.pareto },
+        });
+    }
+    for (const SweepSample& sample : samples)
+    {
+        json["samples"].push_back({
+            { "texture", textureNames[sample.texture] },
+            { "view", sample.view },
+            { "mipFilter", MipFilterName(sample.filter) },
+            { "sampling", ShaderSamplingName(sample.sampling) },
+            { "renderMilliseconds", sample.renderMilliseconds },
+            { "ssim", sample.metrics.ssim },
+            { "msSsim", sample.metrics.msSsim },
+            { "mse", sample.metrics.mse },
+            { "psnr", JsonNumber(sample.metrics.psnr) },
+        });
+    }
+
+    std::ofstream jsonFile(options.jsonPath);
+    jsonFile << json.dump(2) << std::endl;
+    std::ofstream csvFile(options.csvPath);
+    csvFile << "label,mip_filter,sampling,sampler,mip_ms,mip_bytes,render_ms,ssim,ms_ssim,mse,psnr,pareto" << std::endl;
+    for (const VariantResult& variant : variants)
+    {
+        csvFile << options.label << "," << MipFilterName(variant.filter) << "," << ShaderSamplingName(variant.sampling) << "," << SamplerFilterName(options.sampler.filter) << "," << variant.mipMilliseconds << ","
+                << variant.mipBytes << "," << variant.renderMilliseconds << "," << variant.ssim << "," << variant.msSsim << "," << variant.mse << ","
+                << variant.psnr << "," << (variant.pareto ? 1 : 0) << std::endl;
+    }
+    if (!jsonFile || !csvFile)
+    {
+        std::cout << "Failed to write " << options.jsonPath << " or " << options.csvPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Filter       Sampling  Mips (ms)  Render (ms)  SSIM     MS-SSIM  PSNR" << std::endl;
+    for (const VariantResult& variant : variants)
+    {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-12s %-9s %9.2f  %11.2f  %.4f   %.4f   %.2f%s", MipFilterName(variant.filter), ShaderSamplingName(variant.sampling),
+                      variant.mipMilliseconds, variant.renderMilliseconds, variant.ssim, variant.msSsim, variant.psnr, variant.pareto ? "  pareto" : "");
+        std::cout << line << std::endl;
+    }
+    return 0;
+}
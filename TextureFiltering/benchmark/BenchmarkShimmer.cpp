@@ -0,0 +1,411 @@
+#include "../src/PhotoViewerShader.h"
+#include "../../ReferenceRenderer/src/BatchRenderer.h"
+#include "../../ReferenceRenderer/src/PoseTrace.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Temporal aliasing of every mip filter and shader sampling combination during a head rotation. Aliasing shows up as
+// flicker: pixels change between frames more (or differently) than the correctly filtered image does. For every pair
+// of consecutive frames the change of a method is compared against the change of the reference sequence
+// (CreatePerfectFilteredImage):
+//   shimmer = RMS over pixels and channels of ((method[t + 1] - method[t]) - (reference[t + 1] - reference[t]))
+// averaged over all frame pairs, in 8 bit levels. A method that only differs from the reference by a constant blur
+// scores close to 0, one whose error jumps around between frames scores high. The flicker of a method (RMS of its own
+// frame to frame change) is reported next to it, the reference flickers too where its box footprints alias.
+//
+// Frames are streamed: the sequence is split into one block of consecutive frames per thread, and every thread only
+// keeps the previous and the current frame of every method.
+
+struct ShimmerOptions
+{
+    std::string texturePath;
+    std::string posesPath;
+    size_t size = 256;
+    size_t frameCount = 90;
+    float degreesPerFrame = .5f; // 45 degrees per second at 90 Hz
+    float pitchDegrees = 60.f;   // view rotation about x, 90 looks straight down like the viewer's comparison view
+    int threadCount = 0;
+    SamplerDesc sampler = ViewerSampler;
+    std::string csvPath = "shimmer.csv";
+    std::string frameCsvPath;
+    std::string label;
+};
+
+// One method of the sweep and the mip chain it samples.
+struct ShimmerMethod
+{
+    MipFilter filter = MipFilter::Point;
+    ShaderSampling sampling = ShaderSampling::Default;
+    const MipChain* chain = nullptr;
+};
+
+// Sums of one method over a block of frames.
+struct ShimmerSums
+{
+    double shimmer = 0.;      // sum of the per frame pair RMS temporal errors
+    double flicker = 0.;      // sum of the per frame pair RMS changes of the method itself
+    double squaredError = 0.; // sum of the per frame mean squared errors against the reference
+    size_t framePairCount = 0;
+    size_t frameCount = 0;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkShimmer [--texture|-t <equirect image>] [--poses|-p <pose trace> | --frames|-n <count> [--speed <degrees per frame>] [--pitch <degrees>]]" << std::endl;
+    std::cout << "                 [--size|-s <pixels>] [--threads|-j <count, 0 = all>] [--sampler <Trilinear|Anisotropic>] [--max-anisotropy <1 - 16>]" << std::endl;
+    std::cout << "                 [--label|-l <text>] [--csv <path>] [--frame-csv <path>]" << std::endl;
+    std::cout << "Without a texture a single pixel checkerboard is used. Without poses the view turns around the vertical axis at the given pitch." << std::endl;
+    std::cout << "Pose traces use the samples of eye 0 in file order as frames." << std::endl;
+}
+
+// Sampler filter by its SamplerFilterName, case sensitive.
+SamplerFilter ParseSamplerFilter(const std::string& name)
+{
+    for (SamplerFilter filter : AllSamplerFilters)
+    {
+        if (name == SamplerFilterName(filter)) return filter;
+    }
+    throw std::invalid_argument("Unknown sampler filter: " + name);
+}
+
+bool ParseCommandLine(ShimmerOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePath = getNextArg();
+        }
+        else if (arg == "--poses" || arg == "-p")
+        {
+            options.posesPath = getNextArg();
+        }
+        else if (arg == "--frames" || arg == "-n")
+        {
+            options.frameCount = std::stoul(getNextArg());
+        }
+        else if (arg == "--speed")
+        {
+            options.degreesPerFrame = std::stof(getNextArg());
+        }
+        else if (arg == "--pitch")
+        {
+            options.pitchDegrees = std::stof(getNextArg());
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.size = std::stoul(getNextArg());
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--label" || arg == "-l")
+        {
+            options.label = getNextArg();
+        }
+        else if (arg == "--csv")
+        {
+            options.csvPath = getNextArg();
+        }
+        else if (arg == "--frame-csv")
+        {
+            options.frameCsvPath = getNextArg();
+        }
+        else if (arg == "--sampler")
+        {
+            options.sampler.filter = ParseSamplerFilter(getNextArg());
+        }
+        else if (arg == "--max-anisotropy")
+        {
+            options.sampler.maxAnisotropy = std::clamp(std::stoi(getNextArg()), 1, 16);
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    if (options.size < 2)
+    {
+        std::cout << "The view needs at least 2x2 pixels" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Single pixel checkerboard, the worst case for aliasing
+SphereTexture CreateCheckerboard(MemoryArena& arena)
+{
+    SphereTexture texture{};
+    texture.width = 2048;
+    texture.height = 1024;
+    uint8_t* pixels = NewArray(arena, uint8_t, texture.width * texture.height * 3);
+    for (int i = 0; i < texture.width * texture.height; i++)
+    {
+        const uint8_t value = ((i % texture.width) + (i / texture.width)) % 2 == 0 ? 0 : 255;
+        pixels[i * 3] = pixels[i * 3 + 1] = pixels[i * 3 + 2] = value;
+    }
+    texture.data = pixels;
+    return texture;
+}
+
+// Mean squared difference of the frame to frame changes of a method and the reference.
+double MeanSquaredTemporalError(const uint8_t* previous, const uint8_t* current, const uint8_t* previousReference, const uint8_t* currentReference, size_t valueCount)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < valueCount; i++)
+    {
+        const int error = (current[i] - previous[i]) - (currentReference[i] - previousReference[i]);
+        sum += error * error;
+    }
+    return static_cast<double>(sum) / static_cast<double>(valueCount);
+}
+
+double MeanSquaredError(const uint8_t* image, const uint8_t* reference, size_t valueCount)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < valueCount; i++)
+    {
+        const int error = image[i] - reference[i];
+        sum += error * error;
+    }
+    return static_cast<double>(sum) / static_cast<double>(valueCount);
+}
+
+int main(int argc, char* argv[])
+{
+    ShimmerOptions options{};
+    std::vector<ReferenceView> frames;
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+        if (!options.posesPath.empty())
+        {
+            for (const PoseSample& pose : LoadPoseTrace(options.posesPath))
+            {
+                if (pose.eye == 0) frames.push_back(ViewFromPoseSample(pose, options.size, options.size));
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    if (options.posesPath.empty())
+    {
+        const Matrix4 pitch = RotationAxis({ 1.f, 0.f, 0.f }, options.pitchDegrees * RENDER_PI / 180.f);
+        for (size_t frame = 0; frame < options.frameCount; frame++)
+        {
+            ReferenceView view{};
+            view.spaceToView = Multiply(RotationAxis({ 0.f, 1.f, 0.f }, frame * options.degreesPerFrame * RENDER_PI / 180.f), pitch);
+            view.projection = ProjectionFov(-RENDER_PI / 4.f, RENDER_PI / 4.f, RENDER_PI / 4.f, -RENDER_PI / 4.f, 0.05f, 100.f);
+            view.screenWidth = options.size;
+            view.screenHeight = options.size;
+            frames.push_back(view);
+        }
+    }
+    if (frames.size() < 2)
+    {
+        std::cout << "The sequence needs at least 2 frames" << std::endl;
+        return 1;
+    }
+
+    auto measureStart = std::chrono::high_resolution_clock::now();
+
+    MemoryArena textureArena{ "ShimmerTexture", 4ull * 1024 * 1024 * 1024 };
+    SphereTexture texture{};
+    uint8_t* loadedData = nullptr;
+    if (!options.texturePath.empty())
+    {
+        int channelCount;
+        loadedData = stbi_load(options.texturePath.c_str(), &texture.width, &texture.height, &channelCount, 3);
+        if (loadedData == nullptr)
+        {
+            std::cout << stbi_failure_reason() << std::endl;
+            return 1;
+        }
+        texture.data = loadedData;
+    }
+    else
+    {
+        texture = CreateCheckerboard(textureArena);
+    }
+    const PreparedTexture prepared = PrepareTexture(textureArena, texture, true, options.threadCount);
+    if (loadedData != nullptr) stbi_image_free(loadedData);
+
+    // Mip chains are built once and shared read-only by all threads
+    MemoryArena mipArena{ "ShimmerMips" };
+    std::vector<MipChain> chains;
+    for (MipFilter filter : AllMipFilters)
+    {
+        chains.push_back(GenerateMipChain(mipArena, prepared.texture, filter, options.threadCount));
+    }
+    std::vector<ShimmerMethod> methods;
+    for (size_t filter = 0; filter < std::size(AllMipFilters); filter++)
+    {
+        for (ShaderSampling sampling : AllShaderSamplings)
+        {
+            methods.push_back({ AllMipFilters[filter], sampling, &chains[filter] });
+        }
+    }
+
+    // One block of consecutive frames per thread. A block also renders the frame before it, the first pair of the
+    // block needs it, so every block boundary costs one extra frame.
+    int threadCount = options.threadCount;
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    const size_t blockCount = std::min<size_t>(frames.size() - 1, threadCount);
+    const size_t blockSize = (frames.size() + blockCount - 1) / blockCount;
+    const int frameThreadCount = std::max(1, threadCount / static_cast<int>(blockCount));
+
+    RenderSettings referenceSettings{};
+    referenceSettings.coverage = CoverageMode::Analytic;
+    referenceSettings.summedAreaTable = &GetSummedAreaTable(prepared);
+    referenceSettings.threadCount = frameThreadCount;
+
+    // Per block sums, and the shimmer of every frame pair (written by the block the pair's later frame belongs to)
+    const size_t valueCount = options.size * options.size * 3;
+    std::vector<std::vector<ShimmerSums>> blockSums(blockCount, std::vector<ShimmerSums>(methods.size()));
+    std::vector<double> pairShimmer(frames.size() * methods.size(), 0.);
+    std::vector<double> referenceFlicker(frames.size(), 0.);
+
+    // Two arenas per block: the previous frame's images stay in one while the current frame is rendered into the other
+    std::vector<std::unique_ptr<MemoryArena>> arenas;
+    for (size_t arena = 0; arena < blockCount * 2; arena++)
+    {
+        arenas.push_back(std::make_unique<MemoryArena>("ShimmerFrame"));
+    }
+
+    RunTiles(blockCount, static_cast<int>(blockCount), [&](size_t block, int) {
+        const size_t firstFrame = block * blockSize;
+        const size_t endFrame = std::min(frames.size(), firstFrame + blockSize);
+        std::vector<const uint8_t*> previous(methods.size() + 1, nullptr);
+        std::vector<const uint8_t*> current(methods.size() + 1, nullptr);
+
+        for (size_t frame = firstFrame == 0 ? 0 : firstFrame - 1; frame < endFrame; frame++)
+        {
+            MemoryArena& arena = *arenas[block * 2 + frame % 2];
+            arena.Reset();
+
+            // Index 0 is the reference, the methods follow
+            current[0] = CreatePerfectFilteredImage(arena, prepared.texture, frames[frame], referenceSettings);
+            for (size_t method = 0; method < methods.size(); method++)
+            {
+                current[method + 1] = RenderPhotoViewer(arena, *methods[method].chain, frames[frame], methods[method].sampling, options.sampler, frameThreadCount);
+            }
+
+            if (frame >= firstFrame)
+            {
+                for (size_t method = 0; method < methods.size(); method++)
+                {
+                    ShimmerSums& sums = blockSums[block][method];
+                    sums.squaredError += MeanSquaredError(current[method + 1], current[0], valueCount);
+                    sums.frameCount++;
+                    if (frame == 0) continue;
+
+                    const double shimmer = std::sqrt(MeanSquaredTemporalError(previous[method + 1], current[method + 1], previous[0], current[0], valueCount));
+                    sums.shimmer += shimmer;
+                    sums.flicker += std::sqrt(MeanSquaredError(current[method + 1], previous[method + 1], valueCount));
+                    sums.framePairCount++;
+                    pairShimmer[frame * methods.size() + method] = shimmer;
+                }
+                if (frame > 0)
+                {
+                    referenceFlicker[frame] = std::sqrt(MeanSquaredError(current[0], previous[0], valueCount));
+                }
+            }
+            std::swap(previous, current);
+        }
+    });
+
+    auto measureEnd = std::chrono::high_resolution_clock::now();
+
+    std::ofstream csvFile(options.csvPath);
+    double meanReferenceFlicker = 0.;
+    for (double flicker : referenceFlicker) meanReferenceFlicker += flicker;
+    meanReferenceFlicker /= frames.size() - 1;
+
+    csvFile << "label,mip_filter,sampling,sampler,shimmer,flicker,reference_flicker,mse,frames" << std::endl;
+    std::cout << "Filter       Sampling  Shimmer  Flicker  MSE" << std::endl;
+    for (size_t method = 0; method < methods.size(); method++)
+    {
+        ShimmerSums total{};
+        for (const std::vector<ShimmerSums>& sums : blockSums)
+        {
+            total.shimmer += sums[method].shimmer;
+            total.flicker += sums[method].flicker;
+            total.squaredError += sums[method].squaredError;
+            total.framePairCount += sums[method].framePairCount;
+            total.frameCount += sums[method].frameCount;
+        }
+        const double shimmer = total.shimmer / total.framePairCount;
+        const double flicker = total.flicker / total.framePairCount;
+        const double mse = total.squaredError / total.frameCount;
+
+        const char* filterName = MipFilterName(methods[method].filter);
+        const char* samplingName = ShaderSamplingName(methods[method].sampling);
+        csvFile << options.label << "," << filterName << "," << samplingName << "," << SamplerFilterName(options.sampler.filter) << "," << shimmer << "," << flicker << "," << meanReferenceFlicker << "," << mse << "," << total.frameCount << std::endl;
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-12s %-9s %7.3f  %7.3f  %.2f", filterName, samplingName, shimmer, flicker, mse);
+        std::cout << line << std::endl;
+    }
+    std::cout << "Reference flicker " << meanReferenceFlicker << std::endl;
+
+    if (!options.frameCsvPath.empty())
+    {
+        std::ofstream frameCsvFile(options.frameCsvPath);
+        frameCsvFile << "frame,reference_flicker";
+        for (const ShimmerMethod& method : methods)
+        {
+            frameCsvFile << "," << MipFilterName(method.filter) << "_" << ShaderSamplingName(method.sampling);
+        }
+        frameCsvFile << std::endl;
+        for (size_t frame = 1; frame < frames.size(); frame++)
+        {
+            frameCsvFile << frame << "," << referenceFlicker[frame];
+            for (size_t method = 0; method < methods.size(); method++)
+            {
+                frameCsvFile << "," << pairShimmer[frame * methods.size() + method];
+            }
+            frameCsvFile << std::endl;
+        }
+    }
+
+    std::cout << frames.size() << " frames of " << options.size << "x" << options.size << " finished in: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(measureEnd - measureStart).count() << "ms" << std::endl;
+    return 0;
+}
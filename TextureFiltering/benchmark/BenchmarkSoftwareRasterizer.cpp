@@ -0,0 +1,376 @@
+#include "../src/SoftwareRasterizer.h"
+#include "../../ReferenceRenderer/src/BatchRenderer.h"
+#include "../../ReferenceRenderer/src/PoseTrace.h"
+
+#include <ImageMetrics.h>
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Frame time of the software rasterizer on the viewer's environment mesh, split into setup, binning and shading. Every
+// frame is also compared against RenderPhotoViewer, which shades the same pixels from ray cast texture positions on the
+// ideal sphere: a low SSIM there means the rasterizer (or the mesh) is off, not the filtering. models/sphere_subdiv2.glb
+// runs u the other way around than the equirect mapping of the ray cast, its frames are the mirror image of the ray cast.
+// Even the generated UV sphere does not match exactly: it interpolates u and v linearly across flat triangles, a few
+// hundredths of a texel off the ray cast. The trilinear sampler blurs that away (SSIM about 0.9995 at 256x256), the
+// anisotropic one samples finer mips, where the single pixel checkerboard turns it into SSIM 0.98 - 0.995. With the
+// texture positions of the ray cast interpolated instead, every view but the one straight down reaches 0.999, so the
+// quad gradients and probe counts of the two paths agree.
+
+// The viewer draws the environment mesh scaled down to a tenth (graphicsplugin_custom.cpp).
+constexpr float EnvironmentScale = .1f;
+
+struct RasterOptions
+{
+    std::string texturePath;
+    std::string meshPath;
+    std::string posesPath;
+    size_t size = 1024;
+    int iterations = 5;
+    int threadCount = 0;
+    ShaderSampling sampling = ShaderSampling::Default;
+    SamplerDesc sampler = ViewerSampler;
+    std::string imagePrefix;
+};
+
+void ShowHelp()
+{
+    std::cout << "BenchmarkSoftwareRasterizer [--texture|-t <equirect image>] [--mesh|-m <glb>] [--poses|-p <pose trace>] [--size|-s <pixels>]" << std::endl;
+    std::cout << "                            [--iterations|-i <best of count>] [--threads|-j <count, 0 = all>] [--sampling <Default|Adjusted>]" << std::endl;
+    std::cout << "                            [--sampler <Trilinear|Anisotropic>] [--max-anisotropy <1 - 16>] [--images <path prefix>]" << std::endl;
+    std::cout << "Without a texture a single pixel checkerboard is used, without a mesh a UV sphere mapped like the ray cast." << std::endl;
+    std::cout << "Without poses a sweep from looking down to the horizon. --images writes the rasterized frames as PNG." << std::endl;
+}
+
+SamplerFilter ParseSamplerFilter(const std::string& name)
+{
+    for (SamplerFilter filter : AllSamplerFilters)
+    {
+        if (name == SamplerFilterName(filter)) return filter;
+    }
+    throw std::invalid_argument("Unknown sampler filter: " + name);
+}
+
+ShaderSampling ParseShaderSampling(const std::string& name)
+{
+    for (ShaderSampling sampling : AllShaderSamplings)
+    {
+        if (name == ShaderSamplingName(sampling)) return sampling;
+    }
+    throw std::invalid_argument("Unknown sampling: " + name);
+}
+
+bool ParseCommandLine(RasterOptions& options, int argc, char* argv[])
+{
+    int i = 1; // Index 0 is the program name and is skipped.
+
+    auto getNextArg = [&] {
+        if (i >= argc)
+        {
+            throw std::invalid_argument("Argument parameter missing");
+        }
+        return std::string(argv[i++]);
+    };
+
+    while (i < argc)
+    {
+        const std::string arg = getNextArg();
+        if (arg == "--texture" || arg == "-t")
+        {
+            options.texturePath = getNextArg();
+        }
+        else if (arg == "--mesh" || arg == "-m")
+        {
+            options.meshPath = getNextArg();
+        }
+        else if (arg == "--poses" || arg == "-p")
+        {
+            options.posesPath = getNextArg();
+        }
+        else if (arg == "--size" || arg == "-s")
+        {
+            options.size = std::stoul(getNextArg());
+        }
+        else if (arg == "--iterations" || arg == "-i")
+        {
+            options.iterations = std::max(1, std::stoi(getNextArg()));
+        }
+        else if (arg == "--threads" || arg == "-j")
+        {
+            options.threadCount = std::stoi(getNextArg());
+        }
+        else if (arg == "--sampling")
+        {
+            options.sampling = ParseShaderSampling(getNextArg());
+        }
+        else if (arg == "--sampler")
+        {
+            options.sampler.filter = ParseSamplerFilter(getNextArg());
+        }
+        else if (arg == "--max-anisotropy")
+        {
+            options.sampler.maxAnisotropy = std::clamp(std::stoi(getNextArg()), 1, 16);
+        }
+        else if (arg == "--images")
+        {
+            options.imagePrefix = getNextArg();
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            ShowHelp();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+
+    if (options.size < 2)
+    {
+        std::cout << "The view needs at least 2x2 pixels" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Single pixel checkerboard, the worst case for aliasing
+SphereTexture CreateCheckerboard(MemoryArena& arena)
+{
+    SphereTexture texture{};
+    texture.width = 2048;
+    texture.height = 1024;
+    uint8_t* pixels = NewArray(arena, uint8_t, texture.width * texture.height * 3);
+    for (int i = 0; i < texture.width * texture.height; i++)
+    {
+        const uint8_t value = ((i % texture.width) + (i / texture.width)) % 2 == 0 ? 0 : 255;
+        pixels[i * 3] = pixels[i * 3 + 1] = pixels[i * 3 + 2] = value;
+    }
+    texture.data = pixels;
+    return texture;
+}
+
+// Like models/sphere_subdiv2.glb (radius 100, seam vertices doubled, faces wound clockwise as seen from the center), but
+// with the texture coordinates of the ray cast's equirect mapping.
+void CreateUvSphere(int segmentsU, int segmentsV, std::vector<RasterVertex>& outVertices, std::vector<uint16_t>& outIndices)
+{
+    for (int row = 0; row <= segmentsV; row++)
+    {
+        const float v = static_cast<float>(row) / segmentsV;
+        const float theta = v * RENDER_PI;
+        for (int column = 0; column <= segmentsU; column++)
+        {
+            const float u = static_cast<float>(column) / segmentsU;
+            const float phi = u * RENDER_2PI - RENDER_PI;
+            RasterVertex vertex{};
+            vertex.position = { 100.f * std::sin(theta) * std::cos(phi), 100.f * std::cos(theta), 100.f * std::sin(theta) * std::sin(phi) };
+            vertex.texCoord = { u, v };
+            outVertices.push_back(vertex);
+        }
+    }
+    for (int row = 0; row < segmentsV; row++)
+    {
+        for (int column = 0; column < segmentsU; column++)
+        {
+            const uint16_t topLeft = static_cast<uint16_t>(row * (segmentsU + 1) + column);
+            const uint16_t bottomLeft = static_cast<uint16_t>(topLeft + segmentsU + 1);
+            outIndices.insert(outIndices.end(), { topLeft, static_cast<uint16_t>(topLeft + 1), bottomLeft });
+            outIndices.insert(outIndices.end(), { static_cast<uint16_t>(topLeft + 1), static_cast<uint16_t>(bottomLeft + 1), bottomLeft });
+        }
+    }
+}
+
+// The first primitive of the first mesh, like LoadGltf in the viewer.
+bool LoadGlbMesh(const std::string& path, std::vector<RasterVertex>& outVertices, std::vector<uint16_t>& outIndices)
+{
+    tinygltf::Model model;
+    tinygltf::TinyGLTF loader;
+    std::string error;
+    std::string warning;
+    if (!loader.LoadBinaryFromFile(&model, &error, &warning, path) || model.meshes.empty())
+    {
+        std::cout << path << ": " << error << std::endl;
+        return false;
+    }
+
+    auto readBuffer = [&](const tinygltf::Accessor& accessor) {
+        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+        return &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+    };
+
+    tinygltf::Primitive& primitive = model.meshes[0].primitives[0];
+    const tinygltf::Accessor& indices = model.accessors[primitive.indices];
+    const tinygltf::Accessor& positions = model.accessors[primitive.attributes["POSITION"]];
+    const tinygltf::Accessor& texCoords = model.accessors[primitive.attributes["TEXCOORD_0"]];
+    if (indices.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+    {
+        std::cout << path << ": only 16 bit indices are supported" << std::endl;
+        return false;
+    }
+
+    const uint16_t* indexData = reinterpret_cast<const uint16_t*>(readBuffer(indices));
+    outIndices.assign(indexData, indexData + indices.count);
+    const float* positionData = reinterpret_cast<const float*>(readBuffer(positions));
+    const float* texCoordData = reinterpret_cast<const float*>(readBuffer(texCoords));
+    outVertices.resize(positions.count);
+    for (size_t i = 0; i < positions.count; i++)
+    {
+        outVertices[i].position = { positionData[i * 3], positionData[i * 3 + 1], positionData[i * 3 + 2] };
+        outVertices[i].texCoord = { texCoordData[i * 2], texCoordData[i * 2 + 1] };
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    RasterOptions options{};
+    std::vector<ReferenceView> views;
+    try
+    {
+        if (!ParseCommandLine(options, argc, argv)) return 1;
+        if (!options.posesPath.empty())
+        {
+            for (const PoseSample& pose : LoadPoseTrace(options.posesPath))
+            {
+                views.push_back(ViewFromPoseSample(pose, options.size, options.size));
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        ShowHelp();
+        return 1;
+    }
+
+    if (options.posesPath.empty())
+    {
+        for (float angle : { 90.f, 60.f, 30.f, 0.f, -45.f })
+        {
+            ReferenceView view{};
+            view.spaceToView = RotationAxis({ 1.f, 0.f, 0.f }, angle * RENDER_PI / 180.f);
+            view.projection = ProjectionFov(-RENDER_PI / 4.f, RENDER_PI / 4.f, RENDER_PI / 4.f, -RENDER_PI / 4.f, 0.05f, 100.f);
+            view.screenWidth = options.size;
+            view.screenHeight = options.size;
+            views.push_back(view);
+        }
+    }
+
+    std::vector<RasterVertex> vertices;
+    std::vector<uint16_t> indices;
+    if (options.meshPath.empty())
+    {
+        CreateUvSphere(256, 125, vertices, indices);
+    }
+    else if (!LoadGlbMesh(options.meshPath, vertices, indices))
+    {
+        return 1;
+    }
+    const RasterMesh mesh{ vertices.data(), vertices.size(), indices.data(), indices.size() };
+
+    MemoryArena textureArena{ "RasterTexture", 4ull * 1024 * 1024 * 1024 };
+    MemoryArena frameArena{ "RasterFrame" };
+    MemoryArena metricArena{ "RasterMetrics" };
+
+    SphereTexture texture{};
+    if (!options.texturePath.empty())
+    {
+        int channelCount;
+        uint8_t* loadedData = stbi_load(options.texturePath.c_str(), &texture.width, &texture.height, &channelCount, 3);
+        if (loadedData == nullptr)
+        {
+            std::cout << options.texturePath << ": " << stbi_failure_reason() << std::endl;
+            return 1;
+        }
+        texture.data = loadedData;
+        texture = PrepareTexture(textureArena, texture, false, options.threadCount).texture;
+        stbi_image_free(loadedData);
+    }
+    else
+    {
+        texture = PrepareTexture(textureArena, CreateCheckerboard(textureArena), false, options.threadCount).texture;
+    }
+
+    // Box filtered mips, like the DDS files of the converter
+    const MipChain chain = GenerateMipChain(textureArena, texture, MipFilter::Box, options.threadCount);
+    const Matrix4 model = { { { EnvironmentScale, 0.f, 0.f, 0.f }, { 0.f, EnvironmentScale, 0.f, 0.f }, { 0.f, 0.f, EnvironmentScale, 0.f }, { 0.f, 0.f, 0.f, 1.f } } };
+
+    RasterSettings settings{};
+    settings.sampling = options.sampling;
+    settings.sampler = options.sampler;
+    settings.threadCount = options.threadCount;
+
+    std::cout << "Mesh: " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles. Sampling "
+              << ShaderSamplingName(options.sampling) << ", " << SamplerFilterName(options.sampler.filter) << " sampler." << std::endl;
+    std::cout << "View  Frame (ms)  Setup  Bin    Shade   Triangles  Binned  SSIM vs ray cast" << std::endl;
+    double totalMilliseconds = 0.;
+    for (size_t viewIndex = 0; viewIndex < views.size(); viewIndex++)
+    {
+        const ReferenceView& view = views[viewIndex];
+        const Matrix4 modelViewProjection = Multiply(Multiply(model, view.spaceToView), view.projection);
+
+        std::vector<uint8_t> frame(view.screenWidth * view.screenHeight * 3);
+        const RasterTarget target{ frame.data(), view.screenWidth, view.screenHeight, view.screenWidth * 3, PixelLayout::RGB };
+        RasterStatistics statistics{};
+        settings.statistics = &statistics;
+
+        double bestMilliseconds = 0.;
+        for (int iteration = 0; iteration < options.iterations; iteration++)
+        {
+            frameArena.Reset();
+            auto measureStart = std::chrono::high_resolution_clock::now();
+            RasterizeMesh(frameArena, mesh, modelViewProjection, chain, target, settings);
+            auto measureEnd = std::chrono::high_resolution_clock::now();
+            const double milliseconds = std::chrono::duration<double, std::milli>(measureEnd - measureStart).count();
+            bestMilliseconds = iteration == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+        }
+        totalMilliseconds += bestMilliseconds;
+
+        frameArena.Reset();
+        const uint8_t* rayCast = RenderPhotoViewer(frameArena, chain, view, options.sampling, options.sampler, options.threadCount);
+
+        // The ray cast starts at the bottom row (clip space y = -1, like the reference renderer), the rasterizer at the
+        // top like a D3D render target
+        const size_t rowSize = view.screenWidth * 3;
+        std::vector<uint8_t> rayCastTopDown(frame.size());
+        for (size_t y = 0; y < view.screenHeight; y++)
+        {
+            std::copy(&rayCast[y * rowSize], &rayCast[(y + 1) * rowSize], &rayCastTopDown[(view.screenHeight - 1 - y) * rowSize]);
+        }
+        metricArena.Reset();
+        MetricSettings metricSettings{};
+        metricSettings.multiScale = false;
+        metricSettings.threadCount = options.threadCount;
+        const int width = static_cast<int>(view.screenWidth);
+        const int height = static_cast<int>(view.screenHeight);
+        const ImageMetrics metrics = CompareImages(metricArena, { width, height, 3, rayCastTopDown.data() }, { width, height, 3, frame.data() }, metricSettings);
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "%4zu  %10.2f  %5.2f  %5.2f  %6.2f  %9zu  %6zu  %.4f", viewIndex, bestMilliseconds, statistics.setupMilliseconds,
+                      statistics.binMilliseconds, statistics.shadeMilliseconds, statistics.setupTriangleCount, statistics.binnedTriangleCount, metrics.ssim);
+        std::cout << line << std::endl;
+
+        if (!options.imagePrefix.empty())
+        {
+            const std::string path = options.imagePrefix + std::to_string(viewIndex) + ".png";
+            if (!stbi_write_png(path.c_str(), width, height, 3, frame.data(), width * 3))
+            {
+                std::cout << "Failed to write " << path << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << "Mean frame time " << totalMilliseconds / views.size() << "ms at " << options.size << "x" << options.size << std::endl;
+    return 0;
+}
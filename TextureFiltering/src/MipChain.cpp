@@ -0,0 +1,206 @@
+#include "MipChain.h"
+
+#include <SphereMapping.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Half width of the Kaiser-windowed sinc in source texels, 6 taps per output texel.
+constexpr int KaiserRadius = 3;
+
+// Shape of the Kaiser window, the value the EquirectConverter uses.
+constexpr float KaiserAlpha = 4.f * RENDER_PI;
+
+const char* MipFilterName(MipFilter filter)
+{
+    switch (filter)
+    {
+    case MipFilter::Point:       return "Point";
+    case MipFilter::Box:         return "Box";
+    case MipFilter::EquirectBox: return "EquirectBox";
+    case MipFilter::Kaiser:      return "Kaiser";
+    }
+    return "Unknown";
+}
+
+// kaiser and bessel functions from
+// https://computergraphics.stackexchange.com/questions/6393/kaiser-windowed-sinc-filter-for-mip-mapping
+static float BesselI0(float x)
+{
+    float r = 1.f;
+    float term = 1.f;
+    for (int k = 1; true; k++)
+    {
+        float f = x / static_cast<float>(k);
+        term *= .25f * f * f;
+        float newR = r + term;
+        if (newR == r) break;
+        r = newR;
+    }
+    return r;
+}
+
+static float KaiserWindow(float x)
+{
+    return BesselI0(KaiserAlpha * std::sqrt(1.f - x * x)) / BesselI0(KaiserAlpha);
+}
+
+// Weights of the source texels 2x - 2 to 2x + 3 for target texel x, normalized.
+static void KaiserWeights(float outWeights[KaiserRadius * 2])
+{
+    float sum = 0.f;
+    for (int tap = 0; tap < KaiserRadius * 2; tap++)
+    {
+        // Distance from the target texel center (between source texels 2x and 2x + 1) in source texels
+        const float distance = static_cast<float>(tap - KaiserRadius) + .5f;
+        const float sincX = RENDER_PI * distance * .5f;
+        outWeights[tap] = std::sin(sincX) / sincX * KaiserWindow(distance / KaiserRadius);
+        sum += outWeights[tap];
+    }
+    for (int tap = 0; tap < KaiserRadius * 2; tap++)
+    {
+        outWeights[tap] /= sum;
+    }
+}
+
+static uint8_t ToTexel(float value)
+{
+    return static_cast<uint8_t>(std::clamp(std::lround(value), 0l, 255l));
+}
+
+static void PointLevel(const MipLevel& source, uint8_t* target, int targetWidth, int targetHeight, int threadCount)
+{
+    RunTiles(targetHeight, threadCount, [&](size_t y, int) {
+        const uint8_t* sourceRow = &source.data[y * 2 * source.width * 3];
+        uint8_t* targetRow = &target[y * targetWidth * 3];
+        for (int x = 0; x < targetWidth; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                targetRow[x * 3 + c] = sourceRow[x * 2 * 3 + c];
+            }
+        }
+    });
+}
+
+static void BoxLevel(const MipLevel& source, uint8_t* target, int targetWidth, int targetHeight, int threadCount)
+{
+    RunTiles(targetHeight, threadCount, [&](size_t y, int) {
+        const uint8_t* top = &source.data[y * 2 * source.width * 3];
+        const uint8_t* bottom = top + source.width * 3;
+        uint8_t* targetRow = &target[y * targetWidth * 3];
+        for (int x = 0; x < targetWidth; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                const int left = x * 2 * 3 + c;
+                targetRow[x * 3 + c] = static_cast<uint8_t>((top[left] + top[left + 3] + bottom[left] + bottom[left + 3]) / 4);
+            }
+        }
+    });
+}
+
+// Same weights as the converter's GenerateEquirectMipLevel: the area of a texel row is the cosine of the latitude at its top edge.
+static void EquirectBoxLevel(MemoryArena& arena, const MipLevel& source, uint8_t* target, int targetWidth, int targetHeight, int threadCount)
+{
+    float* rowAreas = NewArray(arena, float, source.height);
+    float* angles = NewArray(arena, float, source.height);
+    for (int y = 0; y < source.height; y++)
+    {
+        const float phi = (static_cast<float>(y) / static_cast<float>(source.height) * RENDER_PI / 2.f) - RENDER_PI / 4.f;
+        angles[y] = phi * 2.f;
+    }
+    SinCosArray(angles, source.height, nullptr, rowAreas);
+
+    RunTiles(targetHeight, threadCount, [&](size_t y, int) {
+        const uint8_t* top = &source.data[y * 2 * source.width * 3];
+        const uint8_t* bottom = top + source.width * 3;
+        const float topArea = std::abs(rowAreas[y * 2]);
+        const float bottomArea = std::abs(rowAreas[y * 2 + 1]);
+        const float totalArea = topArea * 2.f + bottomArea * 2.f;
+        uint8_t* targetRow = &target[y * targetWidth * 3];
+        for (int x = 0; x < targetWidth; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                const int left = x * 2 * 3 + c;
+                targetRow[x * 3 + c] = static_cast<uint8_t>(top[left] * topArea / totalArea + bottom[left] * bottomArea / totalArea
+                                                            + top[left + 3] * topArea / totalArea + bottom[left + 3] * bottomArea / totalArea);
+            }
+        }
+    });
+}
+
+// Horizontal pass into floats, wrapping around the u seam, then the vertical pass clamped at the poles.
+static void KaiserLevel(MemoryArena& arena, const MipLevel& source, uint8_t* target, int targetWidth, int targetHeight, int threadCount)
+{
+    float weights[KaiserRadius * 2];
+    KaiserWeights(weights);
+
+    float* horizontal = NewArray(arena, float, static_cast<size_t>(targetWidth) * source.height * 3);
+    RunTiles(source.height, threadCount, [&](size_t y, int) {
+        const uint8_t* sourceRow = &source.data[y * source.width * 3];
+        float* row = &horizontal[y * targetWidth * 3];
+        for (int x = 0; x < targetWidth; x++)
+        {
+            float sum[3] = {};
+            for (int tap = 0; tap < KaiserRadius * 2; tap++)
+            {
+                const int sourceX = (x * 2 - KaiserRadius + 1 + tap + source.width) % source.width;
+                for (int c = 0; c < 3; c++)
+                {
+                    sum[c] += weights[tap] * sourceRow[sourceX * 3 + c];
+                }
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                row[x * 3 + c] = sum[c];
+            }
+        }
+    });
+
+    RunTiles(targetHeight, threadCount, [&](size_t y, int) {
+        uint8_t* targetRow = &target[y * targetWidth * 3];
+        for (int x = 0; x < targetWidth * 3; x++)
+        {
+            float sum = 0.f;
+            for (int tap = 0; tap < KaiserRadius * 2; tap++)
+            {
+                const int sourceY = std::clamp(static_cast<int>(y) * 2 - KaiserRadius + 1 + tap, 0, source.height - 1);
+                sum += weights[tap] * horizontal[static_cast<size_t>(sourceY) * targetWidth * 3 + x];
+            }
+            targetRow[x] = ToTexel(sum);
+        }
+    });
+}
+
+MipChain GenerateMipChain(MemoryArena& arena, const SphereTexture& texture, MipFilter filter, int threadCount)
+{
+    MipChain chain{};
+    chain.levels[0] = { texture.width, texture.height, texture.data };
+    chain.levelCount = 1;
+    chain.byteCount = static_cast<size_t>(texture.width) * texture.height * 3;
+
+    while (chain.levelCount < MaxMipLevels)
+    {
+        const MipLevel& source = chain.levels[chain.levelCount - 1];
+        if (source.width < 2 || source.height < 2) break;
+
+        const int targetWidth = source.width / 2;
+        const int targetHeight = source.height / 2;
+        const size_t byteCount = static_cast<size_t>(targetWidth) * targetHeight * 3;
+        uint8_t* target = NewArray(arena, uint8_t, byteCount);
+        switch (filter)
+        {
+        case MipFilter::Point:       PointLevel(source, target, targetWidth, targetHeight, threadCount); break;
+        case MipFilter::Box:         BoxLevel(source, target, targetWidth, targetHeight, threadCount); break;
+        case MipFilter::EquirectBox: EquirectBoxLevel(arena, source, target, targetWidth, targetHeight, threadCount); break;
+        case MipFilter::Kaiser:      KaiserLevel(arena, source, target, targetWidth, targetHeight, threadCount); break;
+        }
+
+        chain.levels[chain.levelCount] = { targetWidth, targetHeight, target };
+        chain.levelCount++;
+        chain.byteCount += byteCount;
+    }
+    return chain;
+}
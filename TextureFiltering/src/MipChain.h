@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../../ReferenceRenderer/src/ReferenceRenderer.h"
+
+#include <cstdint>
+#include <cstddef>
+
+// Mip maps of an equirect texture, built like the EquirectConverter builds the DDS files the viewer loads, but with
+// 3 channels and without writing files. Every level halves the previous one until a side would drop below 1 texel.
+
+enum class MipFilter
+{
+    Point,       // top left texel of every 2x2 block
+    Box,         // unweighted 2x2 average, truncated
+    EquirectBox, // 2x2 average with the rows weighted by the sphere area their texels cover
+    Kaiser,      // Kaiser-windowed sinc, separable, 6 taps per axis
+};
+
+constexpr MipFilter AllMipFilters[] = { MipFilter::Point, MipFilter::Box, MipFilter::EquirectBox, MipFilter::Kaiser };
+
+const char* MipFilterName(MipFilter filter);
+
+constexpr int MaxMipLevels = 16;
+
+struct MipLevel
+{
+    int width = 0;
+    int height = 0;
+    const uint8_t* data = nullptr; // RGB
+};
+
+struct MipChain
+{
+    int levelCount = 0;
+    MipLevel levels[MaxMipLevels];
+
+    // Bytes of all levels together, the GPU memory the chain would take as RGB.
+    size_t byteCount = 0;
+};
+
+// Builds all levels in the arena, level 0 points at the texture data. Rows of a level are filtered in parallel.
+MipChain GenerateMipChain(MemoryArena& arena, const SphereTexture& texture, MipFilter filter, int threadCount = 0);
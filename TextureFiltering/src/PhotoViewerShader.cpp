@@ -0,0 +1,127 @@
+#include "PhotoViewerShader.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Output rows per tile of the shading pass, a multiple of 2 so quads never straddle tiles.
+constexpr size_t ShadeTileRows = 16;
+
+const char* ShaderSamplingName(ShaderSampling sampling)
+{
+    switch (sampling)
+    {
+    case ShaderSampling::Default:  return "Default";
+    case ShaderSampling::Adjusted: return "Adjusted";
+    }
+    return "Unknown";
+}
+
+static float UnwrapU(float du)
+{
+    if (du > .5f) return du - 1.f;
+    if (du < -.5f) return du + 1.f;
+    return du;
+}
+
+TextureGradients QuadGradients(const Vector2* positions, size_t width, size_t height, size_t x, size_t y)
+{
+    // Odd sized screens have a last column or row without a quad partner, it uses the pixel before it
+    const size_t left = std::min(x & ~size_t(1), width - 2);
+    const size_t top = std::min(y & ~size_t(1), height - 2);
+    const Vector2& dxStart = positions[y * width + left];
+    const Vector2& dxEnd = positions[y * width + left + 1];
+    const Vector2& dyStart = positions[top * width + x];
+    const Vector2& dyEnd = positions[(top + 1) * width + x];
+
+    TextureGradients gradients{};
+    gradients.dudx = UnwrapU(dxEnd.x - dxStart.x);
+    gradients.dvdx = dxEnd.y - dxStart.y;
+    gradients.dudy = UnwrapU(dyEnd.x - dyStart.x);
+    gradients.dvdy = dyEnd.y - dyStart.y;
+    return gradients;
+}
+
+TextureGradients ShaderGradients(ShaderSampling sampling, float v, TextureGradients gradients)
+{
+    if (sampling == ShaderSampling::Adjusted)
+    {
+        // The texture is stretched along u by 1 / cos(latitude) compared to the sphere surface
+        const float latitude = v * RENDER_PI - RENDER_PI / 2.f;
+        const float circumferenceRatioToNoDistortion = 1.f / std::cos(latitude);
+        gradients.dudx *= circumferenceRatioToNoDistortion;
+        gradients.dudy *= circumferenceRatioToNoDistortion;
+    }
+    return gradients;
+}
+
+void PushShadePixel(const MipChain& chain, const SamplerDesc& sampler, PixelLayout layout, ShadeBatch& batch, uint8_t* target, float u, float v, const TextureGradients& gradients)
+{
+    batch.targets[batch.count] = target;
+    batch.u[batch.count] = u;
+    batch.v[batch.count] = v;
+    batch.dudx[batch.count] = gradients.dudx;
+    batch.dvdx[batch.count] = gradients.dvdx;
+    batch.dudy[batch.count] = gradients.dudy;
+    batch.dvdy[batch.count] = gradients.dvdy;
+    if (++batch.count == ShadeBatchPixels) FlushShadeBatch(chain, sampler, layout, batch);
+}
+
+void FlushShadeBatch(const MipChain& chain, const SamplerDesc& sampler, PixelLayout layout, ShadeBatch& batch)
+{
+    SampleGradBatch(chain, sampler, batch.count, batch.u, batch.v, batch.dudx, batch.dvdx, batch.dudy, batch.dvdy, batch.colors);
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        uint8_t color[3];
+        for (int c = 0; c < 3; c++)
+        {
+            color[c] = static_cast<uint8_t>(std::clamp(batch.colors[i * 3 + c] + .5f, 0.f, 255.f));
+        }
+
+        // Pixels pushed twice (overdraw) are written in push order, the last one wins like on the GPU
+        uint8_t* target = batch.targets[i];
+        const bool swapRedBlue = layout == PixelLayout::BGRA;
+        target[0] = color[swapRedBlue ? 2 : 0];
+        target[1] = color[1];
+        target[2] = color[swapRedBlue ? 0 : 2];
+        if (layout != PixelLayout::RGB) target[3] = 255;
+    }
+    batch.count = 0;
+}
+
+uint8_t* RenderPhotoViewer(MemoryArena& arena, const MipChain& chain, const ReferenceView& view, ShaderSampling sampling, const SamplerDesc& sampler, int threadCount)
+{
+    const size_t width = view.screenWidth;
+    const size_t height = view.screenHeight;
+    const Vector2* positions = CreateScreenTexturePositions(arena, view, threadCount);
+    uint8_t* image = NewArray(arena, uint8_t, width * height * 3);
+
+    const size_t tileCount = (height + ShadeTileRows - 1) / ShadeTileRows;
+    RunTiles(tileCount, threadCount, [&](size_t tile, int) {
+        ShadeBatch batch;
+        for (size_t top = tile * ShadeTileRows; top < std::min(height, (tile + 1) * ShadeTileRows); top += 2)
+        {
+            for (size_t left = 0; left < width; left += 2)
+            {
+                for (size_t corner = 0; corner < 4; corner++)
+                {
+                    const size_t x = left + (corner & 1);
+                    const size_t y = top + (corner >> 1);
+                    if (x >= width || y >= height) continue;
+
+                    const size_t pixel = y * width + x;
+                    const Vector2& position = positions[pixel];
+                    const TextureGradients gradients = ShaderGradients(sampling, position.y, QuadGradients(positions, width, height, x, y));
+                    if (std::isnan(position.x) || std::isnan(gradients.dudx + gradients.dvdx + gradients.dudy + gradients.dvdy))
+                    {
+                        image[pixel * 3] = image[pixel * 3 + 1] = image[pixel * 3 + 2] = 0;
+                        continue;
+                    }
+
+                    PushShadePixel(chain, sampler, PixelLayout::RGB, batch, &image[pixel * 3], position.x, position.y, gradients);
+                }
+            }
+        }
+        if (batch.count > 0) FlushShadeBatch(chain, sampler, PixelLayout::RGB, batch);
+    });
+    return image;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "TextureSampler.h"
+
+// MainPS of OpenXRViewer/shaders/photoviewer.hlsl on the CPU, for comparing its sampling paths without a GPU.
+
+enum class ShaderSampling
+{
+    Default,  // tex.Sample, gradients from the pixel quad
+    Adjusted, // tex.SampleGrad with the u gradients divided by the cosine of the latitude
+};
+
+constexpr ShaderSampling AllShaderSamplings[] = { ShaderSampling::Default, ShaderSampling::Adjusted };
+
+const char* ShaderSamplingName(ShaderSampling sampling);
+
+// Gradients of the pixel at (x, y) from the texture positions of its 2x2 quad, like ddx_fine / ddy_fine. Differences
+// across the u seam are unwrapped, the viewer's sphere mesh interpolates u continuously inside every triangle.
+TextureGradients QuadGradients(const Vector2* positions, size_t width, size_t height, size_t x, size_t y);
+
+// Gradients the shader passes to SampleGrad for the sampling mode.
+TextureGradients ShaderGradients(ShaderSampling sampling, float v, TextureGradients gradients);
+
+// Pixels per SampleGradBatch call of the shading passes, 16 quads.
+constexpr size_t ShadeBatchPixels = 64;
+
+// Channel order of the images the shading passes write.
+enum class PixelLayout
+{
+    RGB,
+    RGBA,
+    BGRA,
+};
+
+// Pixels collected for one SampleGradBatch call, quad by quad.
+struct ShadeBatch
+{
+    size_t count = 0;
+    uint8_t* targets[ShadeBatchPixels]; // first byte of the output pixel
+    float u[ShadeBatchPixels];
+    float v[ShadeBatchPixels];
+    float dudx[ShadeBatchPixels];
+    float dvdx[ShadeBatchPixels];
+    float dudy[ShadeBatchPixels];
+    float dvdy[ShadeBatchPixels];
+    float colors[ShadeBatchPixels * 3];
+};
+
+// Adds a pixel with the gradients MainPS passes to the sampler, shades the batch once it is full.
+void PushShadePixel(const MipChain& chain, const SamplerDesc& sampler, PixelLayout layout, ShadeBatch& batch, uint8_t* target, float u, float v, const TextureGradients& gradients);
+
+// Samples the pixels of the batch, writes them and empties it. Alpha is written as 255.
+void FlushShadeBatch(const MipChain& chain, const SamplerDesc& sampler, PixelLayout layout, ShadeBatch& batch);
+
+// Shades every pixel of the view from the mip chain with the given sampler, quad by quad. Returns screenWidth *
+// screenHeight RGB pixels allocated in the arena, in the same order as CreatePerfectFilteredImage. Pixels that miss the
+// sphere stay black.
+uint8_t* RenderPhotoViewer(MemoryArena& arena, const MipChain& chain, const ReferenceView& view, ShaderSampling sampling, const SamplerDesc& sampler = ViewerSampler, int threadCount = 0);
@@ -0,0 +1,374 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Clip space x and y are clipped at +-GuardBand * w instead of +-w. Triangles reaching up to half a screen past the
+// edges are rasterized directly, which keeps the clipper out of the way for almost every triangle.
+constexpr float GuardBand = 2.f;
+
+// 6 planes add at most one vertex each, the clipped polygon is drawn as a fan.
+constexpr int MaxClippedVertices = 3 + 6;
+constexpr int MaxClippedTriangles = MaxClippedVertices - 2;
+
+// Snapped screen positions have 8 fraction bits like D3D requires, edge functions are then exact in 64 bit integers
+// and neighboring triangles never both cover (or both miss) a pixel on their shared edge.
+constexpr int SubpixelBits = 8;
+constexpr int64_t SubpixelScale = int64_t(1) << SubpixelBits;
+constexpr int64_t SubpixelHalf = SubpixelScale / 2;
+
+// Mesh triangles per setup task.
+constexpr size_t SetupChunkTriangles = 1024;
+
+struct ClipVertex
+{
+    float x, y, z, w;
+    float u, v;
+};
+
+// One screen triangle after clipping and culling.
+struct RasterTriangle
+{
+    int64_t x[3];
+    int64_t y[3];
+    int64_t edgeBias[3]; // 0 for top and left edges, -1 for the others
+    float inverseArea;
+    float z[3];          // depth, z / w
+    float inverseW[3];
+    float uOverW[3];
+    float vOverW[3];
+    int minX, minY, maxX, maxY; // pixels whose center can be covered, clamped to the target
+};
+
+static float PlaneDistance(const ClipVertex& vertex, int plane)
+{
+    switch (plane)
+    {
+    case 0:  return vertex.z;                          // near, D3D clips at z = 0
+    case 1:  return vertex.w - vertex.z;               // far
+    case 2:  return GuardBand * vertex.w + vertex.x;   // left
+    case 3:  return GuardBand * vertex.w - vertex.x;   // right
+    case 4:  return GuardBand * vertex.w + vertex.y;   // bottom
+    default: return GuardBand * vertex.w - vertex.y;   // top
+    }
+}
+
+static ClipVertex Lerp(const ClipVertex& a, const ClipVertex& b, float t)
+{
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t, a.u + (b.u - a.u) * t, a.v + (b.v - a.v) * t };
+}
+
+// Sutherland-Hodgman against all planes, returns the vertex count of the remaining polygon (0 if nothing is left).
+static int ClipPolygon(ClipVertex (&polygon)[MaxClippedVertices], int vertexCount)
+{
+    ClipVertex clipped[MaxClippedVertices];
+    for (int plane = 0; plane < 6 && vertexCount > 0; plane++)
+    {
+        int clippedCount = 0;
+        for (int i = 0; i < vertexCount; i++)
+        {
+            const ClipVertex& current = polygon[i];
+            const ClipVertex& next = polygon[(i + 1) % vertexCount];
+            const float currentDistance = PlaneDistance(current, plane);
+            const float nextDistance = PlaneDistance(next, plane);
+            if (currentDistance >= 0.f) clipped[clippedCount++] = current;
+            if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+            {
+                clipped[clippedCount++] = Lerp(current, next, currentDistance / (currentDistance - nextDistance));
+            }
+        }
+        std::copy(clipped, clipped + clippedCount, polygon);
+        vertexCount = clippedCount;
+    }
+    return vertexCount;
+}
+
+static int64_t EdgeFunction(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t px, int64_t py)
+{
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Clips, projects and culls one mesh triangle. Writes up to MaxClippedTriangles triangles and returns their count.
+static int SetupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const RasterTarget& target, RasterTriangle* outTriangles)
+{
+    ClipVertex polygon[MaxClippedVertices] = { a, b, c };
+    int vertexCount = 3;
+
+    // Triangles completely inside skip the clipper
+    bool inside = true;
+    for (int plane = 0; plane < 6 && inside; plane++)
+    {
+        inside = PlaneDistance(a, plane) >= 0.f && PlaneDistance(b, plane) >= 0.f && PlaneDistance(c, plane) >= 0.f;
+    }
+    if (!inside) vertexCount = ClipPolygon(polygon, vertexCount);
+    if (vertexCount < 3) return 0;
+
+    // Viewport transform, y points down
+    struct ScreenVertex { int64_t x, y; float z, inverseW, uOverW, vOverW; };
+    ScreenVertex screen[MaxClippedVertices];
+    const float width = static_cast<float>(target.width);
+    const float height = static_cast<float>(target.height);
+    for (int i = 0; i < vertexCount; i++)
+    {
+        const float inverseW = 1.f / polygon[i].w;
+        const float screenX = (polygon[i].x * inverseW * .5f + .5f) * width;
+        const float screenY = (.5f - polygon[i].y * inverseW * .5f) * height;
+        screen[i].x = std::llround(screenX * SubpixelScale);
+        screen[i].y = std::llround(screenY * SubpixelScale);
+        screen[i].z = polygon[i].z * inverseW;
+        screen[i].inverseW = inverseW;
+        screen[i].uOverW = polygon[i].u * inverseW;
+        screen[i].vOverW = polygon[i].v * inverseW;
+    }
+
+    int triangleCount = 0;
+    for (int i = 1; i + 1 < vertexCount; i++)
+    {
+        const ScreenVertex* vertices[3] = { &screen[0], &screen[i], &screen[i + 1] };
+
+        // Clockwise triangles on screen are front faces, everything else is culled (CullMode BACK)
+        const int64_t area = EdgeFunction(vertices[0]->x, vertices[0]->y, vertices[1]->x, vertices[1]->y, vertices[2]->x, vertices[2]->y);
+        if (area <= 0) continue;
+
+        RasterTriangle& triangle = outTriangles[triangleCount];
+        int64_t minX = INT64_MAX, minY = INT64_MAX, maxX = INT64_MIN, maxY = INT64_MIN;
+        for (int v = 0; v < 3; v++)
+        {
+            triangle.x[v] = vertices[v]->x;
+            triangle.y[v] = vertices[v]->y;
+            triangle.z[v] = vertices[v]->z;
+            triangle.inverseW[v] = vertices[v]->inverseW;
+            triangle.uOverW[v] = vertices[v]->uOverW;
+            triangle.vOverW[v] = vertices[v]->vOverW;
+            minX = std::min(minX, triangle.x[v]);
+            minY = std::min(minY, triangle.y[v]);
+            maxX = std::max(maxX, triangle.x[v]);
+            maxY = std::max(maxY, triangle.y[v]);
+        }
+
+        // Edge v is the one opposite vertex v. Top edges run right, left edges run up (clockwise winding, y down).
+        for (int v = 0; v < 3; v++)
+        {
+            const int start = (v + 1) % 3;
+            const int end = (v + 2) % 3;
+            const int64_t dx = triangle.x[end] - triangle.x[start];
+            const int64_t dy = triangle.y[end] - triangle.y[start];
+            const bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+            triangle.edgeBias[v] = topLeft ? 0 : -1;
+        }
+        triangle.inverseArea = 1.f / static_cast<float>(area);
+
+        // Pixel centers are at (pixel + 0.5)
+        auto firstPixel = [](int64_t position) { return static_cast<int>((position - SubpixelHalf + SubpixelScale - 1) >> SubpixelBits); };
+        auto lastPixel = [](int64_t position) { return static_cast<int>((position - SubpixelHalf) >> SubpixelBits); };
+        triangle.minX = std::max(firstPixel(minX), 0);
+        triangle.minY = std::max(firstPixel(minY), 0);
+        triangle.maxX = std::min(lastPixel(maxX), static_cast<int>(target.width) - 1);
+        triangle.maxY = std::min(lastPixel(maxY), static_cast<int>(target.height) - 1);
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;
+
+        triangleCount++;
+    }
+    return triangleCount;
+}
+
+// Rasterizes and shades the binned triangles of one tile, in submission order.
+static void RasterizeTile(const RasterTriangle* triangles, const uint32_t* bin, size_t binSize, int tileX, int tileY,
+                          const MipChain& chain, const RasterTarget& target, const RasterSettings& settings)
+{
+    const int endX = std::min(tileX + RasterTileSize, static_cast<int>(target.width));
+    const int endY = std::min(tileY + RasterTileSize, static_cast<int>(target.height));
+    const size_t pixelSize = target.layout == PixelLayout::RGB ? 3 : 4;
+
+    uint8_t clearColor[4] = { settings.clearColor[0], settings.clearColor[1], settings.clearColor[2], settings.clearColor[3] };
+    if (target.layout == PixelLayout::BGRA) std::swap(clearColor[0], clearColor[2]);
+    float depth[RasterTileSize * RasterTileSize];
+    std::fill(std::begin(depth), std::end(depth), 1.f);
+    for (int y = tileY; y < endY; y++)
+    {
+        uint8_t* row = target.pixels + y * target.rowPitch;
+        for (int x = tileX; x < endX; x++)
+        {
+            std::copy(clearColor, clearColor + pixelSize, &row[x * pixelSize]);
+        }
+    }
+
+    ShadeBatch batch;
+    for (size_t binIndex = 0; binIndex < binSize; binIndex++)
+    {
+        const RasterTriangle& triangle = triangles[bin[binIndex]];
+        const int startX = std::max(tileX, triangle.minX) & ~1;
+        const int startY = std::max(tileY, triangle.minY) & ~1;
+        const int lastX = std::min(endX - 1, triangle.maxX);
+        const int lastY = std::min(endY - 1, triangle.maxY);
+
+        for (int quadY = startY; quadY <= lastY; quadY += 2)
+        {
+            for (int quadX = startX; quadX <= lastX; quadX += 2)
+            {
+                // Lanes in quad order: top left, top right, bottom left, bottom right
+                bool covered[4];
+                bool anyCovered = false;
+                float u[4], v[4], z[4];
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    const int x = quadX + (lane & 1);
+                    const int y = quadY + (lane >> 1);
+                    const int64_t px = (int64_t(x) << SubpixelBits) + SubpixelHalf;
+                    const int64_t py = (int64_t(y) << SubpixelBits) + SubpixelHalf;
+
+                    int64_t edges[3];
+                    covered[lane] = x < endX && y < endY;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        const int start = (e + 1) % 3;
+                        const int end = (e + 2) % 3;
+                        edges[e] = EdgeFunction(triangle.x[start], triangle.y[start], triangle.x[end], triangle.y[end], px, py);
+                        covered[lane] = covered[lane] && edges[e] + triangle.edgeBias[e] >= 0;
+                    }
+                    anyCovered = anyCovered || covered[lane];
+
+                    // Helper lanes outside the triangle extrapolate the attributes, like the GPU does for derivatives
+                    float inverseW = 0.f, uOverW = 0.f, vOverW = 0.f;
+                    z[lane] = 0.f;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        const float weight = static_cast<float>(edges[e]) * triangle.inverseArea;
+                        inverseW += weight * triangle.inverseW[e];
+                        uOverW += weight * triangle.uOverW[e];
+                        vOverW += weight * triangle.vOverW[e];
+                        z[lane] += weight * triangle.z[e];
+                    }
+                    u[lane] = uOverW / inverseW;
+                    v[lane] = vOverW / inverseW;
+                }
+                if (!anyCovered) continue;
+
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    if (!covered[lane]) continue;
+                    const int x = quadX + (lane & 1);
+                    const int y = quadY + (lane >> 1);
+                    float& storedDepth = depth[(y - tileY) * RasterTileSize + (x - tileX)];
+                    if (!(z[lane] < storedDepth)) continue;
+                    storedDepth = z[lane];
+
+                    // ddx_fine within the lane's row, ddy_fine within its column
+                    const int rowStart = lane & 2;
+                    const int column = lane & 1;
+                    TextureGradients gradients{};
+                    gradients.dudx = u[rowStart + 1] - u[rowStart];
+                    gradients.dvdx = v[rowStart + 1] - v[rowStart];
+                    gradients.dudy = u[column + 2] - u[column];
+                    gradients.dvdy = v[column + 2] - v[column];
+                    gradients = ShaderGradients(settings.sampling, v[lane], gradients);
+
+                    uint8_t* pixel = target.pixels + y * target.rowPitch + x * pixelSize;
+                    PushShadePixel(chain, settings.sampler, target.layout, batch, pixel, u[lane], v[lane], gradients);
+                }
+            }
+        }
+    }
+    if (batch.count > 0) FlushShadeBatch(chain, settings.sampler, target.layout, batch);
+}
+
+void RasterizeMesh(MemoryArena& arena, const RasterMesh& mesh, const Matrix4& modelViewProjection, const MipChain& chain, const RasterTarget& target, const RasterSettings& settings)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const auto setupStart = Clock::now();
+
+    // Vertex shader
+    ClipVertex* clipVertices = NewArray(arena, ClipVertex, mesh.vertexCount);
+    const SimdMath::Mat4 matrix = ToMat4(modelViewProjection);
+    const size_t vertexChunkCount = (mesh.vertexCount + SetupChunkTriangles - 1) / SetupChunkTriangles;
+    RunTiles(vertexChunkCount, settings.threadCount, [&](size_t chunk, int) {
+        const size_t end = std::min(mesh.vertexCount, (chunk + 1) * SetupChunkTriangles);
+        for (size_t i = chunk * SetupChunkTriangles; i < end; i++)
+        {
+            const RasterVertex& vertex = mesh.vertices[i];
+            float clip[4];
+            SimdMath::StoreVec4(clip, SimdMath::Transform(ToVec4(vertex.position, 1.f), matrix));
+            clipVertices[i] = { clip[0], clip[1], clip[2], clip[3], vertex.texCoord.x, vertex.texCoord.y };
+        }
+    });
+
+    // Triangle setup runs twice per chunk, first to count the triangles left after clipping and culling and then to
+    // write them at their final offset. Setup is cheap next to shading, and the triangle array needs no slack.
+    const size_t meshTriangleCount = mesh.indexCount / 3;
+    const size_t chunkCount = (meshTriangleCount + SetupChunkTriangles - 1) / SetupChunkTriangles;
+    size_t* chunkOffsets = NewArray(arena, size_t, chunkCount + 1);
+    auto setupChunk = [&](size_t chunk, RasterTriangle* outTriangles) {
+        RasterTriangle scratch[MaxClippedTriangles];
+        size_t count = 0;
+        const size_t end = std::min(meshTriangleCount, (chunk + 1) * SetupChunkTriangles);
+        for (size_t i = chunk * SetupChunkTriangles; i < end; i++)
+        {
+            const uint16_t* indices = &mesh.indices[i * 3];
+            RasterTriangle* output = outTriangles ? &outTriangles[count] : scratch;
+            count += SetupTriangle(clipVertices[indices[0]], clipVertices[indices[1]], clipVertices[indices[2]], target, output);
+        }
+        return count;
+    };
+    RunTiles(chunkCount, settings.threadCount, [&](size_t chunk, int) { chunkOffsets[chunk + 1] = setupChunk(chunk, nullptr); });
+    for (size_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+    }
+    const size_t triangleCount = chunkOffsets[chunkCount];
+    RasterTriangle* triangles = static_cast<RasterTriangle*>(arena.Allocate(sizeof(RasterTriangle) * triangleCount));
+    RunTiles(chunkCount, settings.threadCount, [&](size_t chunk, int) { setupChunk(chunk, &triangles[chunkOffsets[chunk]]); });
+    const auto binStart = Clock::now();
+
+    // Binning, counts per tile first so every bin is one contiguous range
+    const int tileCountX = static_cast<int>((target.width + RasterTileSize - 1) / RasterTileSize);
+    const int tileCountY = static_cast<int>((target.height + RasterTileSize - 1) / RasterTileSize);
+    const size_t tileCount = static_cast<size_t>(tileCountX) * tileCountY;
+    size_t* binOffsets = NewArray(arena, size_t, tileCount + 1);
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        for (int tileY = triangles[i].minY / RasterTileSize; tileY <= triangles[i].maxY / RasterTileSize; tileY++)
+        {
+            for (int tileX = triangles[i].minX / RasterTileSize; tileX <= triangles[i].maxX / RasterTileSize; tileX++)
+            {
+                binOffsets[tileY * tileCountX + tileX + 1]++;
+            }
+        }
+    }
+    for (size_t tile = 0; tile < tileCount; tile++)
+    {
+        binOffsets[tile + 1] += binOffsets[tile];
+    }
+    const size_t binnedTriangleCount = binOffsets[tileCount];
+    uint32_t* bins = static_cast<uint32_t*>(arena.Allocate(sizeof(uint32_t) * binnedTriangleCount));
+    size_t* binFill = NewArray(arena, size_t, tileCount);
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        for (int tileY = triangles[i].minY / RasterTileSize; tileY <= triangles[i].maxY / RasterTileSize; tileY++)
+        {
+            for (int tileX = triangles[i].minX / RasterTileSize; tileX <= triangles[i].maxX / RasterTileSize; tileX++)
+            {
+                const size_t tile = tileY * tileCountX + tileX;
+                bins[binOffsets[tile] + binFill[tile]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+    const auto shadeStart = Clock::now();
+
+    RunTiles(tileCount, settings.threadCount, [&](size_t tile, int) {
+        const int tileX = static_cast<int>(tile % tileCountX) * RasterTileSize;
+        const int tileY = static_cast<int>(tile / tileCountX) * RasterTileSize;
+        RasterizeTile(triangles, &bins[binOffsets[tile]], binOffsets[tile + 1] - binOffsets[tile], tileX, tileY, chain, target, settings);
+    }, settings.statistics ? &settings.statistics->shading : nullptr);
+
+    if (settings.statistics)
+    {
+        const auto shadeEnd = Clock::now();
+        settings.statistics->triangleCount = meshTriangleCount;
+        settings.statistics->setupTriangleCount = triangleCount;
+        settings.statistics->binnedTriangleCount = binnedTriangleCount;
+        settings.statistics->setupMilliseconds = std::chrono::duration<double, std::milli>(binStart - setupStart).count();
+        settings.statistics->binMilliseconds = std::chrono::duration<double, std::milli>(shadeStart - binStart).count();
+        settings.statistics->shadeMilliseconds = std::chrono::duration<double, std::milli>(shadeEnd - shadeStart).count();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "PhotoViewerShader.h"
+
+// The viewer's environment pass without a GPU: transforms an indexed triangle mesh, clips it like D3D does (depth clip
+// enabled), culls back faces (clockwise front faces, CullMode BACK) and rasterizes it with a LESS depth test and the top
+// left fill rule. Pixels are shaded quad by quad with MainPS of photoviewer.hlsl (PhotoViewerShader.h), gradients come
+// from the 2x2 quads like ddx_fine / ddy_fine, helper pixels included.
+//
+// Triangles are binned into screen tiles after setup, tiles are rasterized and shaded in parallel. Every tile keeps
+// the submission order of its triangles, so results do not depend on the thread count.
+
+// Screen tile size in pixels, even so quads never straddle tiles.
+constexpr int RasterTileSize = 32;
+
+struct RasterVertex
+{
+    Vector3 position{};
+    Vector2 texCoord{};
+};
+
+struct RasterMesh
+{
+    const RasterVertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    const uint16_t* indices = nullptr; // triangle list
+    size_t indexCount = 0;
+};
+
+// 8 bit color target, a view port of a larger image can be addressed through pixels and rowPitch.
+struct RasterTarget
+{
+    uint8_t* pixels = nullptr;
+    size_t width = 0;
+    size_t height = 0;
+    size_t rowPitch = 0; // bytes
+    PixelLayout layout = PixelLayout::RGBA;
+};
+
+struct RasterStatistics
+{
+    size_t triangleCount = 0;      // of the mesh
+    size_t setupTriangleCount = 0; // after clipping and culling
+    size_t binnedTriangleCount = 0; // triangle references over all tiles
+    double setupMilliseconds = 0.;
+    double binMilliseconds = 0.;
+    double shadeMilliseconds = 0.;
+    SchedulerStatistics shading;
+};
+
+struct RasterSettings
+{
+    ShaderSampling sampling = ShaderSampling::Default;
+    SamplerDesc sampler = ViewerSampler;
+    uint8_t clearColor[4] = { 0, 0, 0, 255 }; // RGBA, also for BGRA targets
+
+    // Worker threads, 0 uses one per hardware thread.
+    int threadCount = 0;
+
+    // Optional, receives triangle counts and the time of every stage.
+    RasterStatistics* statistics = nullptr;
+};
+
+// Clears the target and draws the mesh into it. modelViewProjection maps model space to D3D clip space with row
+// vectors (model * spaceToView * projection). Temporary buffers are allocated in the arena.
+void RasterizeMesh(MemoryArena& arena, const RasterMesh& mesh, const Matrix4& modelViewProjection, const MipChain& chain, const RasterTarget& target, const RasterSettings& settings = {});
@@ -0,0 +1,245 @@
+#include "TextureSampler.h"
+
+#include <SimdMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace SimdMath;
+
+// D3D requires at least 8 bits of fraction for texel weights and the blend between mip levels, GPUs use exactly that.
+constexpr float FilterPrecision = 256.f;
+
+const char* SamplerFilterName(SamplerFilter filter)
+{
+    switch (filter)
+    {
+    case SamplerFilter::Trilinear:   return "Trilinear";
+    case SamplerFilter::Anisotropic: return "Anisotropic";
+    }
+    return "Unknown";
+}
+
+static float QuantizeWeight(float weight)
+{
+    return std::floor(weight * FilterPrecision) / FilterPrecision;
+}
+
+static FloatV QuantizeWeight(FloatV weight)
+{
+    return Floor(weight * Set(FilterPrecision)) / Set(FilterPrecision);
+}
+
+// index and size hold whole numbers, the result is the index wrapped into [0, size).
+static FloatV WrapIndex(FloatV index, FloatV size)
+{
+    return index - Floor(index / size) * size;
+}
+
+// Bilinear lookup of Width probes, every lane in its own level given by levels, width and height. Texel centers are at
+// (x + 0.5) / width. Adds the color times weight to outColor, lanes with a zero weight skip the texel fetches. The
+// fetches are gathers from 8 bit RGB rows and run lane by lane, the addresses, weights and blends run in FloatV lanes.
+static void AccumulateBilinear(const MipLevel* const levels[Width], FloatV width, FloatV height, FloatV u, FloatV v, FloatV weight, FloatV outColor[3])
+{
+    const FloatV x = u * width - Set(.5f);
+    const FloatV y = v * height - Set(.5f);
+    const FloatV x0 = Floor(x);
+    const FloatV y0 = Floor(y);
+    const FloatV fx = QuantizeWeight(x - x0);
+    const FloatV fy = QuantizeWeight(y - y0);
+
+    const FloatV left = WrapIndex(x0, width);
+    const FloatV top = WrapIndex(y0, height);
+    const FloatV right = Select(left + Set(1.f) < width, left + Set(1.f), Set(0.f));
+    const FloatV bottom = Select(top + Set(1.f) < height, top + Set(1.f), Set(0.f));
+
+    float lanes[5][Width];
+    Store(lanes[0], left);
+    Store(lanes[1], right);
+    Store(lanes[2], top);
+    Store(lanes[3], bottom);
+    Store(lanes[4], weight);
+
+    // Top left, top right, bottom left and bottom right texel of every lane, channel by channel
+    float texels[4][3][Width] = {};
+    for (size_t lane = 0; lane < Width; lane++)
+    {
+        if (lanes[4][lane] == 0.f) continue;
+
+        const MipLevel& level = *levels[lane];
+        const size_t leftOffset = static_cast<size_t>(lanes[0][lane]) * 3;
+        const size_t rightOffset = static_cast<size_t>(lanes[1][lane]) * 3;
+        const uint8_t* topRow = &level.data[static_cast<size_t>(lanes[2][lane]) * level.width * 3];
+        const uint8_t* bottomRow = &level.data[static_cast<size_t>(lanes[3][lane]) * level.width * 3];
+        for (int c = 0; c < 3; c++)
+        {
+            texels[0][c][lane] = topRow[leftOffset + c];
+            texels[1][c][lane] = topRow[rightOffset + c];
+            texels[2][c][lane] = bottomRow[leftOffset + c];
+            texels[3][c][lane] = bottomRow[rightOffset + c];
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        const FloatV topLeft = Load(texels[0][c]);
+        const FloatV bottomLeft = Load(texels[2][c]);
+        const FloatV upper = topLeft + (Load(texels[1][c]) - topLeft) * fx;
+        const FloatV lower = bottomLeft + (Load(texels[3][c]) - bottomLeft) * fx;
+        outColor[c] = outColor[c] + (upper + (lower - upper) * fy) * weight;
+    }
+}
+
+// Footprints of Width pixels. The longer gradient in texels of level 0 selects the LOD. Anisotropic filtering takes
+// ceil(longer / shorter) probes (at most maxAnisotropy) spaced along the longer gradient and picks the LOD for the
+// longer gradient divided by the probe count, the footprint of one probe.
+struct FootprintV
+{
+    FloatV lodLength;
+    FloatV probeCount;
+    FloatV stepU;
+    FloatV stepV;
+};
+
+static FootprintV ComputeFootprints(const MipChain& chain, const SamplerDesc& sampler, FloatV dudx, FloatV dvdx, FloatV dudy, FloatV dvdy)
+{
+    const FloatV width = Set(static_cast<float>(chain.levels[0].width));
+    const FloatV height = Set(static_cast<float>(chain.levels[0].height));
+    const FloatV texelsXU = dudx * width;
+    const FloatV texelsXV = dvdx * height;
+    const FloatV texelsYU = dudy * width;
+    const FloatV texelsYV = dvdy * height;
+    const FloatV lengthX = Sqrt(MulAdd(texelsXU, texelsXU, texelsXV * texelsXV));
+    const FloatV lengthY = Sqrt(MulAdd(texelsYU, texelsYU, texelsYV * texelsYV));
+    const MaskV yLonger = lengthY > lengthX;
+    const FloatV longer = Max(lengthX, lengthY);
+
+    FootprintV footprint{};
+    const FloatV one = Set(1.f);
+    if (sampler.filter == SamplerFilter::Trilinear || sampler.maxAnisotropy <= 1)
+    {
+        footprint.lodLength = longer;
+        footprint.probeCount = one;
+        footprint.stepU = Set(0.f);
+        footprint.stepV = Set(0.f);
+        return footprint;
+    }
+
+    // A zero shorter gradient gives an infinite ratio, clamped to the maximum. Both zero gives 0 / 0, which min and the
+    // rounding treat differently per backend (SSE picks the maximum, NEON keeps the NaN), so that case is set to a
+    // single probe explicitly.
+    const FloatV maxAnisotropy = Set(static_cast<float>(std::min(sampler.maxAnisotropy, 16)));
+    const FloatV ratio = Min(longer / Min(lengthX, lengthY), maxAnisotropy);
+    FloatV probeCount = ToFloat(RoundToInt(ratio));
+    probeCount = Select(probeCount < ratio, probeCount + one, probeCount);
+    probeCount = Select(probeCount < one, one, probeCount);
+    probeCount = Select(longer > Set(0.f), probeCount, one);
+
+    footprint.lodLength = longer / probeCount;
+    footprint.probeCount = probeCount;
+    footprint.stepU = Select(yLonger, dudy, dudx) / probeCount;
+    footprint.stepV = Select(yLonger, dvdy, dvdx) / probeCount;
+    return footprint;
+}
+
+static float LodFromLength(float length)
+{
+    return length > 0.f ? std::log2(length) : -std::numeric_limits<float>::infinity();
+}
+
+float ComputeLod(const MipChain& chain, const SamplerDesc& sampler, const TextureGradients& gradients, int* outProbeCount)
+{
+    const FootprintV footprint = ComputeFootprints(chain, sampler, Set(gradients.dudx), Set(gradients.dvdx), Set(gradients.dudy), Set(gradients.dvdy));
+    float lodLength[Width];
+    float probeCount[Width];
+    Store(lodLength, footprint.lodLength);
+    Store(probeCount, footprint.probeCount);
+    if (outProbeCount) *outProbeCount = static_cast<int>(probeCount[0]);
+    return LodFromLength(lodLength[0]);
+}
+
+void SampleGrad(const MipChain& chain, const SamplerDesc& sampler, float u, float v, const TextureGradients& gradients, float outColor[3])
+{
+    SampleGradBatch(chain, sampler, 1, &u, &v, &gradients.dudx, &gradients.dvdx, &gradients.dudy, &gradients.dvdy, outColor);
+}
+
+void SampleGradBatch(const MipChain& chain, const SamplerDesc& sampler, size_t count, const float* u, const float* v,
+                     const float* dudx, const float* dvdx, const float* dudy, const float* dvdy, float* outColors)
+{
+    const FloatV zero = Set(0.f);
+    const FloatV one = Set(1.f);
+    for (size_t start = 0; start < count; start += Width)
+    {
+        const size_t laneCount = std::min(Width, count - start);
+
+        // The last chunk is padded with zero gradients and positions
+        float padded[6][Width] = {};
+        const float* inputs[6] = { dudx + start, dvdx + start, dudy + start, dvdy + start, u + start, v + start };
+        if (laneCount < Width)
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                std::copy(inputs[i], inputs[i] + laneCount, padded[i]);
+                inputs[i] = padded[i];
+            }
+        }
+
+        const FootprintV footprint = ComputeFootprints(chain, sampler, Load(inputs[0]), Load(inputs[1]), Load(inputs[2]), Load(inputs[3]));
+        float lodLength[Width];
+        float probeCount[Width];
+        Store(lodLength, footprint.lodLength);
+        Store(probeCount, footprint.probeCount);
+
+        // LOD and mip blend per pixel, log2 has no SimdMath version
+        const MipLevel* lowerLevels[Width];
+        const MipLevel* upperLevels[Width];
+        float levelSizes[4][Width];
+        float blends[Width];
+        int maxProbeCount = 1;
+        for (size_t lane = 0; lane < Width; lane++)
+        {
+            float lod = LodFromLength(lodLength[lane]) + sampler.mipLodBias;
+            lod = std::clamp(lod, sampler.minLod, sampler.maxLod);
+            lod = std::clamp(lod, 0.f, static_cast<float>(chain.levelCount - 1));
+            const int level = static_cast<int>(lod);
+            blends[lane] = QuantizeWeight(lod - static_cast<float>(level));
+
+            // The last level always has a blend of 0, the upper level is only read with a nonzero blend
+            lowerLevels[lane] = &chain.levels[level];
+            upperLevels[lane] = &chain.levels[std::min(level + 1, chain.levelCount - 1)];
+            levelSizes[0][lane] = static_cast<float>(lowerLevels[lane]->width);
+            levelSizes[1][lane] = static_cast<float>(lowerLevels[lane]->height);
+            levelSizes[2][lane] = static_cast<float>(upperLevels[lane]->width);
+            levelSizes[3][lane] = static_cast<float>(upperLevels[lane]->height);
+            if (lane < laneCount) maxProbeCount = std::max(maxProbeCount, static_cast<int>(probeCount[lane]));
+        }
+
+        // Probes along the footprint, spaced one step apart around the pixel position. Lanes past their probe count
+        // and padding lanes get a zero weight.
+        const FloatV blend = Load(blends);
+        const MaskV padding = LaneIndex() > Set(static_cast<float>(laneCount) - 1.f);
+        const FloatV probeWeight = Select(padding, zero, one / footprint.probeCount);
+        const FloatV lowerWeight = probeWeight * (one - blend);
+        const FloatV upperWeight = Select(blend > zero, probeWeight * blend, zero);
+        const FloatV firstOffset = Set(-.5f) * (footprint.probeCount - one);
+        FloatV color[3] = { zero, zero, zero };
+        for (int probe = 0; probe < maxProbeCount; probe++)
+        {
+            const FloatV probeIndex = Set(static_cast<float>(probe));
+            const MaskV active = probeIndex < footprint.probeCount;
+            const FloatV offset = firstOffset + probeIndex;
+            const FloatV probeU = Load(inputs[4]) + footprint.stepU * offset;
+            const FloatV probeV = Load(inputs[5]) + footprint.stepV * offset;
+            AccumulateBilinear(lowerLevels, Load(levelSizes[0]), Load(levelSizes[1]), probeU, probeV, Select(active, lowerWeight, zero), color);
+            AccumulateBilinear(upperLevels, Load(levelSizes[2]), Load(levelSizes[3]), probeU, probeV, Select(active, upperWeight, zero), color);
+        }
+
+        float colors[3][Width];
+        for (int c = 0; c < 3; c++) Store(colors[c], color[c]);
+        for (size_t lane = 0; lane < laneCount; lane++)
+        {
+            for (int c = 0; c < 3; c++) outColors[(start + lane) * 3 + c] = colors[c][lane];
+        }
+    }
+}
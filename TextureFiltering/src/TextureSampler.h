@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MipChain.h"
+
+// CPU stand-in for the viewer's texture sampler, following the D3D filtering rules: wrap addressing on both axes, the
+// LOD picked from explicit gradients, 8 bits of subtexel and mip blend precision. Sample in a shader is SampleGrad with
+// the gradients of the pixel quad, QuadGradients in PhotoViewerShader.h provides those.
+
+enum class SamplerFilter
+{
+    Trilinear,   // D3D12_FILTER_MIN_MAG_MIP_LINEAR, LOD from the longer gradient
+    Anisotropic, // D3D12_FILTER_ANISOTROPIC, up to maxAnisotropy trilinear probes along the longer gradient
+};
+
+constexpr SamplerFilter AllSamplerFilters[] = { SamplerFilter::Trilinear, SamplerFilter::Anisotropic };
+
+const char* SamplerFilterName(SamplerFilter filter);
+
+// The fields of D3D12_SAMPLER_DESC that matter for a 2D color texture with wrap addressing.
+struct SamplerDesc
+{
+    SamplerFilter filter = SamplerFilter::Anisotropic;
+    int maxAnisotropy = 16; // 1 - 16
+    float mipLodBias = 0.f;
+    float minLod = 0.f;
+    float maxLod = 3.402823466e+38f;
+};
+
+// texSampler of the viewer's root signature (graphicsplugin_custom.cpp)
+constexpr SamplerDesc ViewerSampler{};
+
+struct TextureGradients
+{
+    float dudx = 0.f;
+    float dvdx = 0.f;
+    float dudy = 0.f;
+    float dvdy = 0.f;
+};
+
+// LOD of the gradients before bias and clamping, -infinity for zero gradients. Anisotropic filtering divides the longer
+// gradient by the probe count first, which is returned in outProbeCount (1 for trilinear).
+float ComputeLod(const MipChain& chain, const SamplerDesc& sampler, const TextureGradients& gradients, int* outProbeCount = nullptr);
+
+// Filtered RGB color (0 - 255) at texture position u, v (0 - 1).
+void SampleGrad(const MipChain& chain, const SamplerDesc& sampler, float u, float v, const TextureGradients& gradients, float outColor[3]);
+
+// SampleGrad for count pixels given as structure of arrays, outColors receives count RGB colors. Footprints, probe
+// positions, texel addresses, bilinear weights and the mip blend run SimdMath::Width pixels at a time; only the LOD
+// (log2) and the texel fetches are per pixel. Callers put the 4 pixels of a quad next to each other like a GPU shades
+// them, pixels with fewer anisotropic probes than their neighbours idle through the extra ones.
+// Results are identical to SampleGrad.
+void SampleGradBatch(const MipChain& chain, const SamplerDesc& sampler, size_t count, const float* u, const float* v,
+                     const float* dudx, const float* dvdx, const float* dudy, const float* dvdy, float* outColors);